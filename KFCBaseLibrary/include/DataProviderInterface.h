@@ -7,6 +7,7 @@
 #include <Arduino_compat.h>
 #include <BufferStream.h>
 #include <StreamString.h>
+#include <stl_ext/inplace_function.h>
 
 #ifndef DEBUG_DATA_PROVIDER_INTERFACE
 #define DEBUG_DATA_PROVIDER_INTERFACE                    0
@@ -21,7 +22,7 @@
 class DataProviderInterface
 {
 public:
-    typedef std::function<size_t(uint8_t *data, size_t size)> FillBufferCallback;
+    typedef stdex::inplace_function<size_t(uint8_t *data, size_t size)> FillBufferCallback;
     typedef std::function<bool(const String &name, DataProviderInterface &provider)> ResolveCallback;
 
     DataProviderInterface(ResolveCallback callback) : _fillBuffer(), _callback(callback), _handled(false) {
@@ -56,14 +56,14 @@ public:
     virtual int read() {
         if (_available) {
             _available--;
-            return *_dataPtr++;
+            return static_cast<uint8_t>(*_dataPtr++);
         }
         return -1;
     }
 
     virtual int peek() {
         if (_available) {
-            return *_dataPtr;
+            return static_cast<uint8_t>(*_dataPtr);
         }
         return -1;
     }
@@ -0,0 +1,141 @@
+/**
+  Author: sascha_lammers@gmx.de
+*/
+
+// Host example for Event::Coroutine
+//
+// a coroutine connects to a simulated server, sends a request, parses the response and retries with an increasing
+// delay if any step fails. a second coroutine blinks a LED with a repeating timer until the request has finished.
+// the simulated clock advances to the next timer expiration after each main loop iteration
+//
+// requires EVENT_SCHEDULER_SIMULATED_CLOCK=1
+//
+// usage: coroutine
+
+#include <Arduino_compat.h>
+#include <EventScheduler.h>
+#include <SimulatedClock.h>
+#include <stdio.h>
+
+#if !EVENT_SCHEDULER_SIMULATED_CLOCK
+#    error EVENT_SCHEDULER_SIMULATED_CLOCK=1 required
+#endif
+
+using namespace Event;
+
+// asynchronous client that reports the result of each operation with a completion flag
+class Client {
+public:
+    // the first two connection attempts fail
+    void connect(Completion &done) {
+        _finish(done, 250, ++_attempts > 2);
+    }
+
+    void request(Completion &done) {
+        _finish(done, 400, true);
+    }
+
+    bool isSuccess() const {
+        return _success;
+    }
+
+    const char *getResponse() const {
+        return "{\"temperature\":21.5}";
+    }
+
+private:
+    void _finish(Completion &done, uint32_t delay, bool success) {
+        done.reset();
+        _Scheduler.add(delay, false, [this, &done, success](CallbackTimerPtr) {
+            _success = success;
+            done.complete();
+        });
+    }
+
+    uint32_t _attempts = 0;
+    bool _success = false;
+};
+
+static void log(const char *message)
+{
+    printf("%6.3fs %s\n", SimulatedClock::getMicros64() / 1000000.0, message);
+}
+
+class Fetch : public Coroutine {
+public:
+    Fetch(Client &client, Completion &finished) : _client(client), _finished(finished) {}
+
+protected:
+    StateType resume() override {
+        CO_BEGIN();
+        for(_retryDelay = 500; _retryDelay <= 8000; _retryDelay *= 2) {
+            log("connecting");
+            _client.connect(_done);
+            CO_AWAIT(_done);
+            if (_client.isSuccess()) {
+                log("sending request");
+                _client.request(_done);
+                CO_AWAIT(_done);
+                if (_client.isSuccess()) {
+                    printf("%6.3fs response %s\n", SimulatedClock::getMicros64() / 1000000.0, _client.getResponse());
+                    _finished.complete();
+                    CO_RETURN();
+                }
+            }
+            printf("%6.3fs failed, retrying in %ums\n", SimulatedClock::getMicros64() / 1000000.0, _retryDelay);
+            CO_DELAY(_retryDelay);
+        }
+        log("giving up");
+        _finished.complete();
+        CO_END();
+    }
+
+private:
+    Client &_client;
+    Completion &_finished;
+    Completion _done;
+    uint32_t _retryDelay;
+};
+
+class Blink : public Coroutine {
+public:
+    Blink(Completion &finished) : _finished(finished) {}
+
+protected:
+    StateType resume() override {
+        CO_BEGIN();
+        for(_state = false; !_finished.isDone(); _state = !_state) {
+            log(_state ? "LED on" : "LED off");
+            CO_AWAIT_TIMER(1000);
+        }
+        log("LED off");
+        CO_END();
+    }
+
+private:
+    Completion &_finished;
+    bool _state;
+};
+
+int main()
+{
+    SimulatedClock::reset();
+
+    Client client;
+    Completion finished;
+    Coroutine::start<Fetch>(client, finished);
+    Coroutine::start<Blink>(finished);
+
+    while(Coroutine::size()) {
+        Scheduler::run();
+        LoopFunctions::run();
+        if (!Coroutine::isReady() && !SimulatedClock::step()) {
+            break;
+        }
+    }
+
+    auto stats = Coroutine::getPoolStats();
+    printf("coroutines=%u pool peak=%u chunks=%u frame_size=%u\n", static_cast<unsigned>(Coroutine::size()), stats.peak, stats.chunks, static_cast<unsigned>(Coroutine::kFrameSize));
+    _Scheduler.end();
+    return 0;
+}
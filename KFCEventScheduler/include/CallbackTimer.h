@@ -6,7 +6,12 @@
 
 #include "Event.h"
 #include "OSTimer.h"
+#include "SlabPool.h"
+#if EVENT_SCHEDULER_PROFILER
+#    include "SchedulerProfiler.h"
+#endif
 #include <Arduino_compat.h>
+#include <atomic>
 
 #if DEBUG_EVENT_SCHEDULER
 #    include <debug_helper_enable.h>
@@ -32,10 +37,24 @@ namespace Event {
     private:
         ~CallbackTimer();
 
+    public:
+        // CallbackTimer objects are allocated from a slab pool to avoid heap fragmentation by short lived timers
+        static void *operator new(size_t size);
+        static void operator delete(void *ptr, size_t size);
+
+        static SlabPoolStats getPoolStats();
+
+#if EVENT_SCHEDULER_PROFILER
+        const TimerProfile &getProfile() const;
+#endif
+
     public:
         bool isArmed() const;
         int64_t getInterval() const;
 
+        // handle that can be stored instead of the pointer. see Scheduler::getTimer()
+        TimerHandle getHandle() const;
+
         // make sure the delay does not exceed UINT32_MAX
         uint32_t getShortInterval() const;
 
@@ -52,6 +71,13 @@ namespace Event {
 
         void rearm(milliseconds interval, RepeatType repeat = RepeatType(), Callback callback = nullptr);
 
+        // allow the timer to be delayed up to slackMillis to align it with other timers and reduce wakeups
+        // the expiration is rounded down to a multiple of the largest power of 2 that does not exceed slackMillis
+        // timers with overlapping windows are aligned to the same expiration and executed in one batch
+        // the timer is restarted
+        void setSlack(uint32_t slackMillis);
+        uint32_t getSlack() const;
+
         // disarm timer inside callback
         // once exiting the callback it is being removed
         void disarm();
@@ -64,7 +90,15 @@ namespace Event {
         friend Scheduler;
 
         void _rearm();
+        // arm the next interval of a repeating timer with slack
+        void _rearmCoalesced();
+        // delay until the aligned expiration of _slackDue
+        uint32_t _getCoalescedDelay() const;
         void _disarm();
+        // set the deadline to delay milliseconds from now
+        void _setDeadline(uint64_t delay);
+        // subtract the time the system clock has been stopped and rearm the OS timer. requires _lock
+        void _fastForward(uint32_t sleptMillis, uint64_t now);
         void _invokeCallback(CallbackTimerPtr timer);
         uint32_t _runtimeLimit(PriorityType priority) const;
         // release manager timer without removing the timer it manages
@@ -74,21 +108,40 @@ namespace Event {
         int64_t __getRemainingDelayMillis() const;
 
     public:
+        static constexpr uint16_t kNoDeadlineIndex = std::numeric_limits<uint16_t>::max();
+
         ETSTimerEx _etsTimer;
         SemaphoreMutex _lock;
         Callback _callback;
         Timer *_timer;
+        CallbackTimer *_readyPrev;          // ready list of the scheduler
+        CallbackTimer *_readyNext;
+        CallbackTimer *_pendingNext;        // pending list of the scheduler, written by the timer context
         int64_t _delay;
 #if SCHEDULER_HAVE_REMAINING_DELAY
         uint32_t _remainingDelay;
 #endif
         RepeatType _repeat;
         PriorityType _priority;
+        TimerHandle _handle;                // key in Scheduler::_timers
+        uint16_t _deadlineIndex;            // position in Scheduler::_deadlines, kNoDeadlineIndex if not armed
+        uint64_t _deadline;                 // millis64() of the next expiration, protected by Scheduler::_deadlineLock
+        uint32_t _slack;                    // milliseconds
+        uint32_t _slackDue;                 // millis() of the next expiration without slack
 #if SCHEDULER_HAVE_REMAINING_DELAY
         bool _maxDelayExceeded;
 #endif
-        bool _callbackScheduled;
+        std::atomic_bool _callbackScheduled;    // set by the timer context, cleared by the main loop or _disarm()
         bool _insideCallback;
+        bool _readyQueued;
+        bool _coalesced;                    // repeating timer with slack, the OS timer is armed for each interval
+        bool _removed;                      // removed, deleted by the main loop after the timer context has left the callback
+        std::atomic_bool _pending;          // set by the timer context if queued in the pending list
+        bool _throttled;                    // set by Timer::throttle(), disarmed after the callback has been invoked
+#if EVENT_SCHEDULER_PROFILER
+        uint32_t _triggeredMicros;          // micros() when the OS timer was triggered
+        TimerProfile _profile;
+#endif
 
 #if DEBUG_EVENT_SCHEDULER
         uint32_t _line;
@@ -109,6 +162,20 @@ namespace Event {
         return _etsTimer.isRunning();
     }
 
+#if EVENT_SCHEDULER_PROFILER
+
+    inline const TimerProfile &CallbackTimer::getProfile() const
+    {
+        return _profile;
+    }
+
+#endif
+
+    inline TimerHandle CallbackTimer::getHandle() const
+    {
+        return _handle;
+    }
+
     inline int64_t CallbackTimer::getInterval() const
     {
         return _delay;
@@ -137,7 +204,7 @@ namespace Event {
     inline int64_t CallbackTimer::__getRemainingDelayMillis() const
     {
 #if SCHEDULER_HAVE_REMAINING_DELAY
-        return (_remainingDelay == 0) ? 0 : ((_remainingDelay == 1) ? (_delay % kMaxDelay) : ((_remainingDelay - 1) * static_cast<int64_t>(kMaxDelay)));
+        return (_remainingDelay == 0) ? 0 : (((_remainingDelay - 1) * static_cast<int64_t>(kMaxDelay)) + (_delay % kMaxDelay));
 #else
         return _delay;
 #endif
@@ -154,6 +221,7 @@ namespace Event {
         EVENT_SCHEDULER_ASSERT(_repeat._repeat != RepeatType::kPreset);
         if (callback) {
             _callback = callback;
+            _throttled = false;
         }
         __LDBG_printf("rearm=%.0f timer=%p repeat=%d cb=%p %s:%u", delay / 1.0, this, _repeat._repeat, lambda_target(_callback), __S(_file), _line);
         _rearm();
@@ -170,22 +238,20 @@ namespace Event {
         _disarm();
     }
 
-    inline SemaphoreMutex &CallbackTimer::getLock()
+    inline void CallbackTimer::setSlack(uint32_t slackMillis)
     {
-        return _lock;
+        _slack = slackMillis;
+        rearm(_delay);
     }
 
-    inline void CallbackTimer::_disarm()
+    inline uint32_t CallbackTimer::getSlack() const
     {
-        __LDBG_printf("timer=%p armed=%u cb=%p %s:%u", this, isArmed(), lambda_target(_callback), __S(_file), _line);
-        if (isArmed()) {
-            _etsTimer.disarm();
-        }
-#if SCHEDULER_HAVE_REMAINING_DELAY
-        _remainingDelay = 0;
-        _maxDelayExceeded = false;
-#endif
-        _callbackScheduled = false;
+        return _slack;
+    }
+
+    inline SemaphoreMutex &CallbackTimer::getLock()
+    {
+        return _lock;
     }
 
 }
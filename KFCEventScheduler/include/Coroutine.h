@@ -0,0 +1,207 @@
+/**
+  Author: sascha_lammers@gmx.de
+*/
+
+#pragma once
+
+#include <Arduino_compat.h>
+#include "Event.h"
+#include "Timer.h"
+#include "SlabPool.h"
+
+#ifndef _MSC_VER
+#    pragma GCC push_options
+#    pragma GCC optimize("O3")
+#endif
+
+// max. size of a coroutine object in byte including all members of the derived class
+#ifndef EVENT_SCHEDULER_COROUTINE_FRAME_SIZE
+#    define EVENT_SCHEDULER_COROUTINE_FRAME_SIZE (sizeof(void *) * 32)
+#endif
+
+// number of coroutine frames allocated at once by the coroutine pool
+#ifndef EVENT_SCHEDULER_COROUTINE_POOL_CHUNK_SIZE
+#    define EVENT_SCHEDULER_COROUTINE_POOL_CHUNK_SIZE 4
+#endif
+
+// stackless coroutines for Event::Coroutine::resume()
+//
+// local variables do not survive a suspension and must be members of the class. CO_BEGIN() and CO_END() must
+// enclose the entire body and switch statements cannot be used across a suspension point
+//
+// CO_YIELD()               continue with the next main loop iteration
+// CO_DELAY(ms)             continue after a delay
+// CO_AWAIT_TIMER(ms)       continue with the next expiration of a repeating timer. the timer is started with the
+//                          first call and keeps running until another delay is awaited or the coroutine ends.
+//                          expirations that occur while the coroutine is busy are counted and not lost
+// CO_AWAIT(completion)     continue after Completion::complete() has been called
+// CO_AWAIT_UNTIL(cond)     check the condition once per main loop iteration and continue when it is true
+// CO_RETURN()              end the coroutine
+#define CO_BEGIN()                  switch(_line) { case 0:
+#define CO_END()                    } _line = 0; return Event::Coroutine::StateType::DONE;
+#define CO_RETURN()                 do { _line = 0; return Event::Coroutine::StateType::DONE; } while(0)
+#define __CO_SUSPEND()              _line = __LINE__; return Event::Coroutine::StateType::WAITING; case __LINE__:
+#define __CO_SUSPEND_UNTIL(ready)   _line = __LINE__; case __LINE__: if (!(ready)) { return Event::Coroutine::StateType::WAITING; }
+#define CO_YIELD()                  do { _awaitLoop(); __CO_SUSPEND(); } while(0)
+#define CO_DELAY(ms)                do { _awaitDelay(ms); __CO_SUSPEND(); } while(0)
+#define CO_AWAIT_TIMER(ms)          do { __CO_SUSPEND_UNTIL(_awaitTimer(ms)); } while(0)
+#define CO_AWAIT(completion)        do { __CO_SUSPEND_UNTIL(_awaitCompletion(completion)); } while(0)
+#define CO_AWAIT_UNTIL(cond)        do { __CO_SUSPEND_UNTIL((cond) || (_awaitLoop(), false)); } while(0)
+
+namespace Event {
+
+    class Coroutine;
+
+    // flag to signal the completion of an operation to a waiting coroutine
+    //
+    // complete() must be called from the main loop. use LoopFunctions::callOnce() for other contexts. the flag
+    // stays set until reset() is called. the object must exist until the waiting coroutine has been resumed
+    class Completion {
+    public:
+        Completion() : _waiter(nullptr), _done(false) {}
+        ~Completion();
+
+        Completion(const Completion &) = delete;
+        Completion &operator=(const Completion &) = delete;
+
+        void complete();
+
+        void reset() {
+            _done = false;
+        }
+
+        bool isDone() const {
+            return _done;
+        }
+
+    private:
+        friend Coroutine;
+
+        Coroutine *_waiter;
+        bool _done;
+    };
+
+    // cooperative task executed by the main loop
+    //
+    // derived classes implement resume() with the CO_* macros. the objects are allocated from a pool with a
+    // fixed frame size and deleted after resume() has returned StateType::DONE. coroutines waiting for a timer
+    // or completion do not consume any time in the main loop
+    //
+    // class Blink : public Event::Coroutine {
+    //     StateType resume() override {
+    //         CO_BEGIN();
+    //         for(_count = 0; _count < 10; _count++) {
+    //             digitalWrite(LED_BUILTIN, _count % 2);
+    //             CO_AWAIT_TIMER(500);
+    //         }
+    //         CO_END();
+    //     }
+    //     uint8_t _count;
+    // };
+    //
+    // Event::Coroutine::start<Blink>();
+    class Coroutine {
+    public:
+        static constexpr size_t kFrameSize = EVENT_SCHEDULER_COROUTINE_FRAME_SIZE;
+
+        enum class StateType : uint8_t {
+            WAITING,
+            DONE,
+        };
+
+        enum class WaitType : uint8_t {
+            NONE,
+            LOOP,
+            DELAY,
+            TIMER,
+            COMPLETION,
+        };
+
+        Coroutine(const Coroutine &) = delete;
+        Coroutine &operator=(const Coroutine &) = delete;
+
+        // create a coroutine that is resumed the first time by the next main loop iteration
+        // the pointer is valid until the coroutine has ended or has been cancelled
+        template<typename _Ta, typename... _Args>
+        static _Ta *start(_Args&&... args) {
+            static_assert(sizeof(_Ta) <= kFrameSize, "coroutine exceeds EVENT_SCHEDULER_COROUTINE_FRAME_SIZE");
+            auto coroutine = new _Ta(std::forward<_Args>(args)...);
+            coroutine->_setReady();
+            return coroutine;
+        }
+
+        // end the coroutine without resuming it. the object is deleted immediately unless it is being resumed or
+        // is scheduled to be resumed
+        void cancel();
+
+        WaitType getWaitType() const {
+            return _wait;
+        }
+
+        // resume all coroutines that are ready. installed as loop function while any coroutine exists
+        static void run();
+
+        // number of coroutines that have not ended
+        static size_t size();
+
+        // returns true if any coroutine waits to be resumed by the next main loop iteration
+        static bool isReady();
+
+        static SlabPoolStats getPoolStats();
+
+        static void *operator new(size_t size);
+        static void operator delete(void *ptr, size_t size);
+
+    protected:
+        // priority of the timers used by CO_DELAY() and CO_AWAIT_TIMER(). PriorityType::TIMER is not supported
+        Coroutine(PriorityType priority = PriorityType::NORMAL);
+        virtual ~Coroutine();
+
+        virtual StateType resume() = 0;
+
+        void _awaitLoop();
+        void _awaitDelay(uint32_t delayMillis);
+        bool _awaitTimer(uint32_t intervalMillis);
+        bool _awaitCompletion(Completion &completion);
+
+    protected:
+        uint16_t _line;                 // resume position
+
+    private:
+        friend Completion;
+
+        void _setReady();
+        void _detach();
+
+    private:
+        Timer _timer;
+        Completion *_completion;
+        Coroutine *_readyNext;
+        uint32_t _interval;             // interval of the repeating timer or 0
+        uint16_t _ticks;                // expirations of the repeating timer not awaited yet
+        PriorityType _priority;
+        WaitType _wait;
+        bool _ready;
+        bool _cancelled;
+
+        static Coroutine *_readyHead;
+        static Coroutine *_readyTail;
+        static Coroutine *_current;
+        static size_t _count;
+    };
+
+    inline size_t Coroutine::size()
+    {
+        return _count;
+    }
+
+    inline bool Coroutine::isReady()
+    {
+        return _readyHead != nullptr;
+    }
+
+}
+
+#ifndef _MSC_VER
+#    pragma GCC pop_options
+#endif
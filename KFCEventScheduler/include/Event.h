@@ -8,6 +8,8 @@
 #include <chrono>
 #include <time.h>
 #include <Mutex.h>
+#include <stl_ext/inplace_function.h>
+#include <stl_ext/slot_map.h>
 
 #ifndef _MSC_VER
 #    pragma GCC push_options
@@ -30,6 +32,26 @@
 #    define DEBUG_EVENT_SCHEDULER_RUNTIME_LIMIT_CONSTEXPR 1
 #endif
 
+// capacity of Event::Callback in byte. lambdas with captures that exceed the capacity do not compile
+#ifndef EVENT_SCHEDULER_CALLBACK_CAPACITY
+#    define EVENT_SCHEDULER_CALLBACK_CAPACITY stdex::kInplaceFunctionDefaultCapacity
+#endif
+
+// number of CallbackTimer objects allocated at once by the timer pool
+#ifndef EVENT_SCHEDULER_TIMER_POOL_CHUNK_SIZE
+#    define EVENT_SCHEDULER_TIMER_POOL_CHUNK_SIZE 8
+#endif
+
+// record runtime statistics of each timer and the main loop. see SchedulerProfiler.h
+#ifndef EVENT_SCHEDULER_PROFILER
+#    define EVENT_SCHEDULER_PROFILER 0
+#endif
+
+// host builds only. replace the OS timers and the system time with a virtual clock. see SimulatedClock.h
+#ifndef EVENT_SCHEDULER_SIMULATED_CLOCK
+#    define EVENT_SCHEDULER_SIMULATED_CLOCK 0
+#endif
+
 #ifndef EVENT_SCHEDULER_ASSERT
 // #define EVENT_SCHEDULER_ASSERT(cond)                    assert(cond)
 #    define EVENT_SCHEDULER_ASSERT(cond) __LDBG_assert(cond)
@@ -100,6 +122,13 @@ namespace Event {
     class Scheduler;
     class ManagedCallbackTimer;
 
+    #if EVENT_SCHEDULER_SIMULATED_CLOCK
+        // hides ::millis(), ::micros() and ::millis64() inside the Event namespace
+        uint32_t millis();
+        uint32_t micros();
+        uint64_t millis64();
+    #endif
+
     #if ESP32
         using OSTimerDelayType = int64_t;
     #else
@@ -122,13 +151,20 @@ namespace Event {
     static constexpr uint64_t kMaxDelaySeconds = kMaxDelayMillis / 1000;
     static constexpr uint64_t kMaxDelayInDays  = kMaxDelaySeconds / 86400;
 
+    // returned by Scheduler::getNextDeadline() if no timer is armed
+    static constexpr uint32_t kNoDeadline = std::numeric_limits<uint32_t>::max();
+
     // ESP8266 for "os_timer_arm"
     // - if system_timer_reinit has been called, the timer value allowed range from 100 to 0x689D0.
     // - if didn’t call system_timer_reinit has NOT been called, the timer value allowed range from 5 to 0x68D7A3.
 
     using CallbackTimerPtr = CallbackTimer *;
-    using TimerVector = std::vector<CallbackTimerPtr>;
-    using Callback = std::function<void(CallbackTimerPtr timer)>;
+    // timers of the scheduler, the key of a timer is its handle. the generation has 32 bit, a timer that is
+    // added and removed repeatedly reuses the same slot
+    using TimerVector = stdex::slot_map<CallbackTimerPtr, uint16_t, uint32_t>;
+    // compact reference to a timer. the handle of a removed timer does not match any timer added later
+    using TimerHandle = TimerVector::key_type;
+    using Callback = stdex::inplace_function<void(CallbackTimerPtr timer), EVENT_SCHEDULER_CALLBACK_CAPACITY>;
 
     using milliseconds = std::chrono::duration<int64_t, std::ratio<1>>;
 
@@ -11,4 +11,6 @@
 #include "OSTimer.h"
 #include "LoopFunctions.h"
 #include "WiFiCallbacks.h"
+#include "SleepPlanner.h"
+#include "Coroutine.h"
 
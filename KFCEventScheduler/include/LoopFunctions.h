@@ -19,16 +19,60 @@
 #    include <EventScheduler.h>
 #endif
 #include <functional>
+#include <unordered_map>
 #include <vector>
+#include <stl_ext/inplace_function.h>
+#include <stl_ext/mpsc_ring_buffer.h>
+#include <stl_ext/slot_map.h>
 
 #ifndef _MSC_VER
 #    pragma GCC push_options
 #    pragma GCC optimize("O3")
 #endif
 
+// capacity of LoopFunctions::Callback in byte
+#ifndef LOOP_FUNCTIONS_CALLBACK_CAPACITY
+#    define LOOP_FUNCTIONS_CALLBACK_CAPACITY stdex::kInplaceFunctionDefaultCapacity
+#endif
+
+// record the runtime of each loop function to identify slow ones
+#ifndef LOOP_FUNCTIONS_PROFILER
+#    define LOOP_FUNCTIONS_PROFILER 0
+#endif
+
+// max. number of functions passed to LoopFunctions::callOnce(CallbackPtr) that are retried by run() if
+// schedule_function() failed. must be a power of 2
+#ifndef LOOP_FUNCTIONS_CALL_ONCE_RETRY_SIZE
+#    define LOOP_FUNCTIONS_CALL_ONCE_RETRY_SIZE 4
+#endif
+
 #if defined(ESP32) || defined(_MSC_VER)
-bool IRAM_ATTR schedule_function(const std::function<void(void)> &fn);
+
+// max. number of functions scheduled with schedule_function() before run_scheduled_functions() is called. must be a power of 2
+#ifndef SCHEDULED_FN_MAX_COUNT
+#    define SCHEDULED_FN_MAX_COUNT 32
+#endif
+
+// capacity of ScheduledFunction in byte
+#ifndef SCHEDULED_FN_CALLBACK_CAPACITY
+#    define SCHEDULED_FN_CALLBACK_CAPACITY stdex::kInplaceFunctionDefaultCapacity
+#endif
+
+using ScheduledFunction = stdex::inplace_function<void(void), SCHEDULED_FN_CALLBACK_CAPACITY>;
+using ScheduledFunctionQueue = stdex::mpsc_ring_buffer<ScheduledFunction, SCHEDULED_FN_MAX_COUNT>;
+
+// can be called from any context including interrupts and timers. the callable object must not allocate memory
+// when being moved, a std::function can only be passed from the main loop. returns false if the queue is full
+bool IRAM_ATTR schedule_function(ScheduledFunction fn);
 void run_scheduled_functions();
+
+// number of functions that have been dropped because the queue was full
+uint32_t get_scheduled_functions_overflows();
+
+#else
+
+using ScheduledFunction = std::function<void(void)>;
+
 #endif
 
 #if DEBUG_LOOP_FUNCTIONS
@@ -43,13 +87,25 @@ void run_scheduled_functions();
 #    define LOOP_FUNCTIONS_DEBUG_ARGS_PASS
 #endif
 
+// functions executed once per main loop iteration by LoopFunctions::run()
+//
+// the functions are stored in a slot map and indexed by their id. add() and remove() are O(1). remove() marks the
+// entry with deleteCallback, it is not executed anymore and erased after the pass of run() or by cleanUp().
+// functions added during run() are executed in the next pass. the order of execution is not preserved when
+// functions are removed
+//
+// a main loop that iterates getVector() itself must skip entries with deleteCallback set and call cleanUp() after
+// the loop. the entries are read only, erasing them would leave the index pointing to removed entries
 class LoopFunctions {
 public:
     class Entry;
 
-    using Callback = std::function<void(void)>;
+    using Callback = stdex::inplace_function<void(void), LOOP_FUNCTIONS_CALLBACK_CAPACITY>;
     using CallbackPtr = void(*)(void);
-    using FunctionsVector = std::vector<Entry>;
+    using FunctionsMap = stdex::slot_map<Entry, uint16_t>;
+    using FunctionsVector = FunctionsMap;
+    using KeyType = FunctionsMap::key_type;
+    using IndexMap = std::unordered_map<CallbackPtr, KeyType>;
 
     struct CallbackId {
         constexpr CallbackId() : _id(nullptr) {}
@@ -63,11 +119,11 @@ public:
         }
 
         operator uint32_t() const {
-            return reinterpret_cast<uint32_t>(_id);
+            return static_cast<uint32_t>(reinterpret_cast<uintptr_t>(_id));
         }
 
         operator int32_t() const {
-            return reinterpret_cast<int32_t>(_id);
+            return static_cast<int32_t>(reinterpret_cast<intptr_t>(_id));
         }
 
         bool operator==(const void *value) const {
@@ -90,6 +146,29 @@ public:
         const void *_id;
     };
 
+    #if LOOP_FUNCTIONS_PROFILER
+        // runtime in microseconds
+        struct Profile {
+            uint32_t calls;
+            uint32_t maxRuntime;
+            uint64_t totalRuntime;
+
+            Profile() : calls(0), maxRuntime(0), totalRuntime(0) {}
+
+            void add(uint32_t runtime) {
+                calls++;
+                totalRuntime += runtime;
+                if (runtime > maxRuntime) {
+                    maxRuntime = runtime;
+                }
+            }
+
+            uint32_t getAvgRuntime() const {
+                return calls ? static_cast<uint32_t>(totalRuntime / calls) : 0;
+            }
+        };
+    #endif
+
     class Entry {
     public:
         Entry(Callback pCallback, CallbackPtr pCallbackPtr, bool pDeleteCallback) : callback(pCallback), callbackPtr(pCallbackPtr), deleteCallback(pDeleteCallback) {}
@@ -104,18 +183,18 @@ public:
 
         Callback callback;
         CallbackPtr callbackPtr;
-        bool deleteCallback;
+        bool deleteCallback;            // removed during run(), the entry is erased after the pass
 
         #if DEBUG_LOOP_FUNCTIONS
             String _source;
             uint32_t _line;
         #endif
+        #if LOOP_FUNCTIONS_PROFILER
+            Profile _profile;
+        #endif
     };
 
-    inline __attribute__((__always_inline__))
-    static void clear() {
-        _functions.clear();
-    }
+    static void clear();
 
     static void add(Callback callback, CallbackPtr callbackPtr LOOP_FUNCTIONS_DEBUG_ARGS);  // for lambda functions, use any unique pointer as id
 
@@ -129,64 +208,76 @@ public:
         add(callbackPtr, callbackPtr LOOP_FUNCTIONS_DEBUG_ARGS_PASS);
     }
 
-    inline __attribute__((__always_inline__))
-    static void remove(CallbackPtr callbackPtr) {
-        auto iterator = std::find(_functions.begin(), _functions.end(), callbackPtr);
-        if (iterator != _functions.end()) {
-            iterator->deleteCallback = true;
-        }
-    }
+    static void remove(CallbackPtr callbackPtr);
 
     inline __attribute__((__always_inline__))
     static void remove(CallbackId id) {
         remove(static_cast<CallbackPtr>(id));
     }
 
+    // number of functions that will be executed in the next pass
     inline __attribute__((__always_inline__))
     static size_t size() {
-        return std::count_if(_functions.begin(), _functions.end(), [](const Entry &entry) { return entry.deleteCallback == false; });
+        return _functions.size() - _removed.size() + _added.size();
     }
 
     inline __attribute__((__always_inline__))
     static bool empty() {
-        return _functions.empty() || (std::find_if(_functions.begin(), _functions.end(), [](const Entry &entry) { return entry.deleteCallback == false; }) == _functions.end());
+        return size() == 0;
     }
 
+    // execute all functions once
+    static void run();
+
+    // erase removed entries. called by run(), required for loops that iterate getVector() instead
+    static void cleanUp();
+
+    // removed entries have deleteCallback set until run() or cleanUp() has been called
     inline __attribute__((__always_inline__))
-    static FunctionsVector &getVector() {
+    static const FunctionsMap &getVector() {
         return _functions;
     }
 
     inline __attribute__((__always_inline__))
-    static bool callOnce(Callback callback) {
-        return schedule_function(callback);
+    static bool callOnce(ScheduledFunction callback) {
+        return schedule_function(std::move(callback));
     }
 
+    // same as callOnce(ScheduledFunction). if the queue of schedule_function() is full, the function is called by
+    // the next run() instead. can be called from any context, returns false if both queues are full
+    static bool callOnce(CallbackPtr callback);
+
+    #if LOOP_FUNCTIONS_PROFILER
+        static void clearProfile();
+        static void dumpProfile(Print &output);
+
+        // entry with the highest max. runtime or nullptr
+        static const Entry *getSlowest();
+    #endif
+
 private:
-    static FunctionsVector _functions;
-};
+    static void _applyDeferred();
+    // remove the key of an entry that does not exist anymore from _index and _removed
+    static void _removeStaleKey(KeyType key);
 
-inline void LoopFunctions::add(Callback callback, CallbackPtr callbackPtr LOOP_FUNCTIONS_DEBUG_ARGS)
-{
-    auto iterator = std::find(_functions.begin(), _functions.end(), callbackPtr);
-    if (iterator == _functions.end()) {
-        _functions.emplace_back(callback, callbackPtr, false);
-        #if DEBUG_LOOP_FUNCTIONS
-            _functions.back()._source = source;
-            _functions.back()._line = line;
-        #endif
-        return;
-    }
-    iterator->deleteCallback = false;
-}
+private:
+    static FunctionsMap _functions;
+    static IndexMap _index;
+    static std::vector<KeyType> _removed;   // marked with deleteCallback
+    static std::vector<Entry> _added;       // added during run()
+    static bool _running;
+    static stdex::mpsc_ring_buffer<CallbackPtr, LOOP_FUNCTIONS_CALL_ONCE_RETRY_SIZE> _callOnceRetry;
+};
 
 #if _MSC_VER || ESP32
 
-extern std::vector<std::function<void(void)>> scheduled_functions;
+extern ScheduledFunctionQueue scheduled_functions;
 
 inline void run_scheduled_functions()
 {
-    for(auto fn: scheduled_functions) {
+    // functions scheduled while running are executed in the next call
+    ScheduledFunction fn;
+    for(auto count = scheduled_functions.size(); count && scheduled_functions.pop(fn); count--) {
         fn();
         #if ESP32 && defined(CONFIG_HEAP_POISONING_COMPREHENSIVE)
             heap_caps_check_integrity_all(true);
@@ -194,7 +285,12 @@ inline void run_scheduled_functions()
             _ASSERTE(_CrtCheckMemory());
         #endif
     }
-    scheduled_functions.clear();
+    fn = nullptr;
+}
+
+inline uint32_t get_scheduled_functions_overflows()
+{
+    return scheduled_functions.getOverflows();
 }
 
 #endif
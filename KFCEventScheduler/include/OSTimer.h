@@ -26,7 +26,7 @@
 // keep a list of all timers to check it exists
 // using the internal list of the ESP8266
 #ifndef DEBUG_OSTIMER_FIND
-#    if ESP32
+#    if ESP32 || EVENT_SCHEDULER_SIMULATED_CLOCK
 #        define DEBUG_OSTIMER_FIND 0
 #    else
 #        define DEBUG_OSTIMER_FIND 1
@@ -16,6 +16,9 @@
 #if ESP8266 || _MSC_VER
 
 #include "OSTimer.h"
+#if EVENT_SCHEDULER_SIMULATED_CLOCK
+#    include "SimulatedClock.h"
+#endif
 
 #if DEBUG_OSTIMER
     inline ETSTimerEx::ETSTimerEx(const char *name) :
@@ -68,15 +71,23 @@ inline ETSTimerEx::~ETSTimerEx()
 
 inline void ETSTimerEx::create(ETSTimerFunc *callback, void *arg)
 {
-    if (!isNew()) {
-        ets_timer_disarm(reinterpret_cast<ETSTimer *>(this));
-    }
-    ets_timer_setfn(reinterpret_cast<ETSTimer *>(this), callback, arg);
+    #if EVENT_SCHEDULER_SIMULATED_CLOCK
+        Event::SimulatedClock::timerSetfn(reinterpret_cast<ETSTimer *>(this), callback, arg);
+    #else
+        if (!isNew()) {
+            ets_timer_disarm(reinterpret_cast<ETSTimer *>(this));
+        }
+        ets_timer_setfn(reinterpret_cast<ETSTimer *>(this), callback, arg);
+    #endif
 }
 
 inline void ETSTimerEx::arm(int32_t delay, bool repeat, bool millis)
 {
-    ets_timer_arm_new(reinterpret_cast<ETSTimer *>(this), delay, repeat, millis);
+    #if EVENT_SCHEDULER_SIMULATED_CLOCK
+        Event::SimulatedClock::timerArm(reinterpret_cast<ETSTimer *>(this), delay, repeat, millis);
+    #else
+        ets_timer_arm_new(reinterpret_cast<ETSTimer *>(this), delay, repeat, millis);
+    #endif
 }
 
 inline bool ETSTimerEx::isNew() const
@@ -162,7 +173,11 @@ inline void ETSTimerEx::disarm()
             __DBG_printEtsTimer_E(*this, PSTR("disarm(): isNew()==TRUE"));
         }
     #endif
-    ets_timer_disarm(this);
+    #if EVENT_SCHEDULER_SIMULATED_CLOCK
+        Event::SimulatedClock::timerDisarm(this);
+    #else
+        ets_timer_disarm(this);
+    #endif
 }
 
 inline void ETSTimerEx::done()
@@ -186,8 +201,12 @@ inline void ETSTimerEx::done()
             __DBG_printEtsTimer_E(*this, PSTR("done(): isLocked()==TRUE"));
         }
     #endif
-    ets_timer_disarm(this);
-    ets_timer_done(this);
+    #if EVENT_SCHEDULER_SIMULATED_CLOCK
+        Event::SimulatedClock::timerDone(this);
+    #else
+        ets_timer_disarm(this);
+        ets_timer_done(this);
+    #endif
     clear();
 }
 
@@ -231,17 +250,25 @@ inline ETSTimerEx *ETSTimerEx::find(ETSTimerEx *timer)
 
 inline void ETSTimerEx::end()
 {
-    ETSTimer *cur = timer_list;
-    while(cur) {
-        auto next = cur->timer_next;
-        if (cur->timer_func == reinterpret_cast<ETSTimerFunc *>(_EtsTimerLockedCallback) || cur->timer_func == reinterpret_cast<ETSTimerFunc *>(OSTimer::_OSTimerCallback)) {
-            ets_timer_disarm(cur);
-            #if _MSC_VER
-                ets_timer_done(cur);
-            #endif
+    #if EVENT_SCHEDULER_SIMULATED_CLOCK
+        for(const auto cur: Event::SimulatedClock::getArmedTimers()) {
+            if (cur->timer_func == reinterpret_cast<ETSTimerFunc *>(_EtsTimerLockedCallback) || cur->timer_func == reinterpret_cast<ETSTimerFunc *>(OSTimer::_OSTimerCallback)) {
+                Event::SimulatedClock::timerDone(cur);
+            }
         }
-        cur = next;
-    }
+    #else
+        ETSTimer *cur = timer_list;
+        while(cur) {
+            auto next = cur->timer_next;
+            if (cur->timer_func == reinterpret_cast<ETSTimerFunc *>(_EtsTimerLockedCallback) || cur->timer_func == reinterpret_cast<ETSTimerFunc *>(OSTimer::_OSTimerCallback)) {
+                ets_timer_disarm(cur);
+                #if _MSC_VER
+                    ets_timer_done(cur);
+                #endif
+            }
+            cur = next;
+        }
+    #endif
 }
 
 inline void ICACHE_FLASH_ATTR ETSTimerEx::_EtsTimerLockedCallback(OSTimer *timer)
@@ -6,6 +6,10 @@
 
 #include <Arduino_compat.h>
 #include "Event.h"
+#include <atomic>
+#if EVENT_SCHEDULER_PROFILER
+#    include "SchedulerProfiler.h"
+#endif
 
 #ifndef _MSC_VER
 #    pragma GCC push_options
@@ -29,24 +33,55 @@ namespace Event {
         // there is no guarantee that a timer is called within its interval until PriorityType is set to TIMER
         // lower priorities are executed in the main loop and can be blocked by the program or another timer
         // depending on the implementation, different priorities might be executed in different section of the program
-        void add(int64_t intervalMillis, RepeatType repeat, Callback callback, PriorityType priority = PriorityType::NORMAL);
-        void add(milliseconds interval, RepeatType repeat, Callback callback, PriorityType priority = PriorityType::NORMAL);
+        //
+        // slackMillis allows to delay the timer to align it with other timers. see CallbackTimer::setSlack()
+        //
+        // returns the handle of the timer. it becomes invalid when the timer has been removed
+        TimerHandle add(int64_t intervalMillis, RepeatType repeat, Callback callback, PriorityType priority = PriorityType::NORMAL, uint32_t slackMillis = 0);
+        TimerHandle add(milliseconds interval, RepeatType repeat, Callback callback, PriorityType priority = PriorityType::NORMAL, uint32_t slackMillis = 0);
 
         // add named timer in debug mode
-        void add(const char *name, int64_t intervalMillis, RepeatType repeat, Callback callback, PriorityType priority = PriorityType::NORMAL);
-        void add(const char *name, milliseconds interval, RepeatType repeat, Callback callback, PriorityType priority = PriorityType::NORMAL);
+        TimerHandle add(const char *name, int64_t intervalMillis, RepeatType repeat, Callback callback, PriorityType priority = PriorityType::NORMAL, uint32_t slackMillis = 0);
+        TimerHandle add(const char *name, milliseconds interval, RepeatType repeat, Callback callback, PriorityType priority = PriorityType::NORMAL, uint32_t slackMillis = 0);
 
         // remove timer
         void remove(CallbackTimerPtr timer);
 
+        // remove timer by handle. returns false if the timer does not exist anymore
+        bool remove(TimerHandle handle);
+
+        // returns nullptr if the timer does not exist anymore
+        CallbackTimerPtr getTimer(TimerHandle handle);
+
         // returns number of scheduled timers
         size_t size() const;
 
+        // milliseconds until the next timer with the given or a higher priority expires
+        // the priority is rounded down to the level of its ready list, PriorityType::HIGH includes all timers above NORMAL
+        // returns 0 if any timer has been triggered and waits for execution, or kNoDeadline if no timer is armed
+        // the deadlines are updated when timers are armed or disarmed and the timers are not scanned
+        uint32_t getNextDeadline(PriorityType priority = PriorityType::NONE);
+
+        // adjust all timers after the system time has been stopped for the given amount of time, i.e. by light sleep
+        // timers that have expired in the meantime are executed by the next run(), repeating timers skip missed intervals
+        // timers with a delay above kMaxDelay are not adjusted
+        void fastForward(uint32_t sleptMillis);
+
     public:
         static void run(PriorityType runAbovePriority);
         static void run();
         static void __TimerCallback(CallbackTimerPtr timer);
 
+#if EVENT_SCHEDULER_PROFILER
+    public:
+        // statistics of the main loop. per timer statistics are available with CallbackTimer::getProfile()
+        const SchedulerProfile &getProfile() const;
+        // reset statistics of the scheduler and all timers
+        void clearProfile();
+        // print statistics of the scheduler and all timers as JSON object
+        void dumpProfile(Print &output);
+#endif
+
     public:
         TimerVector &__getTimers() { return _timers; }
         void __list(bool debug = true);
@@ -59,11 +94,15 @@ namespace Event {
         friend Timer;
         friend ManagedCallbackTimer;
 
-        CallbackTimer *_add(const char *name, int64_t intervalMillis, RepeatType repeat, Callback callback, PriorityType priority = PriorityType::NORMAL);
+        // the handle is stored in handle before the timer is armed
+        CallbackTimer *_add(const char *name, int64_t intervalMillis, RepeatType repeat, Callback callback, PriorityType priority = PriorityType::NORMAL, uint32_t slackMillis = 0, TimerHandle *handle = nullptr);
         void _invokeCallback(CallbackTimerPtr timer, uint32_t runtimeLimit);
 
+        // the handle of the timer is validated, a removed timer is not accessed unless its memory has been reused
         bool _hasTimer(CallbackTimerPtr timer) const;
         bool _removeTimer(CallbackTimerPtr timer);
+        // returns false if the handle is not valid
+        bool _removeTimer(TimerHandle handle);
 
         // execute timers with a priority above without any time limiot
         void _run(PriorityType runAbovePriority);
@@ -71,22 +110,81 @@ namespace Event {
         // once kMaxRuntimeLimit is reached, normal and below will be skipped until the next call of the function
         void _run();
 
-        // remove null pointers
-        void _cleanup();
-
-        // remove null pointers and sort timers by priority
-        void _sort();
-
         SemaphoreMutex &getLock();
 
+    private:
+        // timers that have been triggered by the OS timer are stored in a linked list per priority level
+        // _run() only visits timers in these lists, adding and removing is O(1)
+        static constexpr uint8_t kReadyListCount = 8;
+        // passed to _runReadyList() to execute all priorities including PriorityType::NONE
+        static constexpr PriorityType kRunAllPriorities = static_cast<PriorityType>(-128);
+
+        struct ReadyList {
+            CallbackTimerPtr _head;
+            CallbackTimerPtr _tail;
+            uint16_t _count;
+        };
+
+        static uint8_t _getReadyListIndex(PriorityType priority);
+
+        // timers triggered by the OS timer are pushed to a lock-free intrusive list and moved to the ready
+        // lists by the main loop. the timer context does not acquire any lock
+        //
+        // a timer is queued once until the main loop has picked it up (CallbackTimer::_pending)
+        void _pushPending(CallbackTimerPtr timer);
+        // move all pending timers to the ready lists in the order they have been triggered
+        // returns true if any timer has been moved
+        bool _drainPending();
+        // delete removed timers after the timer context has left __TimerCallback(), called by _drainPending()
+        //
+        // removed timers are added to _removedList, moved to _retiredList by a call that does not find any callback
+        // in progress and deleted by the next one
+        void _deleteRemoved();
+
+        // deadlines of all armed timers are stored in a binary min heap per ready list
+        // the heaps are protected by _deadlineLock. no other lock is acquired while it is locked
+        using DeadlineHeap = std::vector<CallbackTimerPtr>;
+
+        // insert timer or update its position
+        void _updateDeadline(CallbackTimerPtr timer, uint64_t deadline);
+        void _removeDeadline(CallbackTimerPtr timer);
+        // set the deadline of a repeating OS timer to its next expiration after it has been triggered
+        void _advanceDeadline(CallbackTimerPtr timer);
+        static void _siftUp(DeadlineHeap &heap, uint32_t index);
+        static void _siftDown(DeadlineHeap &heap, uint32_t index);
+
+        // the following methods require _lock to be locked
+
+        // schedule timer for execution in the main loop
+        void _pushReady(CallbackTimerPtr timer);
+        // append timer to its ready list without changing _callbackScheduled or _hasEvent
+        void _linkReady(CallbackTimerPtr timer);
+        // remove timer from its ready list if queued
+        void _unlinkReady(CallbackTimerPtr timer);
+        // set _hasEvent to the highest priority of all scheduled timers
+        void _updateHasEvent();
+
+        // execute timers of a single ready list that have been queued before the function was called
+        // runtimeLimit in milliseconds since start applies to PriorityType::NORMAL and below, 0 = no limit
+        // returns false if the runtime limit has been reached
+        bool _runReadyList(uint8_t index, PriorityType runAbovePriority, uint32_t start, uint32_t runtimeLimit);
+
     private:
         TimerVector _timers;
-        int16_t _size;
+        ReadyList _readyLists[kReadyListCount];
+        std::atomic<CallbackTimerPtr> _pendingList;
+        // linked by CallbackTimer::_pendingNext, modified with _lock locked
+        std::atomic<CallbackTimerPtr> _removedList;
+        std::atomic<CallbackTimerPtr> _retiredList;
+        // number of __TimerCallback() calls in progress
+        std::atomic<uint8_t> _timerContext;
+        DeadlineHeap _deadlines[kReadyListCount];
         volatile PriorityType _hasEvent;
-        bool _addedFlag;
-        bool _removedFlag;
-        // volatile bool _checkTimers;
         SemaphoreMutex _lock;
+        SemaphoreMutex _deadlineLock;
+#if EVENT_SCHEDULER_PROFILER
+        SchedulerProfile _profile;
+#endif
 
 #if DEBUG_EVENT_SCHEDULER_RUNTIME_LIMIT_CONSTEXPR
         static constexpr uint32_t _runtimeLimit = kMaxRuntimeLimit;
@@ -102,31 +200,53 @@ namespace Event {
         _removeTimer(timer);
     }
 
+    inline bool Scheduler::remove(TimerHandle handle)
+    {
+        return _removeTimer(handle);
+    }
+
     inline size_t Scheduler::size() const
     {
-        return _timers.size() - std::count(_timers.begin(), _timers.end(), nullptr);
+        return _timers.size();
     }
 
-    inline void Scheduler::add(int64_t intervalMillis, RepeatType repeat, Callback callback, PriorityType priority)
+    inline TimerHandle Scheduler::add(int64_t intervalMillis, RepeatType repeat, Callback callback, PriorityType priority, uint32_t slackMillis)
     {
-        _add(PSTR("SchedulerTimer"), intervalMillis, repeat, callback, priority);
+        TimerHandle handle;
+        _add(PSTR("SchedulerTimer"), intervalMillis, repeat, callback, priority, slackMillis, &handle);
+        return handle;
     }
 
-    inline void Scheduler::add(milliseconds interval, RepeatType repeat, Callback callback, PriorityType priority)
+    inline TimerHandle Scheduler::add(milliseconds interval, RepeatType repeat, Callback callback, PriorityType priority, uint32_t slackMillis)
     {
-        _add(PSTR("SchedulerTimer"), interval.count(), repeat, callback, priority);
+        TimerHandle handle;
+        _add(PSTR("SchedulerTimer"), interval.count(), repeat, callback, priority, slackMillis, &handle);
+        return handle;
     }
 
-    inline void Scheduler::add(const char *name, int64_t intervalMillis, RepeatType repeat, Callback callback, PriorityType priority)
+    inline TimerHandle Scheduler::add(const char *name, int64_t intervalMillis, RepeatType repeat, Callback callback, PriorityType priority, uint32_t slackMillis)
     {
-        _add(name, intervalMillis, repeat, callback, priority);
+        TimerHandle handle;
+        _add(name, intervalMillis, repeat, callback, priority, slackMillis, &handle);
+        return handle;
     }
 
-    inline void Scheduler::add(const char *name, milliseconds interval, RepeatType repeat, Callback callback, PriorityType priority)
+    inline TimerHandle Scheduler::add(const char *name, milliseconds interval, RepeatType repeat, Callback callback, PriorityType priority, uint32_t slackMillis)
     {
-        _add(name, interval.count(), repeat, callback, priority);
+        TimerHandle handle;
+        _add(name, interval.count(), repeat, callback, priority, slackMillis, &handle);
+        return handle;
     }
 
+#if EVENT_SCHEDULER_PROFILER
+
+    inline const SchedulerProfile &Scheduler::getProfile() const
+    {
+        return _profile;
+    }
+
+#endif
+
     inline SemaphoreMutex &Scheduler::getLock()
     {
         return _lock;
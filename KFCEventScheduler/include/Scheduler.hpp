@@ -19,11 +19,12 @@
 namespace Event {
 
     inline Scheduler::Scheduler() :
-        _size(0),
-        _hasEvent(PriorityType::NONE),
-        _addedFlag(false),
-        _removedFlag(false)
-        // _checkTimers(false)
+        _readyLists(),
+        _pendingList(nullptr),
+        _removedList(nullptr),
+        _retiredList(nullptr),
+        _timerContext(0),
+        _hasEvent(PriorityType::NONE)
         #if DEBUG_EVENT_SCHEDULER_RUNTIME_LIMIT_CONSTEXPR == 0
             , _runtimeLimit(kMaxRuntimeLimit)
         #endif
@@ -88,17 +89,24 @@ namespace Event {
 
 namespace Event {
 
-    inline void Scheduler::_cleanup()
+    inline bool Scheduler::_hasTimer(CallbackTimerPtr timer) const
     {
-        _timers.erase(std::remove(_timers.begin(), _timers.end(), nullptr), _timers.end());
-        _timers.shrink_to_fit();
-        _size = static_cast<int16_t>(_timers.size());
-        _removedFlag = false;
+        if (timer == nullptr) {
+            return false;
+        }
+        auto timerPtr = _timers.find(timer->_handle);
+        return timerPtr && *timerPtr == timer;
     }
 
-    inline bool Scheduler::_hasTimer(CallbackTimerPtr timer) const
+    inline CallbackTimerPtr Scheduler::getTimer(TimerHandle handle)
     {
-        return (timer == nullptr) ? false : (std::find(_timers.begin(), _timers.end(), timer) != _timers.end());
+        MUTEX_LOCK_BLOCK(_lock) {
+            auto timerPtr = _timers.find(handle);
+            if (timerPtr) {
+                return *timerPtr;
+            }
+        }
+        return nullptr;
     }
 
     inline void Scheduler::run(PriorityType runAbovePriority)
@@ -113,19 +121,106 @@ namespace Event {
 
     inline void Scheduler::_run(PriorityType runAbovePriority)
     {
+        _drainPending();
         if (_hasEvent > runAbovePriority) {
-            for(int i = 0; i < _size; i++) {
-                auto timer = _timers[i];
-                if (timer) {
-                    if (timer->_priority > runAbovePriority && timer->_callbackScheduled) {
-                        timer->_callbackScheduled = false;
-                        timer->_invokeCallback(timer);
-                        #if ESP32 && defined(CONFIG_HEAP_POISONING_COMPREHENSIVE)
-                            heap_caps_check_integrity_all(true);
-                        #endif
-                    }
-                }
+            for(int8_t i = kReadyListCount - 1; i >= _getReadyListIndex(runAbovePriority); i--) {
+                _runReadyList(i, runAbovePriority, 0, 0);
             }
+            MUTEX_LOCK_BLOCK(_lock) {
+                _updateHasEvent();
+            }
+        }
+    }
+
+    inline uint8_t Scheduler::_getReadyListIndex(PriorityType priority)
+    {
+        if (priority >= PriorityType::TIMER) {
+            return 7;
+        }
+        else if (priority >= PriorityType::HIGHEST) {
+            return 6;
+        }
+        else if (priority >= PriorityType::HIGHER) {
+            return 5;
+        }
+        else if (priority >= PriorityType::HIGH) {
+            return 4;
+        }
+        else if (priority >= PriorityType::NORMAL) {
+            return 3;
+        }
+        else if (priority >= PriorityType::LOW) {
+            return 2;
+        }
+        else if (priority >= PriorityType::LOWER) {
+            return 1;
+        }
+        return 0;
+    }
+
+    inline void Scheduler::_linkReady(CallbackTimerPtr timer)
+    {
+        auto &list = _readyLists[_getReadyListIndex(timer->_priority)];
+        timer->_readyNext = nullptr;
+        timer->_readyPrev = list._tail;
+        if (list._tail) {
+            list._tail->_readyNext = timer;
+        }
+        else {
+            list._head = timer;
+        }
+        list._tail = timer;
+        list._count++;
+        timer->_readyQueued = true;
+    }
+
+    inline void Scheduler::_unlinkReady(CallbackTimerPtr timer)
+    {
+        if (!timer->_readyQueued) {
+            return;
+        }
+        auto &list = _readyLists[_getReadyListIndex(timer->_priority)];
+        if (timer->_readyPrev) {
+            timer->_readyPrev->_readyNext = timer->_readyNext;
+        }
+        else {
+            list._head = timer->_readyNext;
+        }
+        if (timer->_readyNext) {
+            timer->_readyNext->_readyPrev = timer->_readyPrev;
+        }
+        else {
+            list._tail = timer->_readyPrev;
+        }
+        list._count--;
+        timer->_readyPrev = nullptr;
+        timer->_readyNext = nullptr;
+        timer->_readyQueued = false;
+    }
+
+    inline void Scheduler::_pushPending(CallbackTimerPtr timer)
+    {
+        // must be set before _pending, _drainPending() clears _pending before reading it
+        timer->_callbackScheduled = true;
+        if (timer->_pending.exchange(true)) {
+            // already queued or removed
+            return;
+        }
+        auto head = _pendingList.load(std::memory_order_relaxed);
+        do {
+            timer->_pendingNext = head;
+        } while(!_pendingList.compare_exchange_weak(head, timer, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    inline void Scheduler::_pushReady(CallbackTimerPtr timer)
+    {
+        // a timer that is already queued keeps its position
+        if (!timer->_readyQueued) {
+            _linkReady(timer);
+        }
+        timer->_callbackScheduled = true;
+        if (timer->_priority > _hasEvent) {
+            _hasEvent = timer->_priority;
         }
     }
 
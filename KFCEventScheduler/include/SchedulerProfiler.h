@@ -0,0 +1,81 @@
+/**
+  Author: sascha_lammers@gmx.de
+*/
+
+#pragma once
+
+#include <Arduino_compat.h>
+
+#ifndef _MSC_VER
+#    pragma GCC push_options
+#    pragma GCC optimize("O3")
+#endif
+
+namespace Event {
+
+    // runtime statistics of a single timer, recorded if EVENT_SCHEDULER_PROFILER is enabled
+    //
+    // all times in microseconds. jitter is the time between the OS timer being triggered and the callback
+    // being invoked
+    struct TimerProfile {
+        // bucket 0 = 0us, bucket n = 2^(n-1) to 2^n-1 us, the last bucket contains everything above
+        static constexpr uint8_t kHistogramSize = 16;
+
+        uint32_t calls;
+        uint32_t maxRuntime;
+        uint64_t totalRuntime;
+        uint32_t maxJitter;
+        uint64_t totalJitter;
+        uint16_t histogram[kHistogramSize];
+
+        TimerProfile() : calls(0), maxRuntime(0), totalRuntime(0), maxJitter(0), totalJitter(0), histogram() {}
+
+        void add(uint32_t runtime, uint32_t jitter) {
+            calls++;
+            totalRuntime += runtime;
+            if (runtime > maxRuntime) {
+                maxRuntime = runtime;
+            }
+            totalJitter += jitter;
+            if (jitter > maxJitter) {
+                maxJitter = jitter;
+            }
+            auto &bucket = histogram[getBucket(runtime)];
+            if (bucket < 0xffff) {
+                bucket++;
+            }
+        }
+
+        static uint8_t getBucket(uint32_t runtime) {
+            uint8_t bucket = 0;
+            while(runtime && bucket < kHistogramSize - 1) {
+                runtime >>= 1;
+                bucket++;
+            }
+            return bucket;
+        }
+
+        uint32_t getAvgRuntime() const {
+            return calls ? static_cast<uint32_t>(totalRuntime / calls) : 0;
+        }
+
+        uint32_t getAvgJitter() const {
+            return calls ? static_cast<uint32_t>(totalJitter / calls) : 0;
+        }
+    };
+
+    // statistics of Scheduler::run()
+    struct SchedulerProfile {
+        uint32_t runs;                  // calls that have executed at least one callback
+        uint32_t maxRuntime;            // microseconds
+        uint32_t deferredRuns;          // calls that have reached kMaxRuntimeLimit
+        uint32_t deferredCallbacks;     // PriorityType::NORMAL and lower callbacks that have been delayed to the next call
+
+        SchedulerProfile() : runs(0), maxRuntime(0), deferredRuns(0), deferredCallbacks(0) {}
+    };
+
+}
+
+#ifndef _MSC_VER
+#    pragma GCC pop_options
+#endif
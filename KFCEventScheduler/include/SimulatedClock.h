@@ -0,0 +1,61 @@
+/**
+  Author: sascha_lammers@gmx.de
+*/
+
+#pragma once
+
+#include <Arduino_compat.h>
+#include "Event.h"
+
+#if EVENT_SCHEDULER_SIMULATED_CLOCK
+
+#include <vector>
+
+// virtual clock for host builds
+//
+// if EVENT_SCHEDULER_SIMULATED_CLOCK is set, ETSTimerEx uses the timer functions below instead of the
+// SDK and Event::millis()/Event::micros()/Event::millis64() replace the system time inside the Event namespace. time only
+// advances by calling advance() or step(), which invoke the timer callbacks in order of expiration
+// with the clock set to the time of expiration
+//
+// the simulation is not thread safe and must be driven from the same thread that calls Scheduler::run()
+
+namespace Event {
+
+    namespace SimulatedClock {
+
+        // microseconds since reset()
+        uint64_t getMicros64();
+
+        // advance the clock by the given amount of time and invoke all expired timers
+        // returns the number of callbacks
+        uint32_t advance(uint64_t micros);
+        uint32_t advanceMillis(uint64_t millis);
+
+        // advance the clock to the next expiration and invoke all timers expiring at that time
+        // returns false if no timer is armed
+        bool step();
+
+        // time of the next expiration or UINT64_MAX if no timer is armed
+        uint64_t getNextExpiration();
+
+        // number of armed timers
+        size_t getArmedCount();
+
+        // armed timers, unordered
+        std::vector<ETSTimer *> getArmedTimers();
+
+        // set time to 0 and forget all armed timers
+        void reset();
+
+        // replacement for the SDK timer functions used by ETSTimerEx
+        void timerSetfn(ETSTimer *timer, ETSTimerFunc *callback, void *arg);
+        void timerArm(ETSTimer *timer, uint32_t time, bool repeat, bool isMillis);
+        void timerDisarm(ETSTimer *timer);
+        void timerDone(ETSTimer *timer);
+
+    }
+
+}
+
+#endif
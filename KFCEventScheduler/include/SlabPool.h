@@ -0,0 +1,156 @@
+/**
+  Author: sascha_lammers@gmx.de
+*/
+
+#pragma once
+
+#include <Arduino_compat.h>
+#include <Mutex.h>
+#include <type_traits>
+
+#ifndef _MSC_VER
+#    pragma GCC push_options
+#    pragma GCC optimize("O3")
+#endif
+
+namespace Event {
+
+    struct SlabPoolStats {
+        uint16_t live;              // allocated objects
+        uint16_t peak;              // max. number of allocated objects
+        uint16_t chunks;            // number of chunks
+        uint16_t free;              // objects in the free list
+    };
+
+    // fixed size allocator for objects of type T
+    //
+    // memory is allocated in chunks of kChunkSize objects and kept for the lifetime of the pool. freed
+    // objects are stored in a free list and reused by the next allocation. this avoids heap fragmentation
+    // by objects that are created and destroyed frequently
+    template<class T, size_t kChunkSize>
+    class SlabPool {
+    public:
+        static_assert(kChunkSize > 0, "kChunkSize must be greater than 0");
+
+        using Stats = SlabPoolStats;
+
+        SlabPool() : _chunks(nullptr), _free(nullptr), _stats() {
+        }
+
+        ~SlabPool() {
+            while(_chunks) {
+                auto next = _chunks->_next;
+                ::operator delete(_chunks);
+                _chunks = next;
+            }
+        }
+
+        SlabPool(const SlabPool &) = delete;
+        SlabPool &operator=(const SlabPool &) = delete;
+
+        void *allocate() {
+            MUTEX_LOCK_BLOCK(_lock) {
+                if (!_free) {
+                    _grow();
+                }
+                auto slot = _free;
+                _free = slot->_next;
+                _stats.free--;
+                if (++_stats.live > _stats.peak) {
+                    _stats.peak = _stats.live;
+                }
+                return slot;
+            }
+            return nullptr;
+        }
+
+        void deallocate(void *ptr) {
+            if (!ptr) {
+                return;
+            }
+            MUTEX_LOCK_BLOCK(_lock) {
+                auto slot = reinterpret_cast<Slot *>(ptr);
+                slot->_next = _free;
+                _free = slot;
+                _stats.free++;
+                _stats.live--;
+            }
+        }
+
+        Stats getStats() const {
+            return _stats;
+        }
+
+    private:
+        union Slot {
+            Slot *_next;
+            typename std::aligned_storage<sizeof(T), alignof(T)>::type _storage;
+        };
+
+        struct Chunk {
+            Chunk *_next;
+            Slot _slots[kChunkSize];
+        };
+
+        void _grow() {
+            auto chunk = reinterpret_cast<Chunk *>(::operator new(sizeof(Chunk)));
+            chunk->_next = _chunks;
+            _chunks = chunk;
+            // add slots in reverse order to allocate the first slot first
+            for(size_t i = kChunkSize; i > 0; i--) {
+                auto &slot = chunk->_slots[i - 1];
+                slot._next = _free;
+                _free = &slot;
+            }
+            _stats.chunks++;
+            _stats.free += kChunkSize;
+        }
+
+    private:
+        Chunk *_chunks;
+        Slot *_free;
+        Stats _stats;
+        SemaphoreMutex _lock;
+    };
+
+    // class specific operator new/delete for objects that fit into a slot of SlabPool<T, kChunkSize>
+    //
+    // the pool is created on first use and never destroyed. objects can be created by constructors and deleted by
+    // destructors of global objects. requests that exceed sizeof(T) are passed to the global operator new/delete.
+    // operator delete must be the sized version to tell both apart
+    template<class T, size_t kChunkSize>
+    class SlabAllocator {
+    public:
+        using Pool = SlabPool<T, kChunkSize>;
+
+        static void *allocate(size_t size) {
+            if (size > sizeof(T)) {
+                return ::operator new(size);
+            }
+            return getPool().allocate();
+        }
+
+        static void deallocate(void *ptr, size_t size) {
+            if (size > sizeof(T)) {
+                ::operator delete(ptr);
+                return;
+            }
+            getPool().deallocate(ptr);
+        }
+
+        static SlabPoolStats getStats() {
+            return getPool().getStats();
+        }
+
+    private:
+        static Pool &getPool() {
+            static auto pool = new Pool();
+            return *pool;
+        }
+    };
+
+}
+
+#ifndef _MSC_VER
+#    pragma GCC pop_options
+#endif
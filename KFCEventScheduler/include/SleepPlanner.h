@@ -0,0 +1,102 @@
+/**
+  Author: sascha_lammers@gmx.de
+*/
+
+#pragma once
+
+#include <Arduino_compat.h>
+#include <vector>
+#include <stl_ext/inplace_function.h>
+#include "Event.h"
+#include "LoopFunctions.h"
+
+#ifndef _MSC_VER
+#    pragma GCC push_options
+#    pragma GCC optimize("O3")
+#endif
+
+// the device stays awake if the next timer expires in less than this amount of milliseconds
+#ifndef SLEEP_PLANNER_MIN_SLEEP_TIME
+#    define SLEEP_PLANNER_MIN_SLEEP_TIME 10
+#endif
+
+// determines how long the device can sleep without delaying any timer
+//
+// - the next deadline of the scheduler
+// - loop functions, any installed loop function keeps the device awake unless it belongs to an idle wake source
+// - wake sources like the pin monitor report if they are busy and which GPIOs can wake up the device
+//
+// the planner does not enter any sleep mode. if the system time has been stopped during sleep, wakeup() must be called
+// with the time spent sleeping to fast-forward the timers
+class SleepPlanner {
+public:
+    using PinMaskType = uint64_t;
+    using BusyCallback = stdex::inplace_function<bool()>;
+    using PinMaskCallback = stdex::inplace_function<PinMaskType()>;
+
+    enum class ReasonType : uint8_t {
+        NONE = 0,
+        LOOP_FUNCTIONS,         // loop functions are installed
+        WAKE_SOURCE,            // a wake source is busy
+        TIMER,                  // a timer expires in less than the min. sleep time
+    };
+
+    struct Plan {
+        uint32_t sleepMillis;       // 0 = stay awake, Event::kNoDeadline = no timer is armed
+        PinMaskType wakePinMask;    // GPIOs that can wake up the device
+        ReasonType reason;
+
+        Plan(uint32_t pSleepMillis, PinMaskType pWakePinMask, ReasonType pReason) : sleepMillis(pSleepMillis), wakePinMask(pWakePinMask), reason(pReason) {}
+
+        bool canSleep() const {
+            return sleepMillis != 0;
+        }
+    };
+
+    class WakeSource {
+    public:
+        WakeSource(const void *pId, BusyCallback pIsBusy, PinMaskCallback pGetWakePinMask, LoopFunctions::CallbackPtr pLoopFunction) :
+            id(pId),
+            isBusy(pIsBusy),
+            getWakePinMask(pGetWakePinMask),
+            loopFunction(pLoopFunction)
+        {
+        }
+
+        bool operator==(const void *value) const {
+            return id == value;
+        }
+
+        const void *id;
+        BusyCallback isBusy;
+        PinMaskCallback getWakePinMask;
+        LoopFunctions::CallbackPtr loopFunction;     // loop function that does not need to be executed while the source is not busy
+    };
+
+    using WakeSourceVector = std::vector<WakeSource>;
+
+    // add or replace wake source
+    static void addWakeSource(const void *id, BusyCallback isBusy, PinMaskCallback getWakePinMask, LoopFunctions::CallbackPtr loopFunction = nullptr);
+    static void removeWakeSource(const void *id);
+
+    // timers with a priority below can be delayed until the device wakes up
+    static Plan getPlan(Event::PriorityType priority = Event::PriorityType::NONE, uint32_t minSleepMillis = SLEEP_PLANNER_MIN_SLEEP_TIME);
+
+    // fast-forward the timers after the system time has been stopped for sleptMillis
+    static void wakeup(uint32_t sleptMillis);
+
+    inline __attribute__((__always_inline__))
+    static WakeSourceVector &getWakeSources() {
+        return _wakeSources;
+    }
+
+private:
+    static bool _isLoopFunctionRequired(const LoopFunctions::Entry &entry);
+
+private:
+    static WakeSourceVector _wakeSources;
+};
+
+#ifndef _MSC_VER
+#    pragma GCC pop_options
+#endif
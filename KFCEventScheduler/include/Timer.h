@@ -82,11 +82,9 @@ namespace Event {
                 return;
             }
             // execute delayed and block all calls for delayMillis
-            add(Event::milliseconds(delayMillis), 2, [callback](CallbackTimerPtr timer) {
-                callback(timer);
-                // disarm, we just want one call
-                timer->disarm();
-            }, priority);
+            // the repeat count marks the timer as blocked, _throttled disarms it after the first call
+            add(Event::milliseconds(delayMillis), 2, std::move(callback), priority);
+            _managedTimer->_throttled = true;
         }
         else {
             // not active, run immediately
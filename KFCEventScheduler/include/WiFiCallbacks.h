@@ -5,9 +5,14 @@
 #pragma once
 
 #include <Arduino_compat.h>
+#include <atomic>
 #include <functional>
+#include <unordered_map>
 #include <vector>
 #include <stl_ext/utility.h>
+#include <stl_ext/inplace_function.h>
+#include <stl_ext/mpsc_ring_buffer.h>
+#include <stl_ext/slot_map.h>
 
 #ifndef _MSC_VER
 #    pragma GCC push_options
@@ -18,6 +23,24 @@
 #    define DEBUG_WIFICALLBACKS 0
 #endif
 
+// capacity of WiFiCallbacks::Callback in byte
+#ifndef WIFI_CALLBACKS_CALLBACK_CAPACITY
+#    define WIFI_CALLBACKS_CALLBACK_CAPACITY stdex::kInplaceFunctionDefaultCapacity
+#endif
+
+// max. number of events queued by WiFiCallbacks::queueEvent(). must be a power of 2
+#ifndef WIFI_CALLBACKS_QUEUE_SIZE
+#    define WIFI_CALLBACKS_QUEUE_SIZE 16
+#endif
+
+// callbacks for WiFi events
+//
+// the callbacks are stored in a slot map and indexed by their pointer, add() and remove() are O(1). for each event
+// bit, a list of the registered callbacks is rebuilt after the registrations have changed. changes during
+// callEvent() are applied after all callbacks have been invoked. callEvent() can be called from a callback, the
+// nested event is delivered before it returns
+//
+// queueEvent() can be used inside the WiFi event handler. the events are delivered in batches through the main loop
 class WiFiCallbacks {
 public:
     enum class EventType : int8_t {
@@ -32,9 +55,11 @@ public:
 
     using EventTypeEnum = stdex::enum_type<EventType>;
 
-    using Callback = std::function<void(EventType event, void *payload)>;
+    using Callback = stdex::inplace_function<void(EventType event, void *payload), WIFI_CALLBACKS_CALLBACK_CAPACITY>;
     typedef void(* CallbackPtr)(EventType event, void *payload);
 
+    static constexpr uint8_t kEventBits = 3;
+
     class Entry {
     public:
         Entry(EventType pEvents, Callback pCallback, CallbackPtr pCallbackPtr) : events(pEvents), callback(pCallback), callbackPtr(pCallbackPtr) {}
@@ -43,17 +68,30 @@ public:
             return events == type;
         }
 
+        bool operator==(CallbackPtr value) const {
+            return callbackPtr == value;
+        }
+
         EventType events;
         Callback callback;
         CallbackPtr callbackPtr;
     };
 
-    using CallbackVector = std::vector<Entry>;
+    struct QueuedEvent {
+        EventType event;
+        void *payload;
 
-    inline __attribute__((__always_inline__))
-    static void clear() {
-        _callbacks.clear();
-    }
+        QueuedEvent(EventType pEvent = EventType::NONE, void *pPayload = nullptr) : event(pEvent), payload(pPayload) {}
+    };
+
+    using CallbackMap = stdex::slot_map<Entry, uint16_t>;
+    using CallbackVector = CallbackMap;
+    using KeyType = CallbackMap::key_type;
+    using IndexMap = std::unordered_map<CallbackPtr, KeyType>;
+    using DispatchList = std::vector<uint16_t>;     // positions in CallbackMap
+    using EventQueue = stdex::mpsc_ring_buffer<QueuedEvent, WIFI_CALLBACKS_QUEUE_SIZE>;
+
+    static void clear();
 
     static EventType add(EventType events, Callback callback, CallbackPtr callbackPtr);
     static EventType add(EventType events, Callback callback, void *callbackPtr);
@@ -62,33 +100,46 @@ public:
     static EventType remove(EventType events, CallbackPtr callbackPtr);
     static EventType remove(EventType events, void *callbackPtr);
 
+    // invoke all callbacks for this event
     static void callEvent(EventType event, void *payload);
 
+    // deliver the event through the main loop. the payload must be valid until the event has been delivered, each
+    // queued event is delivered. returns false if the queue is full
+    static bool queueEvent(EventType event, void *payload = nullptr);
+
+    // deliver all queued events
+    static void processQueue();
+
+    // events dropped because the queue was full
     inline __attribute__((__always_inline__))
-    static CallbackVector &getVector() {
+    static uint32_t getQueueOverflows() {
+        return _queue.getOverflows();
+    }
+
+    inline __attribute__((__always_inline__))
+    static CallbackMap &getVector() {
         return _callbacks;
     }
 
 private:
-    static CallbackVector _callbacks;
-    static bool _locked;
-};
+    static void _rebuildDispatchLists();
+    static void _applyDeferred();
 
-inline WiFiCallbacks::EventType WiFiCallbacks::add(EventType events, Callback callback, CallbackPtr callbackPtr)
-{
-    __SLDBG_printf("events=%u callbackPtr=%p callback=%p", events, callbackPtr, lambda_target(callback));
-
-    EventTypeEnum(events) &= EventTypeEnum(EventTypeEnum::Enum::ANY);
-    for (auto &callback : _callbacks) {
-        if (callbackPtr == callback.callbackPtr) {
-            __SLDBG_printf("callbackPtr=%p, changed events from %u to %u", callbackPtr, callback.events, events);
-            return EventTypeEnum(callback.events) |= EventTypeEnum(events);
-        }
+    static constexpr uint8_t _getEventBit(EventType event) {
+        return (event == EventType::CONNECTED) ? 0 : (event == EventType::DISCONNECTED) ? 1 : (event == EventType::MODE_CHANGE) ? 2 : kEventBits;
     }
-    __SLDBG_printf("callbackPtr=%p new entry events %d", callbackPtr, events);
-    _callbacks.emplace_back(events, callback, callbackPtr);
-    return events;
-}
+
+private:
+    static CallbackMap _callbacks;
+    static IndexMap _index;
+    static DispatchList _dispatch[kEventBits];
+    static std::vector<KeyType> _removed;       // removed during callEvent()
+    static std::vector<Entry> _added;           // added during callEvent()
+    static EventQueue _queue;
+    static std::atomic_bool _queueScheduled;
+    static bool _dirty;
+    static uint8_t _locked;                     // nesting level of callEvent()
+};
 
 inline WiFiCallbacks::EventType WiFiCallbacks::add(EventType events, Callback callback, void *callbackPtr)
 {
@@ -100,50 +151,11 @@ inline WiFiCallbacks::EventType WiFiCallbacks::add(EventType events, CallbackPtr
     return add(events, nullptr, callbackPtr);
 }
 
-inline WiFiCallbacks::EventType WiFiCallbacks::remove(EventType events, CallbackPtr callbackPtr)
-{
-    __SLDBG_printf("events=%u callbackPtr=%p", events, callbackPtr);
-    for (auto iterator = _callbacks.begin(); iterator != _callbacks.end(); ++iterator) {
-        if (callbackPtr == iterator->callbackPtr) {
-            // __SLDBG_printf("callbackPtr=%p changed events from %u to %u", callbackPtr, iterator->events, EventTypeEnum(iterator->events) ^ EventTypeEnum((events));
-            EventTypeEnum(iterator->events) ^= EventTypeEnum(events);
-            if (iterator->events == EventType::NONE) {
-                if (!_locked) {
-                    _callbacks.erase(iterator);
-                }
-                return EventType::NONE;
-            }
-            return iterator->events;
-        }
-    }
-    return EventType::CALLBACK_NOT_FOUND;
-}
-
 inline WiFiCallbacks::EventType WiFiCallbacks::remove(EventType events, void *callbackPtr)
 {
     return remove(events, reinterpret_cast<CallbackPtr>(callbackPtr));
 }
 
-inline void WiFiCallbacks::callEvent(EventType event, void *payload)
-{
-    __SLDBG_printf("event=%u payload=%p", event, payload);
-    _locked = true;
-    for (const auto &entry : _callbacks) {
-        if (EventTypeEnum(entry.events) & EventTypeEnum(event)) {
-            if (entry.callback) {
-                __SLDBG_printf("callback=%p", lambda_target(entry.callback));
-                entry.callback(event, payload);
-            } else {
-                __SLDBG_printf("callbackPtr=%p", entry.callbackPtr);
-                entry.callbackPtr(event, payload);
-            }
-        }
-    }
-    _callbacks.erase(std::remove(_callbacks.begin(), _callbacks.end(), EventType::NONE), _callbacks.end());
-    _callbacks.shrink_to_fit();
-    _locked = false;
-}
-
 #ifndef _MSC_VER
 #    pragma GCC pop_options
 #endif
@@ -22,21 +22,55 @@
 
 using namespace Event;
 
+// timers can be added by constructors of global objects and are deleted by the destructor of the global scheduler
+using TimerAllocator = SlabAllocator<CallbackTimer, EVENT_SCHEDULER_TIMER_POOL_CHUNK_SIZE>;
+
+void *CallbackTimer::operator new(size_t size)
+{
+    return TimerAllocator::allocate(size);
+}
+
+void CallbackTimer::operator delete(void *ptr, size_t size)
+{
+    TimerAllocator::deallocate(ptr, size);
+}
+
+SlabPoolStats CallbackTimer::getPoolStats()
+{
+    return TimerAllocator::getStats();
+}
+
 CallbackTimer::CallbackTimer(const char *name, Callback callback, int64_t delay, RepeatType repeat, PriorityType priority) :
     _etsTimer(OSTIMER_NAME_VAR(name)),
     _callback(callback),
     _timer(nullptr),
+    _readyPrev(nullptr),
+    _readyNext(nullptr),
+    _pendingNext(nullptr),
     _delay(std::max<int64_t>(kMinDelay, delay)),
     #if SCHEDULER_HAVE_REMAINING_DELAY
         _remainingDelay(0),
     #endif
     _repeat(repeat),
     _priority(priority),
+    _handle(),
+    _deadlineIndex(kNoDeadlineIndex),
+    _deadline(0),
+    _slack(0),
+    _slackDue(0),
     #if SCHEDULER_HAVE_REMAINING_DELAY
         _maxDelayExceeded(false),
     #endif
     _callbackScheduled(false),
-    _insideCallback(false)
+    _insideCallback(false),
+    _readyQueued(false),
+    _coalesced(false),
+    _removed(false),
+    _pending(false),
+    _throttled(false)
+    #if EVENT_SCHEDULER_PROFILER
+        , _triggeredMicros(0)
+    #endif
 {
 }
 
@@ -68,6 +102,28 @@ CallbackTimer::~CallbackTimer()
     }
 }
 
+void CallbackTimer::_disarm()
+{
+    __LDBG_printf("timer=%p armed=%u cb=%p %s:%u", this, isArmed(), lambda_target(_callback), __S(_file), _line);
+    // isArmed() is false for one shot timers on the ESP8266
+    if (!_etsTimer.isDone()) {
+        _etsTimer.disarm();
+    }
+    #if SCHEDULER_HAVE_REMAINING_DELAY
+        _remainingDelay = 0;
+        _maxDelayExceeded = false;
+    #endif
+    _coalesced = false;
+    // the timer is removed from the ready list by the scheduler
+    _callbackScheduled = false;
+    __Scheduler._removeDeadline(this);
+}
+
+void CallbackTimer::_setDeadline(uint64_t delay)
+{
+    __Scheduler._updateDeadline(this, millis64() + delay);
+}
+
 void CallbackTimer::_rearm()
 {
     bool repeat;
@@ -91,12 +147,12 @@ void CallbackTimer::_rearm()
             else if (lastDelay < kMinDelay) {
                 _delay += kMinDelay - lastDelay;
             }
-            _remainingDelay = static_cast<decltype(_remainingDelay)>((_delay / kMaxDelay) + 1); // 1 to n times kMaxDelay
+            _remainingDelay = static_cast<decltype(_remainingDelay)>(_delay / kMaxDelay); // 1 to n times kMaxDelay
             // store state to avoid comparing uint64_t inside isr
             _maxDelayExceeded = true;
             delay = kMaxDelay;
             repeat = false; // we manually repeat
-            __LDBG_printf("delay=%.0f repeat=%u * %d + %u", _delay / 1.0, (_remainingDelay - 1), kMaxDelay, (uint32_t)(_delay % kMaxDelay));
+            __LDBG_printf("delay=%.0f repeat=%u * %d + %u", _delay / 1.0, _remainingDelay, kMaxDelay, (uint32_t)(_delay % kMaxDelay));
         }
         else {
             // delay that can be handled by ets timer
@@ -111,10 +167,91 @@ void CallbackTimer::_rearm()
         __LDBG_printf("delay=%.0f repeat=%u", (float)delay, repeat);
     #endif
 
+    _coalesced = false;
+    if (_slack && static_cast<int64_t>(delay) < std::numeric_limits<int32_t>::max()
+        #if SCHEDULER_HAVE_REMAINING_DELAY
+            && !_maxDelayExceeded
+        #endif
+    ) {
+        // repeating timers are armed for each interval to align every expiration
+        _slackDue = millis() + static_cast<uint32_t>(delay);
+        _coalesced = repeat;
+        repeat = false;
+        delay = _getCoalescedDelay();
+        __LDBG_printf("slack=%u delay=%u coalesced=%u", _slack, (uint32_t)delay, _coalesced);
+    }
+
+    #if SCHEDULER_HAVE_REMAINING_DELAY
+        // the deadline is the end of the last part
+        _setDeadline(_maxDelayExceeded ? _delay : delay);
+    #else
+        _setDeadline(delay);
+    #endif
+
     _etsTimer.create(reinterpret_cast<ETSTimerEx::ETSTimerExCallback>(Scheduler::__TimerCallback), this);
     _etsTimer.arm(delay, repeat, true);
 }
 
+void CallbackTimer::_rearmCoalesced()
+{
+    _slackDue += static_cast<uint32_t>(_delay);
+    // skip intervals that have been missed
+    uint32_t now = millis();
+    if (static_cast<int32_t>(now - _slackDue) > 0) {
+        _slackDue = now;
+    }
+    auto delay = _getCoalescedDelay();
+    _setDeadline(delay);
+    _etsTimer.arm(delay, false, true);
+}
+
+void CallbackTimer::_fastForward(uint32_t sleptMillis, uint64_t now)
+{
+    if (_deadlineIndex == kNoDeadlineIndex || _callbackScheduled) {
+        // disarmed or waiting for execution
+        return;
+    }
+    #if SCHEDULER_HAVE_REMAINING_DELAY
+        if (_maxDelayExceeded) {
+            // the parts of long delays are not adjusted
+            return;
+        }
+    #endif
+    auto deadline = _deadline - std::min<uint64_t>(_deadline, sleptMillis);
+    bool repeat = _repeat._hasRepeat();
+    if (!_etsTimer.isDone()) {
+        _etsTimer.disarm();
+    }
+    if (repeat && deadline <= now) {
+        // skip the intervals that have been missed
+        deadline += ((now - deadline) / _delay) * _delay;
+    }
+    // repeating timers continue with one shot OS timers like timers with slack
+    // the expiration of the adjusted interval becomes the base for the next intervals
+    _coalesced = repeat;
+    _slackDue = static_cast<uint32_t>(deadline);
+    __Scheduler._updateDeadline(this, deadline);
+    if (deadline <= now) {
+        // expired while the clock was stopped, execute with the next Scheduler::run()
+        __Scheduler._pushPending(this);
+    }
+    else {
+        _etsTimer.arm(std::max<uint32_t>(kMinDelay, static_cast<uint32_t>(deadline - now)), false, true);
+    }
+}
+
+uint32_t CallbackTimer::_getCoalescedDelay() const
+{
+    uint32_t grid = 1;
+    while(grid <= (_slack >> 1)) {
+        grid <<= 1;
+    }
+    // millis() overflows at a multiple of grid, the alignment is not affected
+    uint32_t expires = _slackDue + _slack;
+    expires -= expires & (grid - 1);
+    return std::max<int32_t>(kMinDelay, static_cast<int32_t>(expires - millis()));
+}
+
 #if DEBUG_EVENT_SCHEDULER
 
 #include <PrintString.h>
@@ -0,0 +1,218 @@
+/**
+  Author: sascha_lammers@gmx.de
+*/
+
+#include "Coroutine.h"
+#include "EventScheduler.h"
+#include "LoopFunctions.h"
+#include "SleepPlanner.h"
+
+#if DEBUG_EVENT_SCHEDULER
+#    include <debug_helper_enable.h>
+#else
+#    include <debug_helper_disable.h>
+#endif
+
+#ifndef _MSC_VER
+#    pragma GCC push_options
+#    pragma GCC optimize("O3")
+#endif
+
+using namespace Event;
+
+namespace {
+
+    struct CoroutineFrame {
+        typename std::aligned_storage<Coroutine::kFrameSize, alignof(std::max_align_t)>::type _storage;
+    };
+
+    using CoroutineAllocator = SlabAllocator<CoroutineFrame, EVENT_SCHEDULER_COROUTINE_POOL_CHUNK_SIZE>;
+
+}
+
+Coroutine *Coroutine::_readyHead = nullptr;
+Coroutine *Coroutine::_readyTail = nullptr;
+Coroutine *Coroutine::_current = nullptr;
+size_t Coroutine::_count = 0;
+
+Completion::~Completion()
+{
+    if (_waiter) {
+        _waiter->_completion = nullptr;
+    }
+}
+
+void Completion::complete()
+{
+    _done = true;
+    if (_waiter) {
+        auto waiter = _waiter;
+        _waiter = nullptr;
+        waiter->_completion = nullptr;
+        waiter->_setReady();
+    }
+}
+
+void *Coroutine::operator new(size_t size)
+{
+    return CoroutineAllocator::allocate(size);
+}
+
+void Coroutine::operator delete(void *ptr, size_t size)
+{
+    CoroutineAllocator::deallocate(ptr, size);
+}
+
+SlabPoolStats Coroutine::getPoolStats()
+{
+    return CoroutineAllocator::getStats();
+}
+
+Coroutine::Coroutine(PriorityType priority) :
+    _line(0),
+    _completion(nullptr),
+    _readyNext(nullptr),
+    _interval(0),
+    _ticks(0),
+    _priority(priority),
+    _wait(WaitType::NONE),
+    _ready(false),
+    _cancelled(false)
+{
+    EVENT_SCHEDULER_ASSERT(priority != PriorityType::TIMER);
+    if (_count++ == 0) {
+        // the loop function is installed while any coroutine exists. it is skipped by the sleep planner
+        // while no coroutine is ready
+        LoopFunctions::add(run);
+        #if !DISABLE_GLOBAL_EVENT_SCHEDULER
+            SleepPlanner::addWakeSource(&_readyHead, []() {
+                return isReady();
+            }, nullptr, run);
+        #endif
+    }
+}
+
+Coroutine::~Coroutine()
+{
+    _detach();
+    if (--_count == 0) {
+        LoopFunctions::remove(run);
+        #if !DISABLE_GLOBAL_EVENT_SCHEDULER
+            SleepPlanner::removeWakeSource(&_readyHead);
+        #endif
+    }
+}
+
+void Coroutine::cancel()
+{
+    _cancelled = true;
+    if (_ready || _current == this) {
+        // deleted by run()
+        return;
+    }
+    delete this;
+}
+
+void Coroutine::run()
+{
+    // coroutines that become ready while running are resumed by the next call
+    auto coroutine = _readyHead;
+    _readyHead = nullptr;
+    _readyTail = nullptr;
+    while(coroutine) {
+        auto next = coroutine->_readyNext;
+        coroutine->_readyNext = nullptr;
+        coroutine->_ready = false;
+        coroutine->_wait = WaitType::NONE;
+        auto state = StateType::DONE;
+        if (!coroutine->_cancelled) {
+            _current = coroutine;
+            state = coroutine->resume();
+            _current = nullptr;
+        }
+        if (state == StateType::DONE || coroutine->_cancelled) {
+            delete coroutine;
+        }
+        coroutine = next;
+    }
+}
+
+void Coroutine::_awaitLoop()
+{
+    _wait = WaitType::LOOP;
+    _setReady();
+}
+
+void Coroutine::_awaitDelay(uint32_t delayMillis)
+{
+    _interval = 0;
+    _ticks = 0;
+    _wait = WaitType::DELAY;
+    _timer.add(delayMillis, false, [this](CallbackTimerPtr) {
+        if (_wait == WaitType::DELAY) {
+            _setReady();
+        }
+    }, _priority);
+}
+
+bool Coroutine::_awaitTimer(uint32_t intervalMillis)
+{
+    if (_interval != intervalMillis || !_timer) {
+        _interval = intervalMillis;
+        _ticks = 0;
+        _timer.add(intervalMillis, true, [this](CallbackTimerPtr) {
+            if (_ticks < 0xffff) {
+                _ticks++;
+            }
+            if (_wait == WaitType::TIMER) {
+                _setReady();
+            }
+        }, _priority);
+    }
+    if (_ticks) {
+        _ticks--;
+        return true;
+    }
+    _wait = WaitType::TIMER;
+    return false;
+}
+
+bool Coroutine::_awaitCompletion(Completion &completion)
+{
+    if (completion._done) {
+        return true;
+    }
+    EVENT_SCHEDULER_ASSERT(completion._waiter == nullptr || completion._waiter == this);
+    completion._waiter = this;
+    _completion = &completion;
+    _wait = WaitType::COMPLETION;
+    return false;
+}
+
+void Coroutine::_setReady()
+{
+    if (_ready) {
+        return;
+    }
+    _ready = true;
+    if (_readyTail) {
+        _readyTail->_readyNext = this;
+    }
+    else {
+        _readyHead = this;
+    }
+    _readyTail = this;
+}
+
+void Coroutine::_detach()
+{
+    if (_completion) {
+        _completion->_waiter = nullptr;
+        _completion = nullptr;
+    }
+    _timer.remove();
+}
+
+#ifndef _MSC_VER
+#    pragma GCC pop_options
+#endif
@@ -3,6 +3,7 @@
 */
 
 #include "LoopFunctions.h"
+#include <algorithm>
 
 #if DEBUG_LOOP_FUNCTIONS
 #    include <debug_helper_enable.h>
@@ -15,25 +16,214 @@
 #    pragma GCC optimize("O3")
 #endif
 
-LoopFunctions::FunctionsVector LoopFunctions::_functions;
+LoopFunctions::FunctionsMap LoopFunctions::_functions;
+LoopFunctions::IndexMap LoopFunctions::_index;
+std::vector<LoopFunctions::KeyType> LoopFunctions::_removed;
+std::vector<LoopFunctions::Entry> LoopFunctions::_added;
+bool LoopFunctions::_running = false;
+stdex::mpsc_ring_buffer<LoopFunctions::CallbackPtr, LOOP_FUNCTIONS_CALL_ONCE_RETRY_SIZE> LoopFunctions::_callOnceRetry;
 
-#if _MSC_VER || ESP32
+void LoopFunctions::clear()
+{
+    _added.clear();
+    if (_running) {
+        for(size_t i = 0; i < _functions.size(); i++) {
+            auto &entry = _functions[i];
+            if (!entry.deleteCallback) {
+                entry.deleteCallback = true;
+                _removed.push_back(_functions.key_at(i));
+            }
+        }
+        return;
+    }
+    _functions.clear();
+    _index.clear();
+    _removed.clear();
+}
+
+void LoopFunctions::add(Callback callback, CallbackPtr callbackPtr LOOP_FUNCTIONS_DEBUG_ARGS)
+{
+    auto iterator = _index.find(callbackPtr);
+    if (iterator != _index.end()) {
+        auto entry = _functions.find(iterator->second);
+        if (!entry) {
+            // the entry has been erased without remove()
+            _removeStaleKey(iterator->second);
+        }
+        else {
+            // removed and added again before it has been erased
+            if (entry->deleteCallback) {
+                entry->deleteCallback = false;
+                _removed.erase(std::find(_removed.begin(), _removed.end(), iterator->second));
+            }
+            return;
+        }
+    }
+    if (std::find(_added.begin(), _added.end(), callbackPtr) != _added.end()) {
+        return;
+    }
+    Entry entry(callback, callbackPtr, false);
+    #if DEBUG_LOOP_FUNCTIONS
+        entry._source = source;
+        entry._line = line;
+    #endif
+    if (_running) {
+        // the storage cannot be modified while a callback is executed
+        _added.emplace_back(std::move(entry));
+        return;
+    }
+    _index.emplace(callbackPtr, _functions.insert(std::move(entry)));
+}
+
+void LoopFunctions::remove(CallbackPtr callbackPtr)
+{
+    auto iterator = _index.find(callbackPtr);
+    if (iterator == _index.end()) {
+        auto added = std::find(_added.begin(), _added.end(), callbackPtr);
+        if (added != _added.end()) {
+            _added.erase(added);
+        }
+        return;
+    }
+    // the entry is erased by run() or cleanUp(). loops that iterate getVector() skip it and the position of the
+    // other entries does not change
+    auto entry = _functions.find(iterator->second);
+    if (!entry) {
+        _removeStaleKey(iterator->second);
+        return;
+    }
+    if (!entry->deleteCallback) {
+        entry->deleteCallback = true;
+        _removed.push_back(iterator->second);
+    }
+}
+
+void LoopFunctions::cleanUp()
+{
+    if (_running) {
+        return;
+    }
+    _applyDeferred();
+}
+
+bool LoopFunctions::callOnce(CallbackPtr callback)
+{
+    if (schedule_function(callback)) {
+        return true;
+    }
+    __LDBG_printf("schedule_function() failed, callback=%p retried by run()", callback);
+    return _callOnceRetry.push(callback);
+}
+
+void LoopFunctions::run()
+{
+    if (_running) {
+        return;
+    }
+    // functions that could not be scheduled
+    CallbackPtr callback;
+    for(auto count = _callOnceRetry.size(); count && _callOnceRetry.pop(callback); count--) {
+        callback();
+    }
+    _running = true;
+    // the size does not change during the pass
+    for(size_t i = 0; i < _functions.size(); i++) {
+        auto &entry = _functions[i];
+        if (entry.deleteCallback) {
+            continue;
+        }
+        #if LOOP_FUNCTIONS_PROFILER
+            uint32_t start = micros();
+            entry.callback();
+            entry._profile.add(micros() - start);
+        #else
+            entry.callback();
+        #endif
+    }
+    _running = false;
+    _applyDeferred();
+}
 
-#include <vector>
+void LoopFunctions::_applyDeferred()
+{
+    auto removed = std::move(_removed);
+    _removed.clear();
+    for(const auto key: removed) {
+        auto entry = _functions.find(key);
+        if (!entry) {
+            _removeStaleKey(key);
+            continue;
+        }
+        _index.erase(entry->callbackPtr);
+        _functions.erase(key);
+    }
+    for(auto &entry: _added) {
+        auto callbackPtr = entry.callbackPtr;
+        _index.emplace(callbackPtr, _functions.insert(std::move(entry)));
+    }
+    _added.clear();
+}
 
-#define SCHEDULED_FN_MAX_COUNT 32
+void LoopFunctions::_removeStaleKey(KeyType key)
+{
+    __LDBG_printf("loop function key=%u:%u does not exist", key.index, key.generation);
+    auto removed = std::find(_removed.begin(), _removed.end(), key);
+    if (removed != _removed.end()) {
+        _removed.erase(removed);
+    }
+    for(auto iterator = _index.begin(); iterator != _index.end(); ++iterator) {
+        if (iterator->second == key) {
+            _index.erase(iterator);
+            break;
+        }
+    }
+}
 
-std::vector<std::function<void(void)>> scheduled_functions;
+#if LOOP_FUNCTIONS_PROFILER
 
-bool IRAM_ATTR schedule_function (const std::function<void(void)> &fn)
+void LoopFunctions::clearProfile()
 {
-    if (fn) {
-        if (scheduled_functions.size() < SCHEDULED_FN_MAX_COUNT) {
-            scheduled_functions.emplace_back(fn);
-            return true;
+    for(auto &entry: _functions) {
+        entry._profile = Profile();
+    }
+}
+
+void LoopFunctions::dumpProfile(Print &output)
+{
+    output.print(F("{\"functions\":["));
+    for(size_t i = 0; i < _functions.size(); i++) {
+        const auto &entry = _functions[i];
+        const auto &profile = entry._profile;
+        output.printf_P(PSTR("%s{\"id\":\"%p\",\"calls\":%u,\"total\":%.0f,\"avg\":%u,\"max\":%u}"),
+            i ? "," : "", reinterpret_cast<const void *>(entry.callbackPtr), profile.calls, profile.totalRuntime / 1.0, profile.getAvgRuntime(), profile.maxRuntime
+        );
+    }
+    output.println(F("]}"));
+}
+
+const LoopFunctions::Entry *LoopFunctions::getSlowest()
+{
+    const Entry *slowest = nullptr;
+    for(const auto &entry: _functions) {
+        if (!slowest || entry._profile.maxRuntime > slowest->_profile.maxRuntime) {
+            slowest = &entry;
         }
     }
-    return false;
+    return slowest;
+}
+
+#endif
+
+#if _MSC_VER || ESP32
+
+ScheduledFunctionQueue scheduled_functions;
+
+bool IRAM_ATTR schedule_function(ScheduledFunction fn)
+{
+    if (!fn) {
+        return false;
+    }
+    return scheduled_functions.push(std::move(fn));
 }
 
 #endif
@@ -37,8 +37,11 @@ void ICACHE_FLASH_ATTR OSTimer::_OSTimerCallback(OSTimer *timer)
 
 void dumpTimers(Print &output)
 {
-    ETSTimer *cur = timer_list;
-    while(cur) {
+    #if EVENT_SCHEDULER_SIMULATED_CLOCK
+        for(const auto cur: Event::SimulatedClock::getArmedTimers()) {
+    #else
+        for(ETSTimer *cur = timer_list; cur; cur = cur->timer_next) {
+    #endif
         void *callback = nullptr;
         for(const auto timer: __Scheduler.__getTimers()) {
             if (reinterpret_cast<ETSTimer *>(&timer->_etsTimer) == cur) {
@@ -83,8 +86,6 @@ void dumpTimers(Print &output)
         #endif
 
         output.println();
-
-        cur = cur->timer_next;
     }
     #if DEBUG_EVENT_SCHEDULER
         output.println(F("Event::Scheduler"));
@@ -50,7 +50,7 @@ using namespace Event;
  * - min. interval 5 (ESP8266) / 1 (ESP32) millisecond or 100 microseconds for PriorityType::TIMER
  */
 
-CallbackTimer *Scheduler::_add(const char *name, int64_t delay, RepeatType repeat, Callback callback, PriorityType priority)
+CallbackTimer *Scheduler::_add(const char *name, int64_t delay, RepeatType repeat, Callback callback, PriorityType priority, uint32_t slackMillis, TimerHandle *handle)
 {
     #if DEBUG_OSTIMER
         auto nameStr = PrintString(F("%s(%s:%u)"), name, DebugContext::__pos._file, DebugContext::__pos._line);
@@ -62,8 +62,12 @@ CallbackTimer *Scheduler::_add(const char *name, int64_t delay, RepeatType repea
 
     auto timerPtr = new CallbackTimer(name, callback, delay, repeat, priority);
     MUTEX_LOCK_BLOCK(_lock) {
-        _timers.push_back(timerPtr);
-        _addedFlag = true;
+        EVENT_SCHEDULER_ASSERT(_timers.size() < TimerVector::kMaxSize);
+        timerPtr->_handle = _timers.insert(timerPtr);
+    }
+    if (handle) {
+        // a timer with PriorityType::TIMER might be removed before _add() returns
+        *handle = timerPtr->_handle;
     }
 
     #if DEBUG_EVENT_SCHEDULER
@@ -74,6 +78,7 @@ CallbackTimer *Scheduler::_add(const char *name, int64_t delay, RepeatType repea
     #endif
 
     MUTEX_LOCK_BLOCK(timerPtr->getLock()) {
+        timerPtr->_slack = slackMillis;
         timerPtr->_rearm();
     }
     return timerPtr;
@@ -85,58 +90,99 @@ void Scheduler::end()
     // disarm all timers to ensure __TimerCallback is not called while deleting them
     MUTEX_LOCK_BLOCK(_lock) {
         for(const auto &timer: _timers) {
-            if (timer) {
-                MUTEX_LOCK_BLOCK(timer->getLock()) {
-                    timer->_disarm();
-                    timer->_releaseManagedTimer();
-                }
+            MUTEX_LOCK_BLOCK(timer->getLock()) {
+                timer->_disarm();
+                timer->_releaseManagedTimer();
             }
         }
-        // move vector before deleting all CallbackTimer objects
-        auto tmp = std::move(_timers);
-        std::swap(_timers, tmp);
-        for(auto timer: tmp) {
-            if (timer) {
+    }
+    // wait for callbacks in progress without holding the lock, PriorityType::TIMER callbacks might acquire it
+    while(_timerContext.load(std::memory_order_acquire)) {
+        delay(1);
+    }
+    MUTEX_LOCK_BLOCK(_lock) {
+        // copy the timers before deleting all CallbackTimer objects. clearing the timers invalidates all handles
+        std::vector<CallbackTimerPtr> tmp(_timers.begin(), _timers.end());
+        _timers.clear();
+        for(auto &list: _readyLists) {
+            list = ReadyList();
+        }
+        MUTEX_LOCK_BLOCK(_deadlineLock) {
+            for(auto &heap: _deadlines) {
+                heap.clear();
+            }
+        }
+        // timers removed while pending are not part of _timers anymore
+        auto pending = _pendingList.exchange(nullptr);
+        while(pending) {
+            auto timer = pending;
+            pending = pending->_pendingNext;
+            if (timer->_removed) {
+                delete timer;
+            }
+        }
+        for(auto list: { _removedList.exchange(nullptr), _retiredList.exchange(nullptr) }) {
+            while(list) {
+                auto timer = list;
+                list = list->_pendingNext;
                 delete timer;
             }
         }
-        _size = 0;
+        for(auto timer: tmp) {
+            delete timer;
+        }
         _hasEvent = PriorityType::NONE;
-        _addedFlag = false;
-        _removedFlag = false;
-        // _checkTimers = false;
     }
 }
 
 bool Scheduler::_removeTimer(CallbackTimerPtr timer)
 {
     if (timer) {
-        MUTEX_LOCK_BLOCK(_lock) {
-            auto iterator = std::find(_timers.begin(), _timers.end(), timer);
-            EVENT_SCHEDULER_ASSERT(iterator != _timers.end());
-            if (iterator != _timers.end()) {
-                __LDBG_printf("timer=%p iterator=%p managed=%p %s:%u", timer, *iterator, timer->_timer, __S(timer->_file), timer->_line);
-                #if DEBUG_OSTIMER
-                    if (timer->_insideCallback) {
-                        ___DBG_printEtsTimer_E(timer->_etsTimer, PSTR("_removeTimer inside callback"));
-                    }
-                #endif
-                MUTEX_LOCK_BLOCK(timer->getLock()) {
-                    // disarm and delete
-                    timer->_disarm();
-                    timer->_etsTimer.done();
-                    // mark as deleted in vector and schedule cleanup
-                    *iterator = nullptr;
-                    _removedFlag = true;
-                    // _checkTimers = true;
+        // a stale pointer has a handle that does not match any timer
+        bool found = _removeTimer(timer->_handle);
+        EVENT_SCHEDULER_ASSERT(found);
+        if (!found) {
+            // __LDBG_printf(_VT100(bold_red) "timer=%p NOT FOUND" _VT100(reset), timer);
+            __DBG_assertf(false, "timer=%p NOT FOUND", timer);
+        }
+        return found;
+    }
+    return false;
+}
+
+bool Scheduler::_removeTimer(TimerHandle handle)
+{
+    MUTEX_LOCK_BLOCK(_lock) {
+        auto timerPtr = _timers.find(handle);
+        if (timerPtr) {
+            auto timer = *timerPtr;
+            __LDBG_printf("timer=%p handle=%u:%u managed=%p %s:%u", timer, handle.index, handle.generation, timer->_timer, __S(timer->_file), timer->_line);
+            #if DEBUG_OSTIMER
+                if (timer->_insideCallback) {
+                    ___DBG_printEtsTimer_E(timer->_etsTimer, PSTR("_removeTimer inside callback"));
                 }
-                delete timer;
-                return true;
+            #endif
+            MUTEX_LOCK_BLOCK(timer->getLock()) {
+                // disarm and delete
+                timer->_disarm();
+                timer->_etsTimer.done();
+                _unlinkReady(timer);
+                // the handle and all copies of it become invalid
+                _timers.erase(handle);
             }
-            else {
-                // __LDBG_printf(_VT100(bold_red) "timer=%p NOT FOUND" _VT100(reset), timer);
-                __DBG_assertf(false, "timer=%p NOT FOUND", timer);
+            // detach the Timer object now, deleting the timer is deferred
+            timer->_releaseManagedTimer();
+            timer->_removed = true;
+            if (!timer->_pending.exchange(true)) {
+                // _pending is set now and the timer context cannot queue it anymore
+                timer->_pendingNext = _removedList.load(std::memory_order_relaxed);
+                _removedList.store(timer, std::memory_order_relaxed);
             }
+            // else: the timer is still in the pending list and moved to _removedList by _drainPending()
+            //
+            // the OS timer is disarmed, but the timer context might be inside __TimerCallback() already. the timer
+            // is deleted by _deleteRemoved() once this cannot be the case anymore
+            return true;
         }
     }
     return false;
@@ -161,100 +207,193 @@ static void __dump(Event::TimerVector &timers)
 
 #endif
 
-void Event::Scheduler::_sort()
+bool Scheduler::_drainPending()
+{
+    if (_pendingList.load(std::memory_order_relaxed) == nullptr) {
+        if (_removedList.load(std::memory_order_relaxed) || _retiredList.load(std::memory_order_relaxed)) {
+            _deleteRemoved();
+        }
+        return false;
+    }
+    // take the entire list with a single atomic operation
+    auto timer = _pendingList.exchange(nullptr, std::memory_order_acquire);
+    // the timers have been pushed to the front of the list, restore the order they have been triggered
+    CallbackTimerPtr list = nullptr;
+    while(timer) {
+        auto next = timer->_pendingNext;
+        timer->_pendingNext = list;
+        list = timer;
+        timer = next;
+    }
+    MUTEX_LOCK_BLOCK(_lock) {
+        while(list) {
+            timer = list;
+            list = timer->_pendingNext;
+            if (timer->_removed) {
+                // _pending stays set, deleted by _deleteRemoved()
+                timer->_pendingNext = _removedList.load(std::memory_order_relaxed);
+                _removedList.store(timer, std::memory_order_relaxed);
+                continue;
+            }
+            timer->_pendingNext = nullptr;
+            // the timer can be queued again once _pending has been cleared
+            timer->_pending = false;
+            if (timer->_callbackScheduled) {
+                _pushReady(timer);
+            }
+            // else: disarmed while pending
+        }
+    }
+    _deleteRemoved();
+    return true;
+}
+
+void Scheduler::_deleteRemoved()
+{
+    // a timer that has been removed while the timer context was about to enter __TimerCallback() must not be
+    // deleted before the callback has returned. the timers are retired by the first call that does not find any
+    // callback in progress and deleted by the next one
+    if (_timerContext.load(std::memory_order_acquire)) {
+        return;
+    }
+    CallbackTimerPtr list = nullptr;
+    MUTEX_LOCK_BLOCK(_lock) {
+        list = _retiredList.exchange(_removedList.exchange(nullptr, std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    while(list) {
+        auto timer = list;
+        list = list->_pendingNext;
+        delete timer;
+    }
+}
+
+void Scheduler::_updateHasEvent()
+{
+    _hasEvent = PriorityType::NONE;
+    for(int8_t i = kReadyListCount - 1; i >= 0; i--) {
+        for(auto timer = _readyLists[i]._head; timer; timer = timer->_readyNext) {
+            if (timer->_callbackScheduled && timer->_priority > _hasEvent) {
+                _hasEvent = timer->_priority;
+            }
+        }
+        if (_hasEvent != PriorityType::NONE) {
+            break;
+        }
+    }
+}
+
+bool Scheduler::_runReadyList(uint8_t index, PriorityType runAbovePriority, uint32_t start, uint32_t runtimeLimit)
 {
-    // sort by priority and move all nullptr to the end for removal
-    // if size() has changed, new timers have been added
-    __LDBG_printf("size=%u timers=%u", _size, _timers.size());
-
-    std::sort(_timers.begin(), _timers.end(), [](const CallbackTimerPtr a, const CallbackTimerPtr b) {
-        return (a && b) ? (b->_priority < a->_priority) : (b < a)/* move nullptr to the end */;
-    });
-    // remove all null pointers with std::find() since they have been moved to the end of the vector already
-    _timers.erase(std::find(_timers.begin(), _timers.end(), nullptr), _timers.end());
-    _timers.shrink_to_fit();
-    _size = static_cast<int16_t>(_timers.size());
-    _addedFlag = false;
-    _removedFlag = false;
+    auto &list = _readyLists[index];
+    uint16_t count = 0;
+    MUTEX_LOCK_BLOCK(_lock) {
+        // timers that are added while running are executed in the next call
+        count = list._count;
+    }
+    while(count--) {
+        CallbackTimerPtr timer = nullptr;
+        MUTEX_LOCK_BLOCK(_lock) {
+            timer = list._head;
+            if (timer) {
+                if (runtimeLimit && timer->_priority <= PriorityType::NORMAL && get_time_since(start, millis()) > runtimeLimit) {
+                    __LDBG_printf(_VT100(bold_red) "runtime limit=%u exceeded=%u" _VT100(reset), runtimeLimit, get_time_since(start, millis()));
+                    return false;
+                }
+                _unlinkReady(timer);
+                if (!timer->_callbackScheduled) {
+                    // disarmed after being queued
+                    timer = nullptr;
+                }
+                else if (timer->_priority <= runAbovePriority) {
+                    // priority not selected, move to the end of the list
+                    _linkReady(timer);
+                    timer = nullptr;
+                }
+                else {
+                    timer->_callbackScheduled = false;
+                }
+            }
+        }
+        if (!timer) {
+            continue;
+        }
+        _invokeCallback(timer, timer->_runtimeLimit(timer->_priority));
+        #if ESP32 && defined(CONFIG_HEAP_POISONING_COMPREHENSIVE)
+            heap_caps_check_integrity_all(true);
+        #endif
+    }
+    return true;
 }
 
 void Scheduler::_run()
 {
     // low priority run
+    _drainPending();
     // any events scheduled?
     if (_hasEvent != PriorityType::NONE) {
         uint32_t start = millis();
-        uint32_t timeout = start + _runtimeLimit; // time limit for PriorityType::NORMAL and below
-        for (int i = 0; i < _size; i++) {
-            auto timer = _timers[i];
-            if (timer) {
-                if (timer->_priority <= PriorityType::NORMAL && millis() > timeout) {
-                    __LDBG_printf(_VT100(bold_red) "runtime limit=%u exceeded=%u" _VT100(reset), _runtimeLimit, millis() - start);
-                    break;
-                }
-                if (timer->_callbackScheduled) {
+        #if EVENT_SCHEDULER_PROFILER
+            uint32_t startMicros = micros();
+        #endif
+        // process ready lists from highest to lowest priority
+        for(int8_t i = kReadyListCount - 1; i >= 0; i--) {
+            if (!_runReadyList(i, kRunAllPriorities, start, _runtimeLimit)) {
+                #if EVENT_SCHEDULER_PROFILER
+                    _profile.deferredRuns++;
                     MUTEX_LOCK_BLOCK(_lock) {
-                        timer->_callbackScheduled = false;
+                        for(int8_t j = i; j >= 0; j--) {
+                            _profile.deferredCallbacks += _readyLists[j]._count;
+                        }
                     }
-                    _invokeCallback(timer, timer->_runtimeLimit(timer->_priority));
-                }
+                #endif
+                break;
             }
         }
 
         // reset event flag
         MUTEX_LOCK_BLOCK(_lock) {
-            _hasEvent = PriorityType::NONE;
-            for (const auto &timer : _timers) {
-                if (timer && timer->_callbackScheduled && timer->_priority > _hasEvent) {
-                    _hasEvent = timer->_priority;
-                }
-            }
+            _updateHasEvent();
         }
-    }
 
-    // sort new timers and remove null pointers
-    if (_addedFlag || _removedFlag) {
-        MUTEX_LOCK_BLOCK(_lock) {
-            if (_addedFlag) {
-                // sort by priority and remove deleted timers
-                _sort();
-            }
-            else if (_removedFlag) {
-                // remove deleted timers pointers
-                _cleanup();
-            }
-        }
+        #if EVENT_SCHEDULER_PROFILER
+            _profile.runs++;
+            _profile.maxRuntime = std::max(_profile.maxRuntime, get_time_since(startMicros, micros()));
+        #endif
     }
 }
 
 void Scheduler::__TimerCallback(CallbackTimerPtr timer)
 {
+    // removed timers are not deleted while any callback is in progress
+    __Scheduler._timerContext.fetch_add(1, std::memory_order_acquire);
     if (timer->_priority == PriorityType::TIMER) {
         // PriorityType::TIMER invoke now
+        #if EVENT_SCHEDULER_PROFILER
+            timer->_triggeredMicros = micros();
+        #endif
         __Scheduler._invokeCallback(timer, kMaxRuntimePrioTimer);
     }
     else {
-        MUTEX_LOCK_BLOCK(_Scheduler.getLock()) {
-            #if SCHEDULER_HAVE_REMAINING_DELAY
-                if (timer->_remainingDelay > 0) {
-                    // continue with remaining delay
-                    MUTEX_LOCK_BLOCK(timer->getLock()) {
-                        uint32_t delay = (--timer->_remainingDelay) ? kMaxDelay : (timer->_delay % kMaxDelay);
-                        timer->_etsTimer.disarm();
-                        timer->_etsTimer.arm(delay, false, true);
-                    }
-                }
-                else
-            #endif
-            {
-                // schedule for execution in main loop
-                timer->_callbackScheduled = true;
-                if (timer->_priority > __Scheduler._hasEvent) {
-                    __Scheduler._hasEvent = timer->_priority;
+        #if SCHEDULER_HAVE_REMAINING_DELAY
+            if (timer->_remainingDelay > 0) {
+                // continue with remaining delay
+                MUTEX_LOCK_BLOCK(timer->getLock()) {
+                    uint32_t delay = (--timer->_remainingDelay) ? kMaxDelay : (timer->_delay % kMaxDelay);
+                    timer->_etsTimer.disarm();
+                    timer->_etsTimer.arm(delay, false, true);
                 }
             }
+            else
+        #endif
+        {
+            // schedule for execution in main loop, lock-free
+            #if EVENT_SCHEDULER_PROFILER
+                timer->_triggeredMicros = micros();
+            #endif
+            __Scheduler._pushPending(timer);
         }
     }
+    __Scheduler._timerContext.fetch_sub(1, std::memory_order_release);
 }
 
 void Scheduler::_invokeCallback(CallbackTimerPtr timer, uint32_t runtimeLimit)
@@ -263,10 +402,11 @@ void Scheduler::_invokeCallback(CallbackTimerPtr timer, uint32_t runtimeLimit)
     // _checkTimers = false;
 
     String fpos = timer->__getFilePos();
-    uint32_t start = runtimeLimit ? micros() : 0;
+    uint32_t start = (runtimeLimit || EVENT_SCHEDULER_PROFILER) ? micros() : 0;
 
     __LDBG_printf("%s", fpos.c_str());
 
+    bool removed = false;
     MUTEX_LOCK_BLOCK(timer->getLock()) {
         bool locked = timer->_etsTimer.isLocked();
         if (locked) {
@@ -284,15 +424,34 @@ void Scheduler::_invokeCallback(CallbackTimerPtr timer, uint32_t runtimeLimit)
             timer->_callback(timer);
             __lock.lock();
             timer->_insideCallback = false;
-            // check if it was unlocked inside the callback
-            if (timer->_etsTimer.isLocked()) {
-                timer->_etsTimer.unlock();
+            if (timer->_removed) {
+                // the handle was removed inside the callback, the timer is disarmed and waiting to be deleted
+                removed = true;
+            }
+            else {
+                if (timer->_throttled) {
+                    // disarm, just one call
+                    timer->_throttled = false;
+                    timer->_disarm();
+                }
+                // check if it was unlocked inside the callback
+                if (timer->_etsTimer.isLocked()) {
+                    timer->_etsTimer.unlock();
+                }
             }
         }
     }
-    uint32_t diff = runtimeLimit ? get_time_since(start, micros()) : 0;
+    if (removed) {
+        __LDBG_printf("timer=%p removed inside callback%s", timer, fpos.c_str());
+        return;
+    }
+    uint32_t diff = (runtimeLimit || EVENT_SCHEDULER_PROFILER) ? get_time_since(start, micros()) : 0;
+
+    #if EVENT_SCHEDULER_PROFILER
+        timer->_profile.add(diff, get_time_since(timer->_triggeredMicros, start));
+    #endif
 
-    if (diff > runtimeLimit) {
+    if (runtimeLimit && diff > runtimeLimit) {
         __LDBG_printf(_VT100(bold_red) "timer=%p time=%u limit=%u exceeded%s" _VT100(reset), timer, diff, runtimeLimit, fpos.c_str());
     }
 
@@ -311,7 +470,37 @@ void Scheduler::_invokeCallback(CallbackTimerPtr timer, uint32_t runtimeLimit)
     //     return;
     // }
 
-    if (timer->isArmed() == false) { // check if timer is still armed
+    #if SCHEDULER_HAVE_REMAINING_DELAY
+        if (timer->_maxDelayExceeded) {
+            // the OS timer is not repeating if max delay is exceeded and isArmed() is false
+            // _maxDelayExceeded is cleared if the timer has been disarmed inside the callback
+            __LDBG_printf("timer=%p armed=%u cb=%p %s:%u", timer, timer->isArmed(), lambda_target(timer->_callback), __S(timer->_file), timer->_line);
+            if (timer->_repeat._doRepeat() == false) {
+                _removeTimer(timer);
+            }
+            else {
+                // if max delay is exceeded we need to manually reschedule
+                MUTEX_LOCK_BLOCK(timer->getLock()) {
+                    timer->_disarm();
+                    timer->_rearm();
+                }
+            }
+        }
+        else
+    #endif
+    if (timer->_coalesced) {
+        // the OS timer is not repeating for timers with slack
+        // _coalesced is cleared if the timer has been disarmed inside the callback
+        if (timer->_repeat._doRepeat() == false) {
+            _removeTimer(timer);
+        }
+        else {
+            MUTEX_LOCK_BLOCK(timer->getLock()) {
+                timer->_rearmCoalesced();
+            }
+        }
+    }
+    else if (timer->isArmed() == false) { // check if timer is still armed
         __LDBG_printf("timer=%p armed=%u cb=%p %s:%u", timer, timer->isArmed(), lambda_target(timer->_callback), __S(timer->_file), timer->_line);
         // remove disarmed timer
         _removeTimer(timer);
@@ -320,16 +509,136 @@ void Scheduler::_invokeCallback(CallbackTimerPtr timer, uint32_t runtimeLimit)
         __LDBG_printf("timer=%p armed=%u cb=%p %s:%u", timer, timer->isArmed(), lambda_target(timer->_callback), __S(timer->_file), timer->_line);
         _removeTimer(timer);
     }
-    #if SCHEDULER_HAVE_REMAINING_DELAY
-        else if (timer->_maxDelayExceeded) {
-            // if max delay is exceeded we need to manually reschedule
-            __LDBG_printf("timer=%p armed=%u cb=%p %s:%u", timer, timer->isArmed(), lambda_target(timer->_callback), __S(timer->_file), timer->_line);
+    else {
+        _advanceDeadline(timer);
+    }
+}
+
+uint32_t Scheduler::getNextDeadline(PriorityType priority)
+{
+    // the pending list is not sorted by priority
+    if (_pendingList.load(std::memory_order_relaxed) || (_hasEvent != PriorityType::NONE && _hasEvent >= priority)) {
+        return 0;
+    }
+    auto deadline = std::numeric_limits<uint64_t>::max();
+    MUTEX_LOCK_BLOCK(_deadlineLock) {
+        for(uint8_t i = _getReadyListIndex(priority); i < kReadyListCount; i++) {
+            if (!_deadlines[i].empty()) {
+                deadline = std::min(deadline, _deadlines[i].front()->_deadline);
+            }
+        }
+    }
+    if (deadline == std::numeric_limits<uint64_t>::max()) {
+        return kNoDeadline;
+    }
+    auto now = millis64();
+    if (deadline <= now) {
+        return 0;
+    }
+    return static_cast<uint32_t>(std::min<uint64_t>(deadline - now, kNoDeadline - 1));
+}
+
+void Scheduler::fastForward(uint32_t sleptMillis)
+{
+    __LDBG_printf("fast forward=%u", sleptMillis);
+    MUTEX_LOCK_BLOCK(_lock) {
+        auto now = millis64();
+        for(auto timer: _timers) {
             MUTEX_LOCK_BLOCK(timer->getLock()) {
-                timer->_disarm();
-                timer->_rearm();
+                timer->_fastForward(sleptMillis, now);
             }
         }
-    #endif
+    }
+}
+
+void Scheduler::_updateDeadline(CallbackTimerPtr timer, uint64_t deadline)
+{
+    MUTEX_LOCK_BLOCK(_deadlineLock) {
+        auto &heap = _deadlines[_getReadyListIndex(timer->_priority)];
+        timer->_deadline = deadline;
+        if (timer->_deadlineIndex == CallbackTimer::kNoDeadlineIndex) {
+            heap.push_back(timer);
+            _siftUp(heap, heap.size() - 1);
+        }
+        else {
+            _siftUp(heap, timer->_deadlineIndex);
+            _siftDown(heap, timer->_deadlineIndex);
+        }
+    }
+}
+
+void Scheduler::_removeDeadline(CallbackTimerPtr timer)
+{
+    MUTEX_LOCK_BLOCK(_deadlineLock) {
+        uint32_t index = timer->_deadlineIndex;
+        if (index == CallbackTimer::kNoDeadlineIndex) {
+            return;
+        }
+        auto &heap = _deadlines[_getReadyListIndex(timer->_priority)];
+        auto last = heap.back();
+        heap.pop_back();
+        timer->_deadlineIndex = CallbackTimer::kNoDeadlineIndex;
+        if (last != timer) {
+            // replace with the last timer
+            heap[index] = last;
+            _siftUp(heap, index);
+            _siftDown(heap, last->_deadlineIndex);
+        }
+    }
+}
+
+void Scheduler::_advanceDeadline(CallbackTimerPtr timer)
+{
+    MUTEX_LOCK_BLOCK(_deadlineLock) {
+        auto now = millis64();
+        if (timer->_deadlineIndex == CallbackTimer::kNoDeadlineIndex || timer->_deadline > now) {
+            // disarmed or rearmed inside the callback
+            return;
+        }
+        // the OS timer might have been triggered more than once before the callback was executed
+        uint64_t interval = std::max<int64_t>(1, timer->_delay);
+        timer->_deadline += ((now - timer->_deadline) / interval + 1) * interval;
+        _siftDown(_deadlines[_getReadyListIndex(timer->_priority)], timer->_deadlineIndex);
+    }
+}
+
+void Scheduler::_siftUp(DeadlineHeap &heap, uint32_t index)
+{
+    auto timer = heap[index];
+    while(index) {
+        uint32_t parent = (index - 1) >> 1;
+        if (heap[parent]->_deadline <= timer->_deadline) {
+            break;
+        }
+        heap[index] = heap[parent];
+        heap[index]->_deadlineIndex = static_cast<uint16_t>(index);
+        index = parent;
+    }
+    heap[index] = timer;
+    timer->_deadlineIndex = static_cast<uint16_t>(index);
+}
+
+void Scheduler::_siftDown(DeadlineHeap &heap, uint32_t index)
+{
+    auto timer = heap[index];
+    uint32_t size = heap.size();
+    for(;;) {
+        uint32_t child = (index << 1) + 1;
+        if (child >= size) {
+            break;
+        }
+        if (child + 1 < size && heap[child + 1]->_deadline < heap[child]->_deadline) {
+            child++;
+        }
+        if (timer->_deadline <= heap[child]->_deadline) {
+            break;
+        }
+        heap[index] = heap[child];
+        heap[index]->_deadlineIndex = static_cast<uint16_t>(index);
+        index = child;
+    }
+    heap[index] = timer;
+    timer->_deadlineIndex = static_cast<uint16_t>(index);
 }
 
 #if DEBUG_EVENT_SCHEDULER
@@ -347,21 +656,54 @@ void Scheduler::__list(bool debug)
     }
     else {
         int scheduled = 0;
-        int deleted = 0;
         for(const auto timer: _timers) {
-            if (timer) {
-                output.printf_P(PSTR("ETSTimer=%p running=%u arg=%p managed=%p dly=%.0f (%.3fs) repeat=%d prio=%d scheduled=%d %s:%u\n"),
-                    &timer->_etsTimer, timer->_etsTimer.isRunning(), timer, timer->_timer, timer->_delay / 1.0, timer->_delay / 1000.0, timer->_repeat._repeat, timer->_priority, timer->_callbackScheduled, __S(timer->_file), timer->_line
-                );
-                if (timer->_callbackScheduled) {
-                    scheduled++;
-                }
+            output.printf_P(PSTR("ETSTimer=%p running=%u arg=%p managed=%p dly=%.0f (%.3fs) repeat=%d prio=%d scheduled=%d %s:%u\n"),
+                &timer->_etsTimer, timer->_etsTimer.isRunning(), timer, timer->_timer, timer->_delay / 1.0, timer->_delay / 1000.0, timer->_repeat._repeat, timer->_priority, timer->_callbackScheduled.load(), __S(timer->_file), timer->_line
+            );
+            if (timer->_callbackScheduled) {
+                scheduled++;
             }
-            else {
-                deleted++;
+        }
+        output.printf_P(PSTR("timers=%d scheduled=%d sizeof(EventTimer)=%u\n"), _timers.size(), scheduled, sizeof(CallbackTimer));
+        auto stats = CallbackTimer::getPoolStats();
+        output.printf_P(PSTR("pool live=%u peak=%u chunks=%u free=%u\n"), stats.live, stats.peak, stats.chunks, stats.free);
+    }
+}
+
+#endif
+
+#if EVENT_SCHEDULER_PROFILER
+
+void Scheduler::clearProfile()
+{
+    MUTEX_LOCK_BLOCK(_lock) {
+        _profile = SchedulerProfile();
+        for(const auto timer: _timers) {
+            timer->_profile = TimerProfile();
+        }
+    }
+}
+
+void Scheduler::dumpProfile(Print &output)
+{
+    MUTEX_LOCK_BLOCK(_lock) {
+        output.printf_P(PSTR("{\"runs\":%u,\"max_runtime\":%u,\"deferred_runs\":%u,\"deferred_callbacks\":%u,\"timers\":["),
+            _profile.runs, _profile.maxRuntime, _profile.deferredRuns, _profile.deferredCallbacks
+        );
+        for(size_t i = 0; i < _timers.size(); i++) {
+            auto timer = _timers[i];
+            const auto &profile = timer->_profile;
+            auto pos = timer->__getFilePos();
+            pos.trim();
+            output.printf_P(PSTR("%s{\"timer\":\"%p\",\"pos\":\"%s\",\"interval\":%.0f,\"priority\":%d,\"calls\":%u,\"total\":%.0f,\"avg\":%u,\"max\":%u,\"avg_jitter\":%u,\"max_jitter\":%u,\"histogram\":["),
+                i ? "," : "", timer, pos.c_str(), timer->_delay / 1.0, timer->_priority, profile.calls, profile.totalRuntime / 1.0, profile.getAvgRuntime(), profile.maxRuntime, profile.getAvgJitter(), profile.maxJitter
+            );
+            for(uint8_t j = 0; j < TimerProfile::kHistogramSize; j++) {
+                output.printf_P(PSTR("%s%u"), j ? "," : "", profile.histogram[j]);
             }
+            output.print(F("]}"));
         }
-        output.printf_P(PSTR("timers=%d scheduled=%d deleted=%d sizeof(EventTimer)=%u\n"), _timers.size(), scheduled, deleted, sizeof(CallbackTimer));
+        output.println(F("]}"));
     }
 }
 
@@ -0,0 +1,227 @@
+/**
+  Author: sascha_lammers@gmx.de
+*/
+
+#include "SimulatedClock.h"
+
+#if EVENT_SCHEDULER_SIMULATED_CLOCK
+
+#include <limits>
+#include <queue>
+#include <unordered_map>
+
+using namespace Event;
+
+namespace {
+
+    // the SDK stores the period in ticks of 3.2us
+    inline uint32_t toTicks(uint64_t micros)
+    {
+        return static_cast<uint32_t>(micros * 5 / 16);
+    }
+
+    // timer_next of a timer that is not in the timer list
+    inline ETSTimer *notQueued()
+    {
+        return reinterpret_cast<ETSTimer *>(0xffffffffU);
+    }
+
+    struct ArmedTimer {
+        uint64_t expires;
+        uint64_t period;                // 0 = one shot
+        uint32_t generation;
+    };
+
+    struct QueueItem {
+        uint64_t expires;
+        uint32_t sequence;              // keeps the order of timers with the same expiration
+        uint32_t generation;
+        ETSTimer *timer;
+
+        bool operator>(const QueueItem &item) const {
+            return (expires == item.expires) ? (sequence > item.sequence) : (expires > item.expires);
+        }
+    };
+
+    struct State {
+        uint64_t now;
+        uint32_t sequence;
+        uint32_t generation;
+        // the queue is not updated when a timer is disarmed. items are skipped if the generation does not match
+        std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+        std::unordered_map<ETSTimer *, ArmedTimer> armed;
+
+        State() : now(0), sequence(0), generation(0) {}
+
+        void push(ETSTimer *timer, const ArmedTimer &armedTimer) {
+            queue.push(QueueItem({armedTimer.expires, sequence++, armedTimer.generation, timer}));
+            timer->timer_expire = toTicks(armedTimer.expires);
+        }
+
+        // remove invalid items from the top of the queue
+        bool peek(QueueItem &item) {
+            while(!queue.empty()) {
+                item = queue.top();
+                auto iter = armed.find(item.timer);
+                if (iter != armed.end() && iter->second.generation == item.generation) {
+                    return true;
+                }
+                queue.pop();
+            }
+            return false;
+        }
+
+        // invoke all timers that expire at or before time
+        uint32_t run(uint64_t time) {
+            uint32_t count = 0;
+            QueueItem item;
+            while(peek(item) && item.expires <= time) {
+                queue.pop();
+                now = item.expires;
+                auto timer = item.timer;
+                auto iter = armed.find(timer);
+                if (iter->second.period) {
+                    iter->second.expires += iter->second.period;
+                    iter->second.generation = ++generation;
+                    push(timer, iter->second);
+                }
+                else {
+                    armed.erase(iter);
+                    timer->timer_next = notQueued();
+                }
+                // the callback might disarm, rearm or delete the timer
+                timer->timer_func(timer->timer_arg);
+                count++;
+            }
+            if (time > now) {
+                now = time;
+            }
+            return count;
+        }
+    };
+
+    State &getState()
+    {
+        static State state;
+        return state;
+    }
+
+}
+
+uint32_t Event::millis()
+{
+    return static_cast<uint32_t>(getState().now / 1000);
+}
+
+uint32_t Event::micros()
+{
+    return static_cast<uint32_t>(getState().now);
+}
+
+uint64_t Event::millis64()
+{
+    return getState().now / 1000;
+}
+
+uint64_t SimulatedClock::getMicros64()
+{
+    return getState().now;
+}
+
+uint32_t SimulatedClock::advance(uint64_t micros)
+{
+    auto &state = getState();
+    return state.run(state.now + micros);
+}
+
+uint32_t SimulatedClock::advanceMillis(uint64_t millis)
+{
+    return advance(millis * 1000);
+}
+
+bool SimulatedClock::step()
+{
+    auto expires = getNextExpiration();
+    if (expires == std::numeric_limits<uint64_t>::max()) {
+        return false;
+    }
+    getState().run(expires);
+    return true;
+}
+
+uint64_t SimulatedClock::getNextExpiration()
+{
+    QueueItem item;
+    return getState().peek(item) ? item.expires : std::numeric_limits<uint64_t>::max();
+}
+
+size_t SimulatedClock::getArmedCount()
+{
+    return getState().armed.size();
+}
+
+std::vector<ETSTimer *> SimulatedClock::getArmedTimers()
+{
+    std::vector<ETSTimer *> timers;
+    timers.reserve(getState().armed.size());
+    for(const auto &item: getState().armed) {
+        timers.push_back(item.first);
+    }
+    return timers;
+}
+
+void SimulatedClock::reset()
+{
+    auto &state = getState();
+    for(const auto &item: state.armed) {
+        item.first->timer_period = 0;
+        item.first->timer_next = notQueued();
+    }
+    state = State();
+}
+
+void SimulatedClock::timerSetfn(ETSTimer *timer, ETSTimerFunc *callback, void *arg)
+{
+    timerDisarm(timer);
+    timer->timer_func = callback;
+    timer->timer_arg = arg;
+    timer->timer_period = 0;
+    timer->timer_next = notQueued();
+}
+
+void SimulatedClock::timerArm(ETSTimer *timer, uint32_t time, bool repeat, bool isMillis)
+{
+    auto &state = getState();
+    uint64_t period = isMillis ? (time * 1000ULL) : time;
+    if (period == 0) {
+        period = 1;
+    }
+    auto &armedTimer = state.armed[timer];
+    armedTimer.expires = state.now + period;
+    armedTimer.period = repeat ? period : 0;
+    armedTimer.generation = ++state.generation;
+    state.push(timer, armedTimer);
+    // ETSTimerEx::isRunning() checks timer_period
+    timer->timer_period = repeat ? std::max<uint32_t>(1, toTicks(period)) : 0;
+    timer->timer_next = nullptr;
+}
+
+void SimulatedClock::timerDisarm(ETSTimer *timer)
+{
+    auto &state = getState();
+    auto iter = state.armed.find(timer);
+    if (iter != state.armed.end()) {
+        state.armed.erase(iter);
+        timer->timer_next = notQueued();
+    }
+    timer->timer_period = 0;
+}
+
+void SimulatedClock::timerDone(ETSTimer *timer)
+{
+    timerDisarm(timer);
+    timer->timer_func = nullptr;
+    timer->timer_arg = nullptr;
+}
+
+#endif
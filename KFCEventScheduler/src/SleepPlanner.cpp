@@ -0,0 +1,80 @@
+/**
+  Author: sascha_lammers@gmx.de
+*/
+
+#include "SleepPlanner.h"
+#include "Scheduler.h"
+
+#ifndef _MSC_VER
+#    pragma GCC push_options
+#    pragma GCC optimize("O3")
+#endif
+
+#if !DISABLE_GLOBAL_EVENT_SCHEDULER
+
+SleepPlanner::WakeSourceVector SleepPlanner::_wakeSources;
+
+void SleepPlanner::addWakeSource(const void *id, BusyCallback isBusy, PinMaskCallback getWakePinMask, LoopFunctions::CallbackPtr loopFunction)
+{
+    auto iterator = std::find(_wakeSources.begin(), _wakeSources.end(), id);
+    if (iterator == _wakeSources.end()) {
+        _wakeSources.emplace_back(id, isBusy, getWakePinMask, loopFunction);
+        return;
+    }
+    *iterator = WakeSource(id, isBusy, getWakePinMask, loopFunction);
+}
+
+void SleepPlanner::removeWakeSource(const void *id)
+{
+    auto iterator = std::find(_wakeSources.begin(), _wakeSources.end(), id);
+    if (iterator != _wakeSources.end()) {
+        _wakeSources.erase(iterator);
+    }
+}
+
+bool SleepPlanner::_isLoopFunctionRequired(const LoopFunctions::Entry &entry)
+{
+    if (entry.deleteCallback) {
+        return false;
+    }
+    // the loop function of an idle wake source can be skipped
+    return std::find_if(_wakeSources.begin(), _wakeSources.end(), [&entry](const WakeSource &source) {
+        return source.loopFunction == entry.callbackPtr;
+    }) == _wakeSources.end();
+}
+
+SleepPlanner::Plan SleepPlanner::getPlan(Event::PriorityType priority, uint32_t minSleepMillis)
+{
+    PinMaskType wakePinMask = 0;
+    for(const auto &source: _wakeSources) {
+        if (source.isBusy && source.isBusy()) {
+            return Plan(0, 0, ReasonType::WAKE_SOURCE);
+        }
+        if (source.getWakePinMask) {
+            wakePinMask |= source.getWakePinMask();
+        }
+    }
+    for(const auto &entry: LoopFunctions::getVector()) {
+        if (_isLoopFunctionRequired(entry)) {
+            return Plan(0, wakePinMask, ReasonType::LOOP_FUNCTIONS);
+        }
+    }
+    auto deadline = __Scheduler.getNextDeadline(priority);
+    if (deadline == 0 || deadline < minSleepMillis) {
+        return Plan(0, wakePinMask, ReasonType::TIMER);
+    }
+    return Plan(deadline, wakePinMask, ReasonType::NONE);
+}
+
+void SleepPlanner::wakeup(uint32_t sleptMillis)
+{
+    if (sleptMillis) {
+        __Scheduler.fastForward(sleptMillis);
+    }
+}
+
+#endif
+
+#ifndef _MSC_VER
+#    pragma GCC pop_options
+#endif
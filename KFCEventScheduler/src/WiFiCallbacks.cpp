@@ -3,6 +3,8 @@ Author: sascha_lammers@gmx.de
 */
 
 #include "WiFiCallbacks.h"
+#include "LoopFunctions.h"
+#include <algorithm>
 
 #if DEBUG_WIFICALLBACKS
 #    include <debug_helper_enable.h>
@@ -15,8 +17,199 @@ Author: sascha_lammers@gmx.de
 #    pragma GCC optimize("O3")
 #endif
 
-WiFiCallbacks::CallbackVector WiFiCallbacks::_callbacks;
-bool WiFiCallbacks::_locked = false;
+WiFiCallbacks::CallbackMap WiFiCallbacks::_callbacks;
+WiFiCallbacks::IndexMap WiFiCallbacks::_index;
+WiFiCallbacks::DispatchList WiFiCallbacks::_dispatch[WiFiCallbacks::kEventBits];
+std::vector<WiFiCallbacks::KeyType> WiFiCallbacks::_removed;
+std::vector<WiFiCallbacks::Entry> WiFiCallbacks::_added;
+WiFiCallbacks::EventQueue WiFiCallbacks::_queue;
+std::atomic_bool WiFiCallbacks::_queueScheduled(false);
+bool WiFiCallbacks::_dirty = false;
+uint8_t WiFiCallbacks::_locked = 0;
+
+void WiFiCallbacks::clear()
+{
+    _added.clear();
+    _dirty = true;
+    if (_locked) {
+        for(size_t i = 0; i < _callbacks.size(); i++) {
+            _callbacks[i].events = EventType::NONE;
+            _removed.push_back(_callbacks.key_at(i));
+        }
+        return;
+    }
+    _callbacks.clear();
+    _index.clear();
+    _removed.clear();
+}
+
+WiFiCallbacks::EventType WiFiCallbacks::add(EventType events, Callback callback, CallbackPtr callbackPtr)
+{
+    __SLDBG_printf("events=%u callbackPtr=%p callback=%p", events, callbackPtr, lambda_target(callback));
+
+    events = EventTypeEnum(events) & EventTypeEnum(EventType::ANY);
+    Entry *entry = nullptr;
+    auto iterator = _index.find(callbackPtr);
+    if (iterator != _index.end()) {
+        entry = _callbacks.find(iterator->second);
+    }
+    else {
+        auto added = std::find(_added.begin(), _added.end(), callbackPtr);
+        if (added != _added.end()) {
+            entry = &(*added);
+        }
+    }
+    if (entry) {
+        __SLDBG_printf("callbackPtr=%p, changed events from %u to %u", callbackPtr, entry->events, EventTypeEnum(entry->events) | EventTypeEnum(events));
+        entry->events = EventTypeEnum(entry->events) | EventTypeEnum(events);
+        _dirty = true;
+        return entry->events;
+    }
+    __SLDBG_printf("callbackPtr=%p new entry events %d", callbackPtr, events);
+    if (_locked) {
+        // the storage cannot be modified while a callback is executed
+        _added.emplace_back(events, callback, callbackPtr);
+        return events;
+    }
+    _index.emplace(callbackPtr, _callbacks.emplace(events, callback, callbackPtr));
+    _dirty = true;
+    return events;
+}
+
+WiFiCallbacks::EventType WiFiCallbacks::remove(EventType events, CallbackPtr callbackPtr)
+{
+    __SLDBG_printf("events=%u callbackPtr=%p", events, callbackPtr);
+    auto iterator = _index.find(callbackPtr);
+    if (iterator == _index.end()) {
+        auto added = std::find(_added.begin(), _added.end(), callbackPtr);
+        if (added == _added.end()) {
+            return EventType::CALLBACK_NOT_FOUND;
+        }
+        added->events = EventTypeEnum(added->events) & ~EventTypeEnum(events);
+        if (added->events == EventType::NONE) {
+            _added.erase(added);
+            return EventType::NONE;
+        }
+        return added->events;
+    }
+    auto key = iterator->second;
+    auto entry = _callbacks.find(key);
+    entry->events = EventTypeEnum(entry->events) & ~EventTypeEnum(events);
+    _dirty = true;
+    if (entry->events != EventType::NONE) {
+        return entry->events;
+    }
+    if (_locked) {
+        _removed.push_back(key);
+    }
+    else {
+        _callbacks.erase(key);
+        _index.erase(iterator);
+    }
+    return EventType::NONE;
+}
+
+void WiFiCallbacks::callEvent(EventType event, void *payload)
+{
+    __SLDBG_printf("event=%u payload=%p", event, payload);
+    // the dispatch lists cannot be rebuilt while a callback is executed. nested calls use the slot map, which is
+    // not modified before the outer call has returned
+    if (_dirty && !_locked) {
+        _rebuildDispatchLists();
+    }
+    auto invoke = [event, payload](const Entry &entry) {
+        // the events might have been removed by another callback
+        if (!(EventTypeEnum(entry.events) & EventTypeEnum(event))) {
+            return;
+        }
+        if (entry.callback) {
+            __SLDBG_printf("callback=%p", lambda_target(entry.callback));
+            entry.callback(event, payload);
+        }
+        else {
+            __SLDBG_printf("callbackPtr=%p", entry.callbackPtr);
+            entry.callbackPtr(event, payload);
+        }
+    };
+    _locked++;
+    auto bit = _getEventBit(event);
+    if (bit < kEventBits && !_dirty) {
+        for(const auto pos: _dispatch[bit]) {
+            invoke(_callbacks[pos]);
+        }
+    }
+    else {
+        // multiple event bits
+        for(const auto &entry: _callbacks) {
+            invoke(entry);
+        }
+    }
+    if (--_locked == 0) {
+        _applyDeferred();
+    }
+}
+
+bool WiFiCallbacks::queueEvent(EventType event, void *payload)
+{
+    if (!_queue.push(QueuedEvent(event, payload))) {
+        return false;
+    }
+    if (!_queueScheduled.exchange(true)) {
+        // retried by LoopFunctions::run() if the scheduled functions are full
+        if (!LoopFunctions::callOnce(processQueue)) {
+            // try again with the next event
+            __SLDBG_printf("cannot schedule processQueue()");
+            _queueScheduled = false;
+        }
+    }
+    return true;
+}
+
+void WiFiCallbacks::processQueue()
+{
+    // events queued after this point schedule another call
+    _queueScheduled = false;
+    QueuedEvent item;
+    for(auto count = _queue.size(); count && _queue.pop(item); count--) {
+        callEvent(item.event, item.payload);
+    }
+}
+
+void WiFiCallbacks::_rebuildDispatchLists()
+{
+    for(auto &list: _dispatch) {
+        list.clear();
+    }
+    for(size_t i = 0; i < _callbacks.size(); i++) {
+        auto events = static_cast<uint8_t>(_callbacks[i].events);
+        for(uint8_t bit = 0; bit < kEventBits; bit++) {
+            if (events & (1 << bit)) {
+                _dispatch[bit].push_back(static_cast<uint16_t>(i));
+            }
+        }
+    }
+    _dirty = false;
+}
+
+void WiFiCallbacks::_applyDeferred()
+{
+    for(const auto key: _removed) {
+        // the callback might have been added again
+        auto entry = _callbacks.find(key);
+        if (entry && entry->events == EventType::NONE) {
+            _index.erase(entry->callbackPtr);
+            _callbacks.erase(key);
+            _dirty = true;
+        }
+    }
+    _removed.clear();
+    for(auto &entry: _added) {
+        auto callbackPtr = entry.callbackPtr;
+        _index.emplace(callbackPtr, _callbacks.insert(std::move(entry)));
+        _dirty = true;
+    }
+    _added.clear();
+}
 
 #ifndef _MSC_VER
 #    pragma GCC pop_options
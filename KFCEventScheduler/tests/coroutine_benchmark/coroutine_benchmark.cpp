@@ -0,0 +1,279 @@
+/**
+  Author: sascha_lammers@gmx.de
+*/
+
+// Host benchmark for Event::Coroutine and nested timer callbacks
+//
+// each job connects, sends a request and parses the response. every second job fails to connect the first time
+// and retries after a delay. the asynchronous operations are timers with different delays. the same jobs are
+// implemented with nested callbacks that keep their state in a shared_ptr and with a coroutine
+//
+// allocations are counted by replacing the global operator new/delete. the pools of the timers and coroutines are
+// filled by a warm-up run before measuring. the simulated clock allocates one node per armed timer, both styles arm
+// 3 timers per job on average. the latency is the wall clock time between the completion of an operation and the
+// execution of the next step. coroutines are resumed after all expired timers have been processed
+//
+// requires EVENT_SCHEDULER_SIMULATED_CLOCK=1
+//
+// prints one JSON object per line and returns 0 if all checks passed
+//
+// {"style":"callback","jobs":100,"allocs_per_job":9.000,"bytes_per_job":304.000,"peak_bytes":12800,"ns_per_job":20500.270,"avg_latency_ns":139.804,"max_latency_ns":373,"result":"OK"}
+// {"style":"coroutine","jobs":100,"allocs_per_job":3.010,"bytes_per_job":120.240,"peak_bytes":4024,"ns_per_job":18265.230,"avg_latency_ns":1792.436,"max_latency_ns":3626,"frame_size":88,"result":"OK"}
+//
+// usage: coroutine_benchmark [jobs]
+
+#include <Arduino_compat.h>
+#include <EventScheduler.h>
+#include <SimulatedClock.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <new>
+#include <vector>
+#include <host_test.h>
+
+#if !EVENT_SCHEDULER_SIMULATED_CLOCK
+#    error EVENT_SCHEDULER_SIMULATED_CLOCK=1 required
+#endif
+
+using namespace Event;
+
+namespace AllocStats {
+
+    // size of the header that stores the allocated size
+    static constexpr size_t kHeaderSize = alignof(std::max_align_t);
+
+    static size_t count;
+    static size_t bytes;
+    static size_t live;
+    static size_t peak;
+    static size_t base;
+
+    void reset()
+    {
+        count = 0;
+        bytes = 0;
+        peak = live;
+        base = live;
+    }
+
+}
+
+void *operator new(size_t size)
+{
+    auto ptr = reinterpret_cast<uint8_t *>(malloc(size + AllocStats::kHeaderSize));
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    *reinterpret_cast<size_t *>(ptr) = size;
+    AllocStats::count++;
+    AllocStats::bytes += size;
+    AllocStats::live += size;
+    AllocStats::peak = std::max(AllocStats::peak, AllocStats::live);
+    return ptr + AllocStats::kHeaderSize;
+}
+
+void operator delete(void *ptr) noexcept
+{
+    if (ptr) {
+        auto block = reinterpret_cast<uint8_t *>(ptr) - AllocStats::kHeaderSize;
+        AllocStats::live -= *reinterpret_cast<size_t *>(block);
+        free(block);
+    }
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+    operator delete(ptr);
+}
+
+using Clock = std::chrono::steady_clock;
+
+static constexpr uint32_t kRetryDelay = 100;
+
+struct Latency {
+    Clock::time_point completed;
+    uint64_t total;
+    uint64_t max;
+    uint32_t count;
+
+    void begin() {
+        completed = Clock::now();
+    }
+
+    void end() {
+        auto latency = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - completed).count());
+        total += latency;
+        max = std::max(max, latency);
+        count++;
+    }
+};
+
+static std::vector<Latency> latencies;
+static uint32_t finished;
+static uint32_t errors;
+
+static uint32_t getDelay(uint32_t job, uint32_t step)
+{
+    return 10 + ((job * 7919 + step * 104729) % 500);
+}
+
+static void parse(uint32_t job, uint32_t attempts)
+{
+    if (attempts != 1 + (job % 2)) {
+        errors++;
+    }
+    finished++;
+}
+
+// callback style
+
+struct JobState {
+    uint32_t job;
+    uint32_t attempts;
+};
+
+using JobStatePtr = std::shared_ptr<JobState>;
+
+static void asyncOperation(uint32_t job, uint32_t delay, bool success, std::function<void(bool)> callback)
+{
+    // a callback cannot be stored inside another one, it is kept on the heap
+    auto callbackPtr = std::make_shared<std::function<void(bool)>>(std::move(callback));
+    _Scheduler.add(delay, false, [job, success, callbackPtr](CallbackTimerPtr) {
+        latencies[job].begin();
+        (*callbackPtr)(success);
+    });
+}
+
+static void callbackConnect(JobStatePtr state)
+{
+    auto job = state->job;
+    state->attempts++;
+    asyncOperation(job, getDelay(job, state->attempts), state->attempts > (job % 2), [state](bool success) {
+        latencies[state->job].end();
+        if (!success) {
+            _Scheduler.add(kRetryDelay, false, [state](CallbackTimerPtr) {
+                callbackConnect(state);
+            });
+            return;
+        }
+        asyncOperation(state->job, getDelay(state->job, 10), true, [state](bool) {
+            latencies[state->job].end();
+            parse(state->job, state->attempts);
+        });
+    });
+}
+
+// coroutine style
+
+struct Operation {
+    Completion done;
+    bool success;
+
+    void start(uint32_t job, uint32_t delay, bool result) {
+        done.reset();
+        _Scheduler.add(delay, false, [this, job, result](CallbackTimerPtr) {
+            latencies[job].begin();
+            success = result;
+            done.complete();
+        });
+    }
+};
+
+class Job : public Coroutine {
+public:
+    Job(uint32_t job) : _job(job), _attempts(0) {}
+
+protected:
+    StateType resume() override {
+        CO_BEGIN();
+        for(;;) {
+            _attempts++;
+            _operation.start(_job, getDelay(_job, _attempts), _attempts > (_job % 2));
+            CO_AWAIT(_operation.done);
+            latencies[_job].end();
+            if (_operation.success) {
+                break;
+            }
+            CO_DELAY(kRetryDelay);
+        }
+        _operation.start(_job, getDelay(_job, 10), true);
+        CO_AWAIT(_operation.done);
+        latencies[_job].end();
+        parse(_job, _attempts);
+        CO_END();
+    }
+
+private:
+    Operation _operation;
+    uint32_t _job;
+    uint32_t _attempts;
+};
+
+static bool runJobs(uint32_t jobs, bool coroutines)
+{
+    latencies.assign(jobs, Latency());
+    finished = 0;
+    errors = 0;
+    for(uint32_t i = 0; i < jobs; i++) {
+        if (coroutines) {
+            Coroutine::start<Job>(i);
+        }
+        else {
+            callbackConnect(std::make_shared<JobState>(JobState({i, 0})));
+        }
+    }
+    while(finished < jobs) {
+        Scheduler::run();
+        LoopFunctions::run();
+        if (!Coroutine::isReady() && !SimulatedClock::step()) {
+            break;
+        }
+    }
+    return finished == jobs && errors == 0 && _Scheduler.size() == 0 && Coroutine::size() == 0;
+}
+
+static void benchmark(uint32_t jobs, bool coroutines)
+{
+    const char *style = coroutines ? "coroutine" : "callback";
+    // fill the pools
+    runJobs(jobs, coroutines);
+
+    AllocStats::reset();
+    auto start = Clock::now();
+    bool success = runJobs(jobs, coroutines);
+    auto nanos = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    auto allocs = AllocStats::count;
+    auto bytes = AllocStats::bytes;
+    auto peak = AllocStats::peak - AllocStats::base;
+
+    uint64_t totalLatency = 0;
+    uint64_t maxLatency = 0;
+    uint32_t steps = 0;
+    for(const auto &latency: latencies) {
+        totalLatency += latency.total;
+        maxLatency = std::max(maxLatency, latency.max);
+        steps += latency.count;
+    }
+    printf("{\"style\":\"%s\",\"jobs\":%u,\"allocs_per_job\":%.3f,\"bytes_per_job\":%.3f,\"peak_bytes\":%u,\"ns_per_job\":%.3f,\"avg_latency_ns\":%.3f,\"max_latency_ns\":%.0f",
+        style, jobs, allocs / static_cast<double>(jobs), bytes / static_cast<double>(jobs), static_cast<unsigned>(peak), nanos / jobs, steps ? totalLatency / static_cast<double>(steps) : 0, maxLatency / 1.0
+    );
+    if (coroutines) {
+        printf(",\"frame_size\":%u", static_cast<unsigned>(sizeof(Job)));
+    }
+    printf(",\"result\":\"%s\"}\n", HostTest::result(success));
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t jobs = (argc > 1) ? static_cast<uint32_t>(atol(argv[1])) : 100;
+    SimulatedClock::reset();
+
+    benchmark(jobs, false);
+    benchmark(jobs, true);
+
+    _Scheduler.end();
+    return HostTest::exitCode();
+}
@@ -0,0 +1,336 @@
+/**
+  Author: sascha_lammers@gmx.de
+*/
+
+// Host test for LoopFunctions and stdex::slot_map
+//
+// - slot_map: random insert and erase operations compared to a std::map. keys of erased elements must not be valid
+// - slot_map_wrap: a slot is reused until its 8 bit generation wraps around. the slot must be retired
+// - deferred: functions that add and remove themselves and other functions while LoopFunctions::run() is executed
+// - external: a main loop that iterates LoopFunctions::getVector() itself and calls cleanUp(). functions removed
+//   during the loop must not shift the other entries
+// - erased: entries erased through the container like the vector based main loops did. getVector() is read only,
+//   the test casts it. add(), remove() and cleanUp() must drop the keys of the erased entries
+// - add_remove: cost of add() and remove() for the given number of functions
+//
+// prints one JSON object per line and returns 0 if all checks passed
+//
+// {"test":"slot_map","operations":100000,"errors":0,"result":"OK"}
+// {"test":"slot_map_wrap","cycles":300,"retired":1,"errors":0,"result":"OK"}
+// {"test":"deferred","errors":0,"result":"OK"}
+// {"test":"external","errors":0,"result":"OK"}
+// {"test":"erased","errors":0,"result":"OK"}
+// {"test":"add_remove","functions":1000,"ns_per_op":35.000}
+//
+// usage: loop_functions
+
+#include <Arduino_compat.h>
+#include <LoopFunctions.h>
+#include <stdio.h>
+#include <chrono>
+#include <map>
+#include <random>
+#include <vector>
+#include <host_test.h>
+
+using HostTest::result;
+
+static void testSlotMap(uint32_t operations)
+{
+    using SlotMap = stdex::slot_map<uint32_t>;
+
+    std::minstd_rand rnd(1);
+    SlotMap slotMap;
+    std::vector<std::pair<SlotMap::key_type, uint32_t>> valid;
+    std::vector<SlotMap::key_type> erased;
+    uint32_t errors = 0;
+    for(uint32_t i = 0; i < operations; i++) {
+        if (valid.empty() || (rnd() % 5) < 3 - (valid.size() > 500)) {
+            valid.emplace_back(slotMap.insert(i), i);
+        }
+        else {
+            auto pos = rnd() % valid.size();
+            if (!slotMap.erase(valid[pos].first)) {
+                errors++;
+            }
+            erased.push_back(valid[pos].first);
+            valid[pos] = valid.back();
+            valid.pop_back();
+        }
+        if ((i % 1000) == 0) {
+            for(const auto &item: valid) {
+                auto value = slotMap.find(item.first);
+                if (!value || *value != item.second) {
+                    errors++;
+                }
+            }
+            for(const auto key: erased) {
+                if (slotMap.contains(key) || slotMap.erase(key)) {
+                    errors++;
+                }
+            }
+            erased.clear();
+            if (slotMap.size() != valid.size()) {
+                errors++;
+            }
+        }
+    }
+    slotMap.clear();
+    for(const auto &item: valid) {
+        if (slotMap.contains(item.first)) {
+            errors++;
+        }
+    }
+    printf("{\"test\":\"slot_map\",\"operations\":%u,\"errors\":%u,\"result\":\"%s\"}\n", operations, errors, result(errors == 0 && slotMap.empty()));
+}
+
+static void testSlotMapWrap(uint32_t cycles)
+{
+    using SlotMap = stdex::slot_map<uint32_t, uint16_t, uint8_t>;
+
+    SlotMap slotMap;
+    auto first = slotMap.insert(0);
+    slotMap.erase(first);
+    uint32_t errors = 0;
+    uint32_t retired = 0;
+    auto index = first.index;
+    for(uint32_t i = 1; i <= cycles; i++) {
+        auto key = slotMap.insert(i);
+        if (key.index != index) {
+            // the previous slot has been retired
+            retired++;
+            index = key.index;
+        }
+        // keys of the retired slot must not match
+        if (slotMap.contains(first) || !slotMap.contains(key) || *slotMap.find(key) != i) {
+            errors++;
+        }
+        slotMap.erase(key);
+    }
+    // 255 generations per slot
+    if (retired != cycles / 255) {
+        errors++;
+    }
+    printf("{\"test\":\"slot_map_wrap\",\"cycles\":%u,\"retired\":%u,\"errors\":%u,\"result\":\"%s\"}\n", cycles, retired, errors, result(errors == 0 && slotMap.empty()));
+}
+
+static std::map<uintptr_t, uint32_t> calls;
+
+static void testDeferred()
+{
+    uint32_t errors = 0;
+    auto id = [](uintptr_t n) {
+        return LoopFunctions::CallbackId(reinterpret_cast<const void *>(n));
+    };
+    auto counter = [](uintptr_t n) {
+        return [n]() {
+            calls[n]++;
+        };
+    };
+
+    for(uintptr_t n = 1; n <= 10; n++) {
+        LoopFunctions::add(counter(n), id(n));
+    }
+    // 11 removes itself, 2 and 3. 3 is added again. 12 is added during the pass
+    LoopFunctions::add([&]() {
+        calls[11]++;
+        LoopFunctions::remove(id(11));
+        LoopFunctions::remove(id(2));
+        LoopFunctions::remove(id(3));
+        LoopFunctions::add(counter(3), id(3));
+        LoopFunctions::add(counter(12), id(12));
+        // removed before the pass has been completed
+        LoopFunctions::add(counter(13), id(13));
+        LoopFunctions::remove(id(13));
+        if (LoopFunctions::size() != 10) {
+            errors++;
+        }
+    }, id(11));
+    if (LoopFunctions::size() != 11) {
+        errors++;
+    }
+
+    LoopFunctions::run();
+    LoopFunctions::run();
+
+    for(uintptr_t n = 1; n <= 13; n++) {
+        uint32_t expected;
+        switch(n) {
+            case 2:
+                // removed before or after it was executed in the first pass
+                expected = calls[n] ? 1 : 0;
+                break;
+            case 11:
+                expected = 1;
+                break;
+            case 12:
+                expected = 1;
+                break;
+            case 13:
+                expected = 0;
+                break;
+            default:
+                expected = 2;
+                break;
+        }
+        if (calls[n] != expected) {
+            errors++;
+        }
+    }
+    if (LoopFunctions::size() != 10 || LoopFunctions::getVector().size() != 10) {
+        errors++;
+    }
+
+    LoopFunctions::clear();
+    LoopFunctions::run();
+    if (!LoopFunctions::empty()) {
+        errors++;
+    }
+    printf("{\"test\":\"deferred\",\"errors\":%u,\"result\":\"%s\"}\n", errors, result(errors == 0));
+}
+
+static void testExternal()
+{
+    uint32_t errors = 0;
+    calls.clear();
+    auto id = [](uintptr_t n) {
+        return LoopFunctions::CallbackId(reinterpret_cast<const void *>(n));
+    };
+    auto counter = [](uintptr_t n) {
+        return [n]() {
+            calls[n]++;
+        };
+    };
+
+    // 1 removes itself and 4, 2 removes 3 after it has been executed
+    LoopFunctions::add([&]() {
+        calls[1]++;
+        LoopFunctions::remove(id(1));
+        LoopFunctions::remove(id(4));
+    }, id(1));
+    LoopFunctions::add(counter(2), id(2));
+    LoopFunctions::add(counter(3), id(3));
+    LoopFunctions::add(counter(4), id(4));
+    LoopFunctions::add([&]() {
+        calls[5]++;
+        LoopFunctions::remove(id(3));
+    }, id(5));
+
+    for(int pass = 0; pass < 2; pass++) {
+        auto &functions = LoopFunctions::getVector();
+        for(size_t i = 0; i < functions.size(); i++) {
+            if (!functions[i].deleteCallback) {
+                functions[i].callback();
+            }
+        }
+        LoopFunctions::cleanUp();
+    }
+
+    if (calls[1] != 1 || calls[2] != 2 || calls[3] != 1 || calls[4] != 0 || calls[5] != 2) {
+        errors++;
+    }
+    if (LoopFunctions::size() != 2 || LoopFunctions::getVector().size() != 2) {
+        errors++;
+    }
+    // removed outside run() and added again before cleanUp()
+    LoopFunctions::remove(id(2));
+    LoopFunctions::add(counter(2), id(2));
+    LoopFunctions::cleanUp();
+    if (LoopFunctions::size() != 2) {
+        errors++;
+    }
+
+    LoopFunctions::clear();
+    if (!LoopFunctions::empty() || LoopFunctions::getVector().size() != 0) {
+        errors++;
+    }
+    printf("{\"test\":\"external\",\"errors\":%u,\"result\":\"%s\"}\n", errors, result(errors == 0));
+}
+
+static void testErased()
+{
+    uint32_t errors = 0;
+    calls.clear();
+    auto id = [](uintptr_t n) {
+        return LoopFunctions::CallbackId(reinterpret_cast<const void *>(n));
+    };
+    auto counter = [](uintptr_t n) {
+        return [n]() {
+            calls[n]++;
+        };
+    };
+    auto erase = [](LoopFunctions::CallbackId id) {
+        auto &functions = const_cast<LoopFunctions::FunctionsMap &>(LoopFunctions::getVector());
+        for(auto iterator = functions.begin(); iterator != functions.end(); ++iterator) {
+            if (*iterator == id) {
+                functions.erase(iterator);
+                return;
+            }
+        }
+    };
+
+    for(uintptr_t n = 1; n <= 4; n++) {
+        LoopFunctions::add(counter(n), id(n));
+    }
+    // 2 is marked and erased, 1 and 4 are erased
+    LoopFunctions::remove(id(2));
+    erase(id(1));
+    erase(id(2));
+    erase(id(4));
+    // added again, removed and removed after being erased
+    LoopFunctions::add(counter(1), id(1));
+    LoopFunctions::remove(id(2));
+    LoopFunctions::remove(id(4));
+    LoopFunctions::cleanUp();
+    LoopFunctions::run();
+    if (calls[1] != 1 || calls[2] != 0 || calls[3] != 1 || calls[4] != 0) {
+        errors++;
+    }
+    if (LoopFunctions::size() != 2 || LoopFunctions::getVector().size() != 2) {
+        errors++;
+    }
+    // 4 can be added again
+    LoopFunctions::add(counter(4), id(4));
+    LoopFunctions::run();
+    if (calls[4] != 1 || LoopFunctions::size() != 3) {
+        errors++;
+    }
+
+    LoopFunctions::clear();
+    if (!LoopFunctions::empty() || LoopFunctions::getVector().size() != 0) {
+        errors++;
+    }
+    printf("{\"test\":\"erased\",\"errors\":%u,\"result\":\"%s\"}\n", errors, result(errors == 0));
+}
+
+static void testAddRemove(uint32_t count)
+{
+    std::vector<LoopFunctions::CallbackId> ids;
+    for(uint32_t i = 0; i < count; i++) {
+        ids.emplace_back(reinterpret_cast<const void *>(static_cast<uintptr_t>(i + 1)));
+    }
+    auto start = std::chrono::steady_clock::now();
+    for(const auto id: ids) {
+        LoopFunctions::add([]() {}, id);
+    }
+    for(const auto id: ids) {
+        LoopFunctions::remove(id);
+    }
+    LoopFunctions::cleanUp();
+    auto nanos = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    printf("{\"test\":\"add_remove\",\"functions\":%u,\"ns_per_op\":%.3f}\n", count, nanos / (count * 2));
+    if (!LoopFunctions::empty() || LoopFunctions::getVector().size() != 0) {
+        result(false);
+    }
+}
+
+int main()
+{
+    testSlotMap(100000);
+    testSlotMapWrap(300);
+    testDeferred();
+    testExternal();
+    testErased();
+    testAddRemove(1000);
+    return HostTest::exitCode();
+}
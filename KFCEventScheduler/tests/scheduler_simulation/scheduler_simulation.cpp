@@ -0,0 +1,397 @@
+/**
+  Author: sascha_lammers@gmx.de
+*/
+
+// Host benchmark and test harness for Event::Scheduler with a simulated clock
+//
+// requires EVENT_SCHEDULER_SIMULATED_CLOCK=1. the OS timers are driven by Event::SimulatedClock, all results
+// except the wall clock times are deterministic. the simulated clock does not advance while callbacks are
+// executed, callbacks are expected to be invoked at the exact time of expiration
+//
+// prints one JSON object per line and returns 0 if all checks passed
+//
+// {"test":"add","timers":100,"ns_per_op":250.000}
+// {"test":"dispatch","timers":100,"simulated_s":3600,"callbacks":167000,"ns_per_callback":80.000,"max_late_us":0,"max_count_error":0,"result":"OK"}
+// {"test":"remove","timers":100,"ns_per_op":120.000}
+// {"test":"order","timers":100,"errors":0,"result":"OK"}
+// {"test":"priority","timers":6,"errors":0,"result":"OK"}
+// {"test":"throttle","calls":2,"errors":0,"result":"OK"}
+// {"test":"long_delay","delay_ms":20612841,"repeat":3,"callbacks":3,"max_late_us":0,"result":"OK"}
+// {"test":"coalesce","timers":100,"slack_ms":500,"simulated_s":3600,"callbacks":273559,"wakeups":14058,"max_late_us":500000,"max_count_error":1,"result":"OK"}
+// {"test":"handles","operations":20000,"stale_checked":19988,"errors":0,"result":"OK"}
+// {"test":"handle_reuse","cycles":70000,"errors":0,"result":"OK"}
+// {"test":"remove_self","repeat":1,"calls":3,"errors":0,"result":"OK"}
+//
+// usage: scheduler_simulation
+
+#include <Arduino_compat.h>
+#include <EventScheduler.h>
+#include <SimulatedClock.h>
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <host_test.h>
+
+#if !EVENT_SCHEDULER_SIMULATED_CLOCK
+#    error EVENT_SCHEDULER_SIMULATED_CLOCK=1 required
+#endif
+
+using namespace Event;
+
+struct TimerStats {
+    uint64_t start;                     // simulated time when the timer was added
+    uint64_t interval;                  // microseconds
+    uint32_t calls;
+    uint64_t maxLate;
+};
+
+using HostTest::result;
+
+class WallClock {
+public:
+    WallClock() : _start(std::chrono::steady_clock::now()) {}
+
+    double getNanos() const {
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - _start).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point _start;
+};
+
+// run the main loop after each expiration until the end time has been reached
+static void runUntil(uint64_t end)
+{
+    while(SimulatedClock::getNextExpiration() <= end) {
+        SimulatedClock::step();
+        Scheduler::run();
+    }
+    SimulatedClock::advance(end - SimulatedClock::getMicros64());
+    Scheduler::run();
+}
+
+// add, dispatch and remove cost for the given number of timers and the accuracy of repeating timers
+static void runSuite(uint32_t count, uint32_t simulatedSeconds)
+{
+    std::vector<TimerStats> stats(count);
+
+    WallClock addTime;
+    for(uint32_t i = 0; i < count; i++) {
+        uint32_t interval = 100 + ((i * 7919) % 9900);
+        auto &timer = stats[i];
+        timer = TimerStats({SimulatedClock::getMicros64(), interval * 1000ULL, 0, 0});
+        _Scheduler.add(interval, true, [&timer](CallbackTimerPtr) {
+            timer.calls++;
+            auto late = SimulatedClock::getMicros64() - (timer.start + timer.calls * timer.interval);
+            timer.maxLate = std::max(timer.maxLate, late);
+        });
+    }
+    printf("{\"test\":\"add\",\"timers\":%u,\"ns_per_op\":%.3f}\n", count, addTime.getNanos() / count);
+
+    auto end = SimulatedClock::getMicros64() + simulatedSeconds * 1000000ULL;
+    WallClock dispatchTime;
+    runUntil(end);
+    auto nanos = dispatchTime.getNanos();
+
+    uint64_t callbacks = 0;
+    uint64_t maxLate = 0;
+    uint32_t maxCountError = 0;
+    for(const auto &timer: stats) {
+        uint32_t expected = static_cast<uint32_t>((end - timer.start) / timer.interval);
+        maxCountError = std::max<uint32_t>(maxCountError, (expected > timer.calls) ? (expected - timer.calls) : (timer.calls - expected));
+        maxLate = std::max(maxLate, timer.maxLate);
+        callbacks += timer.calls;
+    }
+    printf("{\"test\":\"dispatch\",\"timers\":%u,\"simulated_s\":%u,\"callbacks\":%.0f,\"ns_per_callback\":%.3f,\"max_late_us\":%.0f,\"max_count_error\":%u,\"result\":\"%s\"}\n",
+        count, simulatedSeconds, callbacks / 1.0, callbacks ? (nanos / callbacks) : 0, maxLate / 1.0, maxCountError, result(maxLate == 0 && maxCountError == 0)
+    );
+
+    auto timers = _Scheduler.__getTimers();
+    WallClock removeTime;
+    for(auto timer: timers) {
+        _Scheduler.remove(timer);
+    }
+    printf("{\"test\":\"remove\",\"timers\":%u,\"ns_per_op\":%.3f}\n", count, removeTime.getNanos() / count);
+}
+
+// one shot timers added in random order are executed in order of expiration
+static void testOrder(uint32_t count)
+{
+    std::vector<uint32_t> order;
+    for(uint32_t i = 0; i < count; i++) {
+        uint32_t delay = 10 + ((i * 7919) % count) * 10;
+        _Scheduler.add(delay, false, [delay, &order](CallbackTimerPtr) {
+            order.push_back(delay);
+        });
+    }
+    runUntil(SimulatedClock::getMicros64() + (count + 2) * 10000ULL);
+
+    uint32_t errors = (order.size() == count) ? 0 : 1;
+    for(size_t i = 1; i < order.size(); i++) {
+        if (order[i - 1] >= order[i]) {
+            errors++;
+        }
+    }
+    printf("{\"test\":\"order\",\"timers\":%u,\"errors\":%u,\"result\":\"%s\"}\n", count, errors, result(errors == 0 && _Scheduler.size() == 0));
+}
+
+// timers expiring at the same time are executed by priority
+static void testPriority()
+{
+    static const PriorityType priorities[] = {
+        PriorityType::LOWEST, PriorityType::NORMAL, PriorityType::HIGHEST, PriorityType::LOW, PriorityType::HIGHER, PriorityType::HIGH
+    };
+    std::vector<PriorityType> order;
+    for(auto priority: priorities) {
+        _Scheduler.add(100, false, [priority, &order](CallbackTimerPtr) {
+            order.push_back(priority);
+        }, priority);
+    }
+    runUntil(SimulatedClock::getMicros64() + 200000);
+
+    uint32_t errors = (order.size() == sizeof(priorities) / sizeof(priorities[0])) ? 0 : 1;
+    for(size_t i = 1; i < order.size(); i++) {
+        if (order[i - 1] < order[i]) {
+            errors++;
+        }
+    }
+    printf("{\"test\":\"priority\",\"timers\":%u,\"errors\":%u,\"result\":\"%s\"}\n", static_cast<unsigned>(order.size()), errors, result(errors == 0));
+}
+
+// Timer::throttle() runs the first call after 10ms. a second call replaces it and is delayed, further calls are
+// ignored until the delayed call has been executed
+static void testThrottle()
+{
+    uint32_t errors = 0;
+    std::vector<int> calls;
+    auto callback = [&calls](int n) {
+        return [&calls, n](CallbackTimerPtr) {
+            calls.push_back(n);
+        };
+    };
+    auto start = SimulatedClock::getMicros64();
+    Timer timer;
+    timer.throttle(100, callback(1));
+    runUntil(start + 20000);
+    if (calls != std::vector<int>({ 1 }) || timer) {
+        errors++;
+    }
+    timer.throttle(100, callback(2));
+    timer.throttle(100, callback(3));
+    timer.throttle(100, callback(4));
+    runUntil(start + 70000);
+    if (calls.size() != 1 || !timer) {
+        errors++;
+    }
+    timer.throttle(100, callback(5));
+    runUntil(start + 300000);
+    if (calls != std::vector<int>({ 1, 3 }) || timer || _Scheduler.size() != 0) {
+        errors++;
+    }
+    printf("{\"test\":\"throttle\",\"calls\":%u,\"errors\":%u,\"result\":\"%s\"}\n", static_cast<unsigned>(calls.size()), errors, result(errors == 0));
+}
+
+// delays above kMaxDelay are split into multiple OS timer intervals if SCHEDULER_HAVE_REMAINING_DELAY is set
+static void testLongDelay(uint32_t repeat)
+{
+    int64_t delay = 2 * static_cast<int64_t>(kMaxDelay) + 12345;
+    TimerStats timer({SimulatedClock::getMicros64(), static_cast<uint64_t>(delay) * 1000, 0, 0});
+    _Scheduler.add(delay, repeat, [&timer](CallbackTimerPtr) {
+        timer.calls++;
+        auto now = SimulatedClock::getMicros64();
+        auto expected = timer.start + timer.calls * timer.interval;
+        auto late = (now > expected) ? (now - expected) : (expected - now);
+        timer.maxLate = std::max(timer.maxLate, late);
+    });
+    runUntil(timer.start + timer.interval * repeat + timer.interval / 2);
+
+    bool success = timer.calls == repeat && timer.maxLate == 0 && _Scheduler.size() == 0;
+    printf("{\"test\":\"long_delay\",\"delay_ms\":%.0f,\"repeat\":%u,\"callbacks\":%u,\"max_late_us\":%.0f,\"result\":\"%s\"}\n",
+        delay / 1.0, repeat, timer.calls, timer.maxLate / 1.0, result(success)
+    );
+    _Scheduler.end();
+}
+
+// repeating timers with slack are aligned to shared expirations
+static void testCoalesce(uint32_t count, uint32_t slack, uint32_t simulatedSeconds)
+{
+    std::vector<TimerStats> stats(count);
+    for(uint32_t i = 0; i < count; i++) {
+        uint32_t interval = 1000 + i * 7;
+        auto &timer = stats[i];
+        timer = TimerStats({SimulatedClock::getMicros64(), interval * 1000ULL, 0, 0});
+        _Scheduler.add(interval, true, [&timer](CallbackTimerPtr) {
+            timer.calls++;
+            auto late = SimulatedClock::getMicros64() - (timer.start + timer.calls * timer.interval);
+            timer.maxLate = std::max(timer.maxLate, late);
+        }, PriorityType::NORMAL, slack);
+    }
+
+    auto end = SimulatedClock::getMicros64() + simulatedSeconds * 1000000ULL;
+    uint32_t wakeups = 0;
+    while(SimulatedClock::getNextExpiration() <= end) {
+        SimulatedClock::step();
+        Scheduler::run();
+        wakeups++;
+    }
+
+    uint64_t callbacks = 0;
+    uint64_t maxLate = 0;
+    uint32_t maxCountError = 0;
+    for(const auto &timer: stats) {
+        uint32_t expected = static_cast<uint32_t>((end - timer.start) / timer.interval);
+        maxCountError = std::max<uint32_t>(maxCountError, (expected > timer.calls) ? (expected - timer.calls) : (timer.calls - expected));
+        maxLate = std::max(maxLate, timer.maxLate);
+        callbacks += timer.calls;
+    }
+    // the last interval might not have been executed yet because of the slack
+    bool success = maxLate <= slack * 1000ULL && maxCountError <= 1;
+    printf("{\"test\":\"coalesce\",\"timers\":%u,\"slack_ms\":%u,\"simulated_s\":%u,\"callbacks\":%.0f,\"wakeups\":%u,\"max_late_us\":%.0f,\"max_count_error\":%u,\"result\":\"%s\"}\n",
+        count, slack, simulatedSeconds, callbacks / 1.0, wakeups, maxLate / 1.0, maxCountError, result(success)
+    );
+    _Scheduler.end();
+}
+
+// random add and remove operations by handle. removed and expired timers must not be found by their handle,
+// even after their slot and memory has been reused by another timer
+static void testHandles(uint32_t operations)
+{
+    std::minstd_rand rnd(1);
+    std::vector<std::pair<TimerHandle, uint32_t>> alive;
+    std::vector<TimerHandle> stale;
+    uint32_t staleChecked = 0;
+    uint32_t errors = 0;
+    for(uint32_t i = 0; i < operations; i++) {
+        auto op = rnd() % 4;
+        if (op < 2 || alive.empty()) {
+            // one shot timers expire during the test
+            bool repeat = (rnd() % 4) != 0;
+            auto handle = _Scheduler.add(10 + rnd() % 10000, repeat, [](CallbackTimerPtr) {});
+            auto timer = _Scheduler.getTimer(handle);
+            if (!timer || timer->getHandle() != handle) {
+                errors++;
+            }
+            alive.emplace_back(handle, repeat);
+        }
+        else if (op == 2) {
+            auto index = rnd() % alive.size();
+            auto handle = alive[index].first;
+            auto exists = _Scheduler.getTimer(handle) != nullptr;
+            // one shot timers might have expired already
+            if (_Scheduler.remove(handle) != exists || (!exists && alive[index].second)) {
+                errors++;
+            }
+            stale.push_back(handle);
+            alive[index] = alive.back();
+            alive.pop_back();
+        }
+        else {
+            runUntil(SimulatedClock::getMicros64() + (rnd() % 1000) * 1000ULL);
+        }
+
+        if (!stale.empty()) {
+            auto handle = stale[rnd() % stale.size()];
+            if (_Scheduler.getTimer(handle) || _Scheduler.remove(handle)) {
+                errors++;
+            }
+            staleChecked++;
+        }
+    }
+    // only expired one shot timers are missing
+    size_t found = 0;
+    for(const auto &item: alive) {
+        auto timer = _Scheduler.getTimer(item.first);
+        if (timer) {
+            found++;
+        }
+        else if (item.second) {
+            errors++;
+        }
+    }
+    if (found != _Scheduler.size()) {
+        errors++;
+    }
+    _Scheduler.end();
+    for(const auto &item: alive) {
+        if (_Scheduler.getTimer(item.first)) {
+            errors++;
+        }
+    }
+    printf("{\"test\":\"handles\",\"operations\":%u,\"stale_checked\":%u,\"errors\":%u,\"result\":\"%s\"}\n", operations, staleChecked, errors, result(errors == 0));
+}
+
+// a timer that is added and removed repeatedly reuses the same slot. the handle of the first timer must not match
+// after more cycles than a 16 bit generation can count
+static void testHandleReuse(uint32_t cycles)
+{
+    uint32_t errors = 0;
+    auto first = _Scheduler.add(1000, false, [](CallbackTimerPtr) {});
+    _Scheduler.remove(first);
+    for(uint32_t i = 0; i < cycles; i++) {
+        auto handle = _Scheduler.add(1000, false, [](CallbackTimerPtr) {});
+        if (handle.index != first.index || _Scheduler.getTimer(first)) {
+            errors++;
+        }
+        _Scheduler.remove(handle);
+    }
+    _Scheduler.run();
+    if (_Scheduler.size() != 0) {
+        errors++;
+    }
+    printf("{\"test\":\"handle_reuse\",\"cycles\":%u,\"errors\":%u,\"result\":\"%s\"}\n", cycles, errors, result(errors == 0));
+    _Scheduler.end();
+}
+
+// a callback that removes its own handle. the timer must not be removed a second time after the callback returned
+// and must not be called anymore
+static void testRemoveSelf(bool repeat)
+{
+    uint32_t errors = 0;
+    uint32_t calls = 0;
+    TimerHandle handle;
+    handle = _Scheduler.add(10, repeat, [&](CallbackTimerPtr timer) {
+        if (++calls == (repeat ? 3 : 1)) {
+            if (timer->getHandle() != handle || !_Scheduler.remove(handle) || _Scheduler.remove(handle)) {
+                errors++;
+            }
+        }
+    });
+    runUntil(SimulatedClock::getMicros64() + 100 * 1000ULL);
+    if (calls != (repeat ? 3U : 1U) || _Scheduler.getTimer(handle) || _Scheduler.size() != 0) {
+        errors++;
+    }
+    printf("{\"test\":\"remove_self\",\"repeat\":%u,\"calls\":%u,\"errors\":%u,\"result\":\"%s\"}\n", repeat, calls, errors, result(errors == 0));
+    _Scheduler.end();
+}
+
+int main()
+{
+    SimulatedClock::reset();
+
+    runSuite(10, 3600);
+    runSuite(100, 3600);
+    runSuite(10000, 60);
+
+    testOrder(10);
+    testOrder(100);
+    testOrder(10000);
+    testPriority();
+    testThrottle();
+
+    testLongDelay(1);
+    testLongDelay(3);
+
+    testCoalesce(100, 0, 3600);
+    testCoalesce(100, 100, 3600);
+    testCoalesce(100, 500, 3600);
+
+    testHandles(20000);
+    testHandleReuse(70000);
+    testRemoveSelf(false);
+    testRemoveSelf(true);
+
+    _Scheduler.end();
+    return HostTest::exitCode();
+}
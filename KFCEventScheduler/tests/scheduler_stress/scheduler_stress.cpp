@@ -0,0 +1,282 @@
+/**
+  Author: sascha_lammers@gmx.de
+*/
+
+// Host stress test for the lock-free pending list of Event::Scheduler
+//
+// producer threads act as OS timer context and call Scheduler::__TimerCallback() for a set of timers while
+// the main thread executes Scheduler::run(). the interval of the timers does not expire during the test, all
+// callbacks are triggered by the threads
+//
+// - trigger: the timers are triggered by the threads. afterwards all timers are triggered and every second timer
+//   is removed before the main loop picks them up
+// - remove: the main thread disarms, removes and replaces timers while the threads are triggering them. a thread
+//   that has picked a timer before it was disarmed calls __TimerCallback() after it has been removed, like the
+//   esp_timer task on a dual core ESP32. the slab memory of removed timers is reused by the new timers
+// - remove_in_callback: a timer is removed while a thread is inside __TimerCallback() for it. the memory of the
+//   timer must not be reused before the thread has returned
+//
+// verifies that
+// - no trigger is lost, each timer is executed after its last trigger
+// - a timer is not executed more often than it has been triggered
+// - timers removed while pending are not executed
+// - timers added after other timers have been removed are not blocked by late triggers of the removed ones
+// - all removed timers are deleted once the threads have stopped
+// - removed timers are not deleted while __TimerCallback() is in progress
+//
+// prints one JSON object per line and returns 0 on success
+//
+// {"test":"trigger","threads":4,"timers":32,"triggers":80000,"callbacks":12345,"lost":0,"excess":0,"removed_called":0,"result":"OK"}
+// {"test":"remove","threads":4,"timers":32,"triggers":80000,"replaced":4096,"callbacks":12345,"lost":0,"excess":0,"removed_called":0,"pool_live":32,"result":"OK"}
+// {"test":"remove_in_callback","reused":false,"pool_live":1,"result":"OK"}
+//
+// usage: scheduler_stress [threads] [triggers per thread]
+
+#include <Arduino_compat.h>
+#include <EventScheduler.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <random>
+#include <thread>
+#include <vector>
+#include <host_test.h>
+
+using namespace Event;
+using HostTest::result;
+
+static constexpr size_t kTimers = 32;
+static constexpr size_t kMaxReplaced = 4096;
+static constexpr size_t kMaxIds = kTimers * 2 + kMaxReplaced;
+static constexpr int64_t kInterval = 3600 * 1000;
+
+struct TimerStats {
+    CallbackTimerPtr timer;
+    std::atomic<uint32_t> triggered;    // incremented by the producer before calling __TimerCallback()
+    uint32_t seen;                      // value of triggered when the callback was executed
+    uint32_t calls;
+    bool removed;                       // set before the timer is removed
+};
+
+static TimerStats stats[kMaxIds];
+static uint32_t nextId;
+// id + 1 of the timer that is armed in each slot, 0 = disarmed
+static std::atomic<uint32_t> slots[kTimers];
+static uint32_t removedCalled;
+
+static uint32_t addTimer(uint32_t slot)
+{
+    static const PriorityType priorities[] = {
+        PriorityType::LOWEST, PriorityType::LOW, PriorityType::NORMAL, PriorityType::HIGH, PriorityType::HIGHEST
+    };
+    auto id = nextId++;
+    auto handle = _Scheduler.add(kInterval, true, [id](CallbackTimerPtr) {
+        auto &timer = stats[id];
+        if (timer.removed) {
+            removedCalled++;
+        }
+        timer.seen = timer.triggered;
+        timer.calls++;
+    }, priorities[slot % (sizeof(priorities) / sizeof(priorities[0]))]);
+    stats[id].timer = _Scheduler.getTimer(handle);
+    slots[slot].store(id + 1, std::memory_order_release);
+    return id;
+}
+
+static void trigger(uint32_t id)
+{
+    stats[id].triggered++;
+    Scheduler::__TimerCallback(stats[id].timer);
+}
+
+static void producer(uint32_t seed, uint32_t count)
+{
+    std::minstd_rand rnd(seed);
+    for(uint32_t i = 0; i < count; i++) {
+        auto id = slots[rnd() % kTimers].load(std::memory_order_acquire);
+        if (id) {
+            trigger(id - 1);
+        }
+        if ((i & 0xff) == 0) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+static std::vector<std::thread> startProducers(uint32_t numThreads, uint32_t triggers, std::atomic<uint32_t> &running)
+{
+    std::vector<std::thread> threads;
+    running = numThreads;
+    for(uint32_t i = 0; i < numThreads; i++) {
+        threads.emplace_back([i, triggers, &running]() {
+            producer(i + 1, triggers);
+            running--;
+        });
+    }
+    return threads;
+}
+
+// lost triggers of the timers in the slots, excess calls of all timers added since firstId
+static void checkTimers(uint32_t firstId, uint32_t &lost, uint32_t &excess, uint32_t &callbacks)
+{
+    lost = 0;
+    excess = 0;
+    callbacks = 0;
+    for(uint32_t id = firstId; id < nextId; id++) {
+        auto &timer = stats[id];
+        if (timer.calls > timer.triggered) {
+            excess++;
+        }
+        callbacks += timer.calls;
+    }
+    for(auto &slot: slots) {
+        auto id = slot.load();
+        if (id && stats[id - 1].seen != stats[id - 1].triggered) {
+            lost++;
+        }
+    }
+}
+
+static void runTriggerTest(uint32_t numThreads, uint32_t triggers)
+{
+    auto firstId = nextId;
+    for(uint32_t i = 0; i < kTimers; i++) {
+        addTimer(i);
+    }
+
+    std::atomic<uint32_t> running;
+    auto threads = startProducers(numThreads, triggers, running);
+    while(running) {
+        Scheduler::run();
+    }
+    for(auto &thread: threads) {
+        thread.join();
+    }
+    for(int i = 0; i < 10; i++) {
+        Scheduler::run();
+    }
+
+    uint32_t lost, excess, callbacks;
+    checkTimers(firstId, lost, excess, callbacks);
+
+    // trigger all timers and remove every second timer before the main loop picks them up
+    for(uint32_t i = 0; i < kTimers; i++) {
+        trigger(slots[i] - 1);
+    }
+    for(uint32_t i = 0; i < kTimers; i += 2) {
+        auto id = slots[i].exchange(0) - 1;
+        stats[id].removed = true;
+        _Scheduler.remove(stats[id].timer);
+    }
+    for(int i = 0; i < 10; i++) {
+        Scheduler::run();
+    }
+
+    bool success = !lost && !excess && !removedCalled && _Scheduler.size() == kTimers / 2;
+    printf("{\"test\":\"trigger\",\"threads\":%u,\"timers\":%u,\"triggers\":%u,\"callbacks\":%u,\"lost\":%u,\"excess\":%u,\"removed_called\":%u,\"result\":\"%s\"}\n",
+        numThreads, static_cast<unsigned>(kTimers), numThreads * triggers, callbacks, lost, excess, removedCalled, result(success)
+    );
+    _Scheduler.end();
+}
+
+static void runRemoveTest(uint32_t numThreads, uint32_t triggers)
+{
+    removedCalled = 0;
+    auto firstId = nextId;
+    for(uint32_t i = 0; i < kTimers; i++) {
+        addTimer(i);
+    }
+
+    std::minstd_rand rnd(numThreads);
+    uint32_t replaced = 0;
+    uint32_t iteration = 0;
+    std::atomic<uint32_t> running;
+    auto threads = startProducers(numThreads, triggers, running);
+    while(running) {
+        Scheduler::run();
+        if (replaced < kMaxReplaced && (++iteration % 4) == 0) {
+            auto slot = rnd() % kTimers;
+            // disarm, the producers do not pick the timer anymore. a producer that has picked it already calls
+            // __TimerCallback() after it has been removed
+            auto id = slots[slot].exchange(0) - 1;
+            stats[id].removed = true;
+            _Scheduler.remove(stats[id].timer);
+            addTimer(slot);
+            replaced++;
+        }
+    }
+    for(auto &thread: threads) {
+        thread.join();
+    }
+    // all timers must be triggered after the last removal
+    for(uint32_t i = 0; i < kTimers; i++) {
+        trigger(slots[i] - 1);
+    }
+    for(int i = 0; i < 10; i++) {
+        Scheduler::run();
+    }
+
+    uint32_t lost, excess, callbacks;
+    checkTimers(firstId, lost, excess, callbacks);
+    auto poolLive = CallbackTimer::getPoolStats().live;
+    bool success = !lost && !excess && !removedCalled && _Scheduler.size() == kTimers && poolLive == kTimers;
+    printf("{\"test\":\"remove\",\"threads\":%u,\"timers\":%u,\"triggers\":%u,\"replaced\":%u,\"callbacks\":%u,\"lost\":%u,\"excess\":%u,\"removed_called\":%u,\"pool_live\":%u,\"result\":\"%s\"}\n",
+        numThreads, static_cast<unsigned>(kTimers), numThreads * triggers, replaced, callbacks, lost, excess, removedCalled, poolLive, result(success)
+    );
+    _Scheduler.end();
+}
+
+static void runCallbackTest()
+{
+    // PriorityType::TIMER callbacks are invoked inside __TimerCallback()
+    std::atomic<bool> entered(false);
+    std::atomic<bool> release(false);
+    auto handle = _Scheduler.add(kInterval, true, [&entered, &release](CallbackTimerPtr) {
+        entered = true;
+        while(!release) {
+            std::this_thread::yield();
+        }
+    }, PriorityType::TIMER);
+    auto timer = _Scheduler.getTimer(handle);
+
+    std::thread thread([timer]() {
+        Scheduler::__TimerCallback(timer);
+    });
+    while(!entered) {
+        std::this_thread::yield();
+    }
+    _Scheduler.remove(timer);
+    for(int i = 0; i < 10; i++) {
+        Scheduler::run();
+    }
+    // the slab pool returns the last freed slot first
+    auto newTimer = _Scheduler.getTimer(_Scheduler.add(kInterval, true, [](CallbackTimerPtr) {}));
+    bool reused = (newTimer == timer);
+    release = true;
+    thread.join();
+    for(int i = 0; i < 10; i++) {
+        Scheduler::run();
+    }
+
+    auto poolLive = CallbackTimer::getPoolStats().live;
+    bool success = !reused && _Scheduler.size() == 1 && poolLive == 1;
+    printf("{\"test\":\"remove_in_callback\",\"reused\":%s,\"pool_live\":%u,\"result\":\"%s\"}\n", reused ? "true" : "false", poolLive, result(success));
+    _Scheduler.end();
+}
+
+int main(int argc, const char **argv)
+{
+    uint32_t numThreads = 4;
+    uint32_t triggers = 100000;
+    if (argc > 1) {
+        numThreads = strtoul(argv[1], nullptr, 10);
+    }
+    if (argc > 2) {
+        triggers = strtoul(argv[2], nullptr, 10);
+    }
+
+    runTriggerTest(numThreads, triggers);
+    runRemoveTest(numThreads, triggers);
+    runCallbackTest();
+    return HostTest::exitCode();
+}
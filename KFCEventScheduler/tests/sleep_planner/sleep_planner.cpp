@@ -0,0 +1,268 @@
+/**
+  Author: sascha_lammers@gmx.de
+*/
+
+// Host test for Scheduler::getNextDeadline(), Scheduler::fastForward() and SleepPlanner with a simulated clock
+//
+// requires EVENT_SCHEDULER_SIMULATED_CLOCK=1
+//
+// - deadline: random add, remove, rearm and disarm operations. the deadline is compared to a scan of all timers and
+//   to the next expiration of the OS timers
+// - planner: wake sources, loop functions and timers that keep the device awake
+// - sleep_running: the clock keeps running during sleep (ESP32 light sleep)
+// - sleep_stopped: the clock is stopped during sleep and the timers are fast-forwarded (ESP8266 forced light sleep).
+//   every third sleep is interrupted by a GPIO after half of the time
+//
+// prints one JSON object per line and returns 0 if all checks passed
+//
+// {"test":"deadline","operations":20000,"errors":0,"result":"OK"}
+// {"test":"planner","errors":0,"result":"OK"}
+// {"test":"sleep_running","timers":10,"simulated_s":3600,"callbacks":11964,"wakeups":11932,"idle_wakeups":0,"max_late_us":0,"max_count_error":0,"result":"OK"}
+// {"test":"sleep_stopped","timers":10,"simulated_s":3600,"callbacks":11964,"wakeups":17885,"gpio_wakeups":5953,"max_late_us":0,"max_count_error":0,"result":"OK"}
+//
+// usage: sleep_planner
+
+#include <Arduino_compat.h>
+#include <EventScheduler.h>
+#include <SimulatedClock.h>
+#include <stdio.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include <host_test.h>
+
+#if !EVENT_SCHEDULER_SIMULATED_CLOCK
+#    error EVENT_SCHEDULER_SIMULATED_CLOCK=1 required
+#endif
+
+using namespace Event;
+
+struct TimerStats {
+    uint64_t start;                     // time when the timer was added
+    uint64_t interval;                  // microseconds
+    uint32_t calls;
+    uint64_t maxLate;
+};
+
+using HostTest::result;
+
+static const PriorityType priorities[] = {
+    PriorityType::LOWEST, PriorityType::LOW, PriorityType::NORMAL, PriorityType::HIGH, PriorityType::HIGHEST
+};
+
+// deadline by scanning all timers. the priorities used in the test belong to different ready lists
+static uint32_t scanNextDeadline(PriorityType priority)
+{
+    auto deadline = std::numeric_limits<uint64_t>::max();
+    for(auto timer: _Scheduler.__getTimers()) {
+        if (timer->_deadlineIndex != CallbackTimer::kNoDeadlineIndex && timer->_priority >= priority) {
+            deadline = std::min(deadline, timer->_deadline);
+        }
+    }
+    if (deadline == std::numeric_limits<uint64_t>::max()) {
+        return kNoDeadline;
+    }
+    auto now = SimulatedClock::getMicros64() / 1000;
+    return (deadline <= now) ? 0 : static_cast<uint32_t>(deadline - now);
+}
+
+static void testDeadline(uint32_t operations)
+{
+    std::minstd_rand rnd(1);
+    uint32_t errors = 0;
+    for(uint32_t i = 0; i < operations; i++) {
+        auto &timers = _Scheduler.__getTimers();
+        auto op = rnd() % 8;
+        if (op < 3 || timers.empty()) {
+            _Scheduler.add(5 + rnd() % 100000, (rnd() & 1) != 0, [](CallbackTimerPtr) {}, priorities[rnd() % 5]);
+        }
+        else if (op == 3) {
+            _Scheduler.remove(timers[rnd() % timers.size()]);
+        }
+        else if (op == 4) {
+            timers[rnd() % timers.size()]->rearm(5 + rnd() % 100000);
+        }
+        else if (op == 5) {
+            timers[rnd() % timers.size()]->disarm();
+        }
+        else {
+            SimulatedClock::advanceMillis(rnd() % 2000);
+            Scheduler::run();
+        }
+
+        for(auto priority: priorities) {
+            if (_Scheduler.getNextDeadline(priority) != scanNextDeadline(priority)) {
+                errors++;
+            }
+        }
+        // all timers are below kMaxDelay and the clock is always a multiple of 1ms
+        auto expires = SimulatedClock::getNextExpiration();
+        auto deadline = _Scheduler.getNextDeadline();
+        if (expires == std::numeric_limits<uint64_t>::max()) {
+            if (deadline != kNoDeadline) {
+                errors++;
+            }
+        }
+        else if (deadline != (expires - SimulatedClock::getMicros64()) / 1000) {
+            errors++;
+        }
+    }
+    printf("{\"test\":\"deadline\",\"operations\":%u,\"errors\":%u,\"result\":\"%s\"}\n", operations, errors, result(errors == 0));
+    _Scheduler.end();
+}
+
+static bool sourceBusy = false;
+
+static void loopFunction()
+{
+}
+
+static void testPlanner()
+{
+    uint32_t errors = 0;
+    auto expect = [&errors](const SleepPlanner::Plan &plan, uint32_t sleepMillis, SleepPlanner::PinMaskType wakePinMask, SleepPlanner::ReasonType reason) {
+        if (plan.sleepMillis != sleepMillis || plan.wakePinMask != wakePinMask || plan.reason != reason) {
+            errors++;
+        }
+    };
+
+    expect(SleepPlanner::getPlan(), kNoDeadline, 0, SleepPlanner::ReasonType::NONE);
+
+    _Scheduler.add(1000, true, [](CallbackTimerPtr) {}, PriorityType::LOW);
+    _Scheduler.add(100, true, [](CallbackTimerPtr) {}, PriorityType::LOWEST);
+    expect(SleepPlanner::getPlan(), 100, 0, SleepPlanner::ReasonType::NONE);
+    // the LOWEST priority timer can be delayed
+    expect(SleepPlanner::getPlan(PriorityType::LOW), 1000, 0, SleepPlanner::ReasonType::NONE);
+    SimulatedClock::advanceMillis(95);
+    expect(SleepPlanner::getPlan(), 0, 0, SleepPlanner::ReasonType::TIMER);
+    expect(SleepPlanner::getPlan(PriorityType::NONE, 5), 5, 0, SleepPlanner::ReasonType::NONE);
+    // triggered timers need to be executed first
+    SimulatedClock::advanceMillis(5);
+    expect(SleepPlanner::getPlan(PriorityType::NONE, 0), 0, 0, SleepPlanner::ReasonType::TIMER);
+    Scheduler::run();
+    expect(SleepPlanner::getPlan(), 100, 0, SleepPlanner::ReasonType::NONE);
+
+    // any loop function keeps the device awake
+    LoopFunctions::add(loopFunction);
+    expect(SleepPlanner::getPlan(), 0, 0, SleepPlanner::ReasonType::LOOP_FUNCTIONS);
+
+    // unless it belongs to an idle wake source
+    SleepPlanner::addWakeSource(&sourceBusy, []() { return sourceBusy; }, []() { return static_cast<SleepPlanner::PinMaskType>(0x1010); }, loopFunction);
+    SleepPlanner::addWakeSource(&errors, nullptr, []() { return static_cast<SleepPlanner::PinMaskType>(0x0001); });
+    expect(SleepPlanner::getPlan(), 100, 0x1011, SleepPlanner::ReasonType::NONE);
+    sourceBusy = true;
+    expect(SleepPlanner::getPlan(), 0, 0, SleepPlanner::ReasonType::WAKE_SOURCE);
+    sourceBusy = false;
+
+    SleepPlanner::removeWakeSource(&sourceBusy);
+    expect(SleepPlanner::getPlan(), 0, 0x0001, SleepPlanner::ReasonType::LOOP_FUNCTIONS);
+    LoopFunctions::remove(loopFunction);
+    expect(SleepPlanner::getPlan(), 100, 0x0001, SleepPlanner::ReasonType::NONE);
+    SleepPlanner::removeWakeSource(&errors);
+
+    printf("{\"test\":\"planner\",\"errors\":%u,\"result\":\"%s\"}\n", errors, result(errors == 0));
+    LoopFunctions::clear();
+    _Scheduler.end();
+}
+
+// sleep as long as the planner allows. if stopClock is true, the clock does not advance while sleeping and
+// the timers are fast-forwarded after waking up
+static void testSleep(uint32_t count, uint32_t simulatedSeconds, bool stopClock)
+{
+    uint64_t slept = 0;             // microseconds the clock has been stopped
+    auto getTime = [&slept]() {
+        return SimulatedClock::getMicros64() + slept;
+    };
+
+    std::vector<TimerStats> stats(count);
+    uint32_t callbacks = 0;
+    for(uint32_t i = 0; i < count; i++) {
+        uint32_t interval = 1000 + ((i * 7919) % 9000);
+        auto &timer = stats[i];
+        timer = TimerStats({getTime(), interval * 1000ULL, 0, 0});
+        _Scheduler.add(interval, true, [&timer, &callbacks, &getTime](CallbackTimerPtr) {
+            timer.calls++;
+            callbacks++;
+            auto now = getTime();
+            auto expected = timer.start + timer.calls * timer.interval;
+            auto late = (now > expected) ? (now - expected) : (expected - now);
+            timer.maxLate = std::max(timer.maxLate, late);
+        }, priorities[i % 5]);
+    }
+
+    auto end = getTime() + simulatedSeconds * 1000000ULL;
+    uint32_t wakeups = 0;
+    uint32_t idleWakeups = 0;
+    uint32_t gpioWakeups = 0;
+    while(getTime() < end) {
+        Scheduler::run();
+        auto plan = SleepPlanner::getPlan(PriorityType::NONE, 1);
+        if (!plan.canSleep()) {
+            if (plan.reason != SleepPlanner::ReasonType::TIMER) {
+                break;
+            }
+            // a timer expires within the min. sleep time
+            SimulatedClock::advanceMillis(1);
+            continue;
+        }
+        uint64_t sleepMillis = std::min<uint64_t>(plan.sleepMillis, (end - getTime()) / 1000);
+        if (sleepMillis == 0) {
+            break;
+        }
+        auto before = callbacks;
+        wakeups++;
+        if (stopClock) {
+            // interrupted by a GPIO
+            bool gpio = (wakeups % 3) == 0 && sleepMillis > 1;
+            if (gpio) {
+                gpioWakeups++;
+                sleepMillis /= 2;
+            }
+            slept += sleepMillis * 1000;
+            SleepPlanner::wakeup(static_cast<uint32_t>(sleepMillis));
+            if (gpio) {
+                continue;
+            }
+        }
+        else {
+            SimulatedClock::advanceMillis(sleepMillis);
+        }
+        Scheduler::run();
+        if (before == callbacks && getTime() < end) {
+            idleWakeups++;
+        }
+    }
+
+    uint64_t maxLate = 0;
+    uint32_t maxCountError = 0;
+    for(const auto &timer: stats) {
+        uint32_t expected = static_cast<uint32_t>((end - timer.start) / timer.interval);
+        maxCountError = std::max<uint32_t>(maxCountError, (expected > timer.calls) ? (expected - timer.calls) : (timer.calls - expected));
+        maxLate = std::max(maxLate, timer.maxLate);
+    }
+    bool success = maxLate == 0 && maxCountError == 0 && idleWakeups == 0;
+    if (stopClock) {
+        printf("{\"test\":\"sleep_stopped\",\"timers\":%u,\"simulated_s\":%u,\"callbacks\":%u,\"wakeups\":%u,\"gpio_wakeups\":%u,\"max_late_us\":%.0f,\"max_count_error\":%u,\"result\":\"%s\"}\n",
+            count, simulatedSeconds, callbacks, wakeups, gpioWakeups, maxLate / 1.0, maxCountError, result(success)
+        );
+    }
+    else {
+        printf("{\"test\":\"sleep_running\",\"timers\":%u,\"simulated_s\":%u,\"callbacks\":%u,\"wakeups\":%u,\"idle_wakeups\":%u,\"max_late_us\":%.0f,\"max_count_error\":%u,\"result\":\"%s\"}\n",
+            count, simulatedSeconds, callbacks, wakeups, idleWakeups, maxLate / 1.0, maxCountError, result(success)
+        );
+    }
+    _Scheduler.end();
+}
+
+int main()
+{
+    SimulatedClock::reset();
+
+    testDeadline(20000);
+    testPlanner();
+    testSleep(10, 3600, false);
+    testSleep(10, 3600, true);
+
+    _Scheduler.end();
+    return HostTest::exitCode();
+}
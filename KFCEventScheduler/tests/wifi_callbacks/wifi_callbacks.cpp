@@ -0,0 +1,289 @@
+/**
+  Author: sascha_lammers@gmx.de
+*/
+
+// Host test for WiFiCallbacks
+//
+// - registry: random add and remove operations compared to a std::map. after each operation, an event is dispatched
+//   and the invoked callbacks are compared to the registered event masks
+// - deferred: callbacks that add and remove themselves and other callbacks while an event is dispatched. an event
+//   called from a callback is delivered before callEvent() returns
+// - queue: events queued by queueEvent() are delivered in order through run_scheduled_functions()
+// - retry: the queue is processed by LoopFunctions::run() if the scheduled functions are full
+// - dispatch: cost of callEvent() with the given number of callbacks. half of them are registered for the event
+//
+// prints one JSON object per line and returns 0 if all checks passed
+//
+// {"test":"registry","operations":20000,"errors":0,"result":"OK"}
+// {"test":"deferred","errors":0,"result":"OK"}
+// {"test":"queue","queued":21,"delivered":17,"overflows":4,"errors":0,"result":"OK"}
+// {"test":"retry","errors":0,"result":"OK"}
+// {"test":"dispatch","callbacks":64,"ns_per_event":250.000}
+//
+// usage: wifi_callbacks
+
+#include <Arduino_compat.h>
+#include <LoopFunctions.h>
+#include <WiFiCallbacks.h>
+#include <stdio.h>
+#include <chrono>
+#include <map>
+#include <random>
+#include <vector>
+#include <host_test.h>
+
+using EventType = WiFiCallbacks::EventType;
+
+using HostTest::result;
+
+static WiFiCallbacks::CallbackPtr id(uintptr_t n)
+{
+    return reinterpret_cast<WiFiCallbacks::CallbackPtr>(n);
+}
+
+static std::map<uintptr_t, uint32_t> calls;
+
+static WiFiCallbacks::Callback counter(uintptr_t n)
+{
+    return [n](EventType, void *) {
+        calls[n]++;
+    };
+}
+
+static void testRegistry(uint32_t operations)
+{
+    static const EventType events[] = {
+        EventType::CONNECTED, EventType::DISCONNECTED, EventType::MODE_CHANGE, EventType::CONNECTION, EventType::ANY
+    };
+    std::minstd_rand rnd(1);
+    std::map<uintptr_t, uint8_t> registered;
+    uint32_t errors = 0;
+    for(uint32_t i = 0; i < operations; i++) {
+        uintptr_t n = 1 + rnd() % 64;
+        auto mask = events[rnd() % 5];
+        if (rnd() % 2) {
+            registered[n] |= static_cast<uint8_t>(mask);
+            if (WiFiCallbacks::add(mask, counter(n), id(n)) != static_cast<EventType>(registered[n])) {
+                errors++;
+            }
+        }
+        else {
+            auto iterator = registered.find(n);
+            auto left = WiFiCallbacks::remove(mask, id(n));
+            if (iterator == registered.end()) {
+                if (left != EventType::CALLBACK_NOT_FOUND) {
+                    errors++;
+                }
+            }
+            else {
+                iterator->second &= ~static_cast<uint8_t>(mask);
+                if (left != static_cast<EventType>(iterator->second)) {
+                    errors++;
+                }
+                if (iterator->second == 0) {
+                    registered.erase(iterator);
+                }
+            }
+        }
+
+        auto event = events[rnd() % 3];
+        calls.clear();
+        WiFiCallbacks::callEvent(event, nullptr);
+        for(const auto &item: registered) {
+            if (calls[item.first] != ((item.second & static_cast<uint8_t>(event)) ? 1U : 0U)) {
+                errors++;
+            }
+        }
+        if (WiFiCallbacks::getVector().size() != registered.size()) {
+            errors++;
+        }
+    }
+    printf("{\"test\":\"registry\",\"operations\":%u,\"errors\":%u,\"result\":\"%s\"}\n", operations, errors, result(errors == 0));
+    WiFiCallbacks::clear();
+}
+
+static uint32_t nestedErrors;
+
+static void testDeferred()
+{
+    uint32_t errors = 0;
+    nestedErrors = 0;
+    calls.clear();
+    for(uintptr_t n = 1; n <= 10; n++) {
+        WiFiCallbacks::add(EventType::CONNECTION, counter(n), id(n));
+    }
+    // 11 removes itself, 2 and 3. 3 is added again. 12 is added during the event
+    WiFiCallbacks::add(EventType::CONNECTED, [](EventType, void *) {
+        calls[11]++;
+        WiFiCallbacks::remove(EventType::ANY, id(11));
+        WiFiCallbacks::remove(EventType::ANY, id(2));
+        WiFiCallbacks::remove(EventType::ANY, id(3));
+        WiFiCallbacks::add(EventType::CONNECTED, counter(3), id(3));
+        WiFiCallbacks::add(EventType::CONNECTED, counter(12), id(12));
+        // removed before the event has been delivered to all callbacks
+        WiFiCallbacks::add(EventType::CONNECTED, counter(13), id(13));
+        WiFiCallbacks::remove(EventType::CONNECTED, id(13));
+        // delivered before callEvent() returns
+        auto called = calls[1];
+        int payload = 0;
+        WiFiCallbacks::callEvent(EventType::DISCONNECTED, &payload);
+        if (calls[1] != called + 1 || calls[2] != 1 || calls[3] != 1) {
+            nestedErrors++;
+        }
+    }, id(11));
+
+    WiFiCallbacks::callEvent(EventType::CONNECTED, nullptr);
+    run_scheduled_functions();
+    WiFiCallbacks::callEvent(EventType::CONNECTED, nullptr);
+
+    for(uintptr_t n = 1; n <= 13; n++) {
+        uint32_t expected;
+        switch(n) {
+            case 2:
+                // removed after the first event has been delivered
+            case 11:
+            case 12:
+                expected = 1;
+                break;
+            case 3:
+                // added again without DISCONNECTED
+                expected = 2;
+                break;
+            case 13:
+                expected = 0;
+                break;
+            default:
+                expected = 3;
+                break;
+        }
+        if (calls[n] != expected) {
+            errors++;
+        }
+    }
+    if (WiFiCallbacks::getVector().size() != 10) {
+        errors++;
+    }
+    errors += nestedErrors;
+    printf("{\"test\":\"deferred\",\"errors\":%u,\"result\":\"%s\"}\n", errors, result(errors == 0));
+    WiFiCallbacks::clear();
+}
+
+static void testQueue()
+{
+    std::vector<std::pair<EventType, void *>> delivered;
+    WiFiCallbacks::add(EventType::ANY, [&delivered](EventType event, void *payload) {
+        delivered.emplace_back(event, payload);
+    }, id(1));
+
+    static int payload1;
+    static int payload2;
+    // reconnect storm. the last 4 events do not fit into the queue
+    const std::vector<std::pair<EventType, void *>> events = {
+        { EventType::DISCONNECTED, nullptr },
+        { EventType::DISCONNECTED, nullptr },
+        { EventType::DISCONNECTED, nullptr },
+        { EventType::CONNECTED, &payload1 },
+        { EventType::CONNECTED, &payload1 },
+        { EventType::CONNECTED, &payload2 },
+        { EventType::DISCONNECTED, nullptr },
+        { EventType::MODE_CHANGE, nullptr },
+        { EventType::MODE_CHANGE, nullptr },
+        { EventType::DISCONNECTED, nullptr },
+        { EventType::DISCONNECTED, nullptr },
+        { EventType::CONNECTED, &payload2 },
+        { EventType::CONNECTED, &payload2 },
+        { EventType::CONNECTED, &payload2 },
+        { EventType::CONNECTED, &payload2 },
+        { EventType::CONNECTED, &payload2 },
+        { EventType::CONNECTED, nullptr },
+        { EventType::CONNECTED, nullptr },
+        { EventType::CONNECTED, nullptr },
+        { EventType::CONNECTED, nullptr },
+    };
+    const std::vector<std::pair<EventType, void *>> expected(events.begin(), events.begin() + WIFI_CALLBACKS_QUEUE_SIZE);
+
+    uint32_t errors = 0;
+    for(const auto &event: events) {
+        WiFiCallbacks::queueEvent(event.first, event.second);
+    }
+    if (!delivered.empty()) {
+        errors++;
+    }
+    run_scheduled_functions();
+    // queued again after the queue has been processed
+    WiFiCallbacks::queueEvent(EventType::CONNECTED, nullptr);
+    run_scheduled_functions();
+
+    auto expectedAll = expected;
+    expectedAll.emplace_back(EventType::CONNECTED, nullptr);
+    if (delivered != expectedAll) {
+        errors++;
+    }
+    auto overflows = WiFiCallbacks::getQueueOverflows();
+    if (overflows != events.size() - WIFI_CALLBACKS_QUEUE_SIZE) {
+        errors++;
+    }
+    printf("{\"test\":\"queue\",\"queued\":%u,\"delivered\":%u,\"overflows\":%u,\"errors\":%u,\"result\":\"%s\"}\n",
+        static_cast<unsigned>(events.size() + 1), static_cast<unsigned>(delivered.size()), overflows, errors, result(errors == 0)
+    );
+    WiFiCallbacks::clear();
+}
+
+static void testRetry()
+{
+    uint32_t errors = 0;
+    uint32_t delivered = 0;
+    WiFiCallbacks::add(EventType::ANY, [&delivered](EventType, void *) {
+        delivered++;
+    }, id(1));
+
+    // fill the scheduled functions
+    while(schedule_function([]() {})) {
+    }
+    if (!WiFiCallbacks::queueEvent(EventType::CONNECTED)) {
+        errors++;
+    }
+    LoopFunctions::run();
+    if (delivered != 1) {
+        errors++;
+    }
+    run_scheduled_functions();
+    // scheduled again
+    WiFiCallbacks::queueEvent(EventType::DISCONNECTED);
+    run_scheduled_functions();
+    if (delivered != 2) {
+        errors++;
+    }
+    printf("{\"test\":\"retry\",\"errors\":%u,\"result\":\"%s\"}\n", errors, result(errors == 0));
+    WiFiCallbacks::clear();
+}
+
+static void testDispatch(uint32_t count, uint32_t events)
+{
+    uint32_t sum = 0;
+    for(uintptr_t n = 1; n <= count; n++) {
+        WiFiCallbacks::add((n % 2) ? EventType::CONNECTED : EventType::DISCONNECTED, [&sum](EventType, void *) {
+            sum++;
+        }, id(n));
+    }
+    auto start = std::chrono::steady_clock::now();
+    for(uint32_t i = 0; i < events; i++) {
+        WiFiCallbacks::callEvent(EventType::CONNECTED, nullptr);
+    }
+    auto nanos = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    printf("{\"test\":\"dispatch\",\"callbacks\":%u,\"ns_per_event\":%.3f}\n", count, nanos / events);
+    if (sum != events * ((count + 1) / 2)) {
+        result(false);
+    }
+    WiFiCallbacks::clear();
+}
+
+int main()
+{
+    testRegistry(20000);
+    testDeferred();
+    testQueue();
+    testRetry();
+    testDispatch(64, 100000);
+    return HostTest::exitCode();
+}
@@ -61,12 +61,15 @@ namespace KFCJson {
         AbstractJsonValue &add(int32_t value) {
             return add(new JsonUnnamedVariant<int32_t>(value));
         }
-        AbstractJsonValue &add(unsigned long value) {
-            return add(new JsonUnnamedVariant<uint32_t>((uint32_t)value));
-        }
-        AbstractJsonValue &add(long value) {
-            return add(new JsonUnnamedVariant<int32_t>((int32_t)value));
-        }
+        // long and int64_t are the same type on LP64 hosts
+        #if LONG_MAX == INT32_MAX
+            AbstractJsonValue &add(unsigned long value) {
+                return add(new JsonUnnamedVariant<uint32_t>((uint32_t)value));
+            }
+            AbstractJsonValue &add(long value) {
+                return add(new JsonUnnamedVariant<int32_t>((int32_t)value));
+            }
+        #endif
         AbstractJsonValue &add(uint64_t value) {
             return add(new JsonUnnamedVariant<uint64_t>(value));
         }
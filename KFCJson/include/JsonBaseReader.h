@@ -46,6 +46,7 @@ namespace KFCJson {
             JSON_ERROR_OUT_OF_BOUNDS,                   // array or object terminator without array or object
             JSON_ERROR_USER_ABORT,
             JSON_ERROR_INVALID_END,                     // array closed with } or object closed with ]
+            JSON_ERROR_UNEXPECTED_END,                  // stream ended inside a CBOR item or container
         } JsonErrorEnum_t;
 
         typedef struct {
@@ -68,11 +69,16 @@ namespace KFCJson {
             JSON_TYPE_OBJECT_END,
         } JsonType_t;
 
+        enum class FormatType : uint8_t {
+            JSON = 0,
+            CBOR,                               // binary format written by AbstractJsonValue::printCborTo()
+        };
+
     public:
         JsonBaseReader(Stream &stream) : JsonBaseReader(&stream) {
         }
 
-        JsonBaseReader(Stream *stream) : _stream(stream), _quoteChar('"'), _lastError() {
+        JsonBaseReader(Stream *stream) : _stream(stream), _cbor(false), _quoteChar('"'), _lastError() {
             clearLastError();
         }
 
@@ -101,7 +107,16 @@ namespace KFCJson {
             _quoteChar = quoteChar;
         }
 
-        void initParser();
+        // select the input format. the callbacks receive the same keys, values and types for JSON and CBOR
+        inline void setFormat(FormatType format) {
+            _cbor = (format == FormatType::CBOR);
+        }
+
+        inline FormatType getFormat() const {
+            return _cbor ? FormatType::CBOR : FormatType::JSON;
+        }
+
+        virtual void initParser();
         bool parseStream();
 
         // initParser() and parseStream() combined
@@ -188,6 +203,12 @@ namespace KFCJson {
         void _appendIndex(int16_t index, String &str, bool numericIndex = false) const;
         bool _isValidNumber(const String &value, JsonType_t &_type);
 
+        // CBOR decoder, see JsonCborReader.cpp
+        bool _parseCborStream();
+        bool _readCborArgument(uint8_t info, uint64_t &value);
+        bool _readCborString(uint64_t length, String &str, bool hex);
+        bool _processCborElement();
+
     protected:
         Stream *_stream;
         size_t _position;
@@ -198,6 +219,7 @@ namespace KFCJson {
         uint8_t _quoted : 1;	// byte 2
         uint8_t _key : 1;
         uint8_t _escaped : 1;
+        uint8_t _cbor : 1;
         char _quoteChar;		// byte 3
         JsonType_t _type;		// byte 4
 
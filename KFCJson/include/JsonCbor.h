@@ -0,0 +1,114 @@
+/**
+* Author: sascha_lammers@gmx.de
+*/
+
+#pragma once
+
+// CBOR (RFC 8949) encoding helpers
+//
+// AbstractJsonValue::printCborTo() uses these to write the value tree in binary format
+// JsonBaseReader::setFormat(JsonBaseReader::FormatType::CBOR) reads it back with the same callbacks as JSON
+
+#include <Arduino_compat.h>
+#include "JsonString.h"
+#include "JsonVar.h"
+
+namespace KFCJson {
+
+    class JsonCbor {
+    public:
+        enum class MajorType : uint8_t {
+            UNSIGNED_INT = 0,
+            NEGATIVE_INT = 1,
+            BYTE_STRING = 2,
+            TEXT_STRING = 3,
+            ARRAY = 4,
+            MAP = 5,
+            TAG = 6,
+            SIMPLE = 7,
+        };
+
+        // additional information of the initial byte
+        static constexpr uint8_t kUInt8 = 24;
+        static constexpr uint8_t kUInt16 = 25;
+        static constexpr uint8_t kUInt32 = 26;
+        static constexpr uint8_t kUInt64 = 27;
+        static constexpr uint8_t kIndefinite = 31;
+
+        // simple values (major type 7)
+        static constexpr uint8_t kSimpleFalse = 20;
+        static constexpr uint8_t kSimpleTrue = 21;
+        static constexpr uint8_t kSimpleNull = 22;
+        static constexpr uint8_t kSimpleUndefined = 23;
+        static constexpr uint8_t kHalfFloat = 25;
+        static constexpr uint8_t kFloat = 26;
+        static constexpr uint8_t kDouble = 27;
+        static constexpr uint8_t kBreak = 31;
+
+        static constexpr uint8_t initialByte(MajorType type, uint8_t info) {
+            return (static_cast<uint8_t>(type) << 5) | (info & 0x1f);
+        }
+
+        // write major type and argument using the shortest encoding
+        static size_t writeHeader(Print &output, MajorType type, uint64_t value);
+
+        static size_t writeUnsigned(Print &output, uint64_t value) {
+            return writeHeader(output, MajorType::UNSIGNED_INT, value);
+        }
+
+        static size_t writeInt(Print &output, int64_t value) {
+            if (value < 0) {
+                return writeHeader(output, MajorType::NEGATIVE_INT, static_cast<uint64_t>(-(value + 1)));
+            }
+            return writeHeader(output, MajorType::UNSIGNED_INT, static_cast<uint64_t>(value));
+        }
+
+        // writes a single precision float if the value can be stored without losing precision
+        static size_t writeDouble(Print &output, double value);
+
+        static size_t writeBool(Print &output, bool value) {
+            return output.write(initialByte(MajorType::SIMPLE, value ? kSimpleTrue : kSimpleFalse));
+        }
+
+        static size_t writeNull(Print &output) {
+            return output.write(initialByte(MajorType::SIMPLE, kSimpleNull));
+        }
+
+        static size_t writeArray(Print &output, size_t count) {
+            return writeHeader(output, MajorType::ARRAY, count);
+        }
+
+        static size_t writeMap(Print &output, size_t count) {
+            return writeHeader(output, MajorType::MAP, count);
+        }
+
+        // value can be a pointer to PROGMEM
+        static size_t writeString(Print &output, PGM_P value, size_t length);
+
+        inline __attribute__((__always_inline__))
+        static size_t writeString(Print &output, const char *value) {
+            return writeString(output, value, strlen(value));
+        }
+
+        inline __attribute__((__always_inline__))
+        static size_t writeString(Print &output, const __FlashStringHelper *value) {
+            return writeString(output, RFPSTR(value), strlen_P(RFPSTR(value)));
+        }
+
+        inline __attribute__((__always_inline__))
+        static size_t writeString(Print &output, const String &value) {
+            return writeString(output, value.c_str(), value.length());
+        }
+
+        inline __attribute__((__always_inline__))
+        static size_t writeString(Print &output, const JsonString &value) {
+            return writeString(output, value.getPtr(), value.length());
+        }
+
+        // write a number stored as string (JsonNumber, JsonVar). invalid numbers are written as null
+        static size_t writeNumber(Print &output, const char *value);
+
+        static size_t writeVar(Print &output, const JsonVar &value);
+    };
+
+}
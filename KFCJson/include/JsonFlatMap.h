@@ -0,0 +1,133 @@
+/**
+* Author: sascha_lammers@gmx.de
+*/
+
+#pragma once
+
+// Flat map of JSON paths and values used by JsonMapReader
+//
+// keys are stored as object path (prefix) and key or array index (suffix) in a single string pool. the prefix is
+// added once per object and shared by all its members, suffixes are interned. values are stored in the same pool
+// entries are appended while parsing and sorted once by finalize(). lookups use binary search or an optional
+// open addressing hash table
+//
+// strings are limited to kMaxLength (65535) characters. longer strings are rejected
+
+#include <Arduino_compat.h>
+#include <limits>
+#include <vector>
+#include "JsonBaseReader.h"
+#include "JsonVar.h"
+
+namespace KFCJson {
+
+    class JsonFlatMap {
+    public:
+        typedef uint32_t offset_t;
+        typedef uint16_t length_t;
+        typedef JsonBaseReader::JsonType_t JsonType_t;
+
+        static constexpr offset_t kInvalidOffset = ~0U;
+        static constexpr size_t kMaxLength = std::numeric_limits<length_t>::max();
+
+        struct String_t {
+            offset_t offset;
+            length_t length;
+
+            String_t() : offset(kInvalidOffset), length(0) {}
+            String_t(offset_t _offset, length_t _length) : offset(_offset), length(_length) {}
+
+            inline bool isValid() const {
+                return offset != kInvalidOffset;
+            }
+        };
+
+        struct Entry {
+            String_t prefix;
+            String_t suffix;
+            String_t value;
+            JsonType_t type;
+        };
+
+        typedef std::vector<Entry> EntryVector;
+        typedef EntryVector::const_iterator const_iterator;
+
+    public:
+        JsonFlatMap() : _internCount(0), _sorted(true), _hashIndex(false) {}
+
+        void clear();
+
+        // use an open addressing hash table for lookups instead of binary search
+        void setHashIndex(bool enable);
+
+        // add a string without interning, used for object paths and values
+        // returns an invalid string if length exceeds kMaxLength
+        String_t addString(const char *str, size_t length);
+
+        // add a string or return the existing one
+        // returns an invalid string if length exceeds kMaxLength
+        String_t internString(const char *str, size_t length);
+
+        // returns false if prefix or suffix are invalid or the value exceeds kMaxLength
+        bool add(const String_t &prefix, const String_t &suffix, JsonType_t type, const String &value);
+
+        // sort entries, remove duplicates (the last value is kept) and build the hash index
+        // called automatically by find() and begin()
+        void finalize();
+
+        // returns nullptr if the path does not exist
+        const Entry *find(const char *path, size_t length);
+
+        inline const Entry *find(const String &path) {
+            return find(path.c_str(), path.length());
+        }
+
+        String getKey(const Entry &entry) const;
+        String getValue(const Entry &entry) const;
+
+        inline JsonVar getVar(const Entry &entry) const {
+            return JsonVar(entry.type, getValue(entry));
+        }
+
+        inline size_t size() const {
+            return _entries.size();
+        }
+
+        inline const_iterator begin() {
+            finalize();
+            return _entries.cbegin();
+        }
+
+        inline const_iterator end() const {
+            return _entries.cend();
+        }
+
+        // memory used by the string pool, entries and indices
+        size_t memoryUsage() const;
+
+    private:
+        // compare key of entry with the key stored in the second entry or a string
+        int _compare(const Entry &entry, const char *str, size_t length) const;
+        int _compare(const Entry &a, const Entry &b) const;
+
+        uint32_t _hash(const char *str, size_t length, uint32_t hash = 2166136261U) const;
+        uint32_t _hash(const Entry &entry) const;
+
+        inline const char *_ptr(const String_t &str) const {
+            return _pool.data() + str.offset;
+        }
+
+        void _buildHashIndex();
+        void _growInternTable();
+
+    private:
+        std::vector<char> _pool;
+        EntryVector _entries;
+        std::vector<String_t> _internTable;     // open addressing. discarded by finalize()
+        std::vector<uint32_t> _hashTable;       // open addressing, index of _entries + 1
+        size_t _internCount;
+        bool _sorted;
+        bool _hashIndex;
+    };
+
+}
@@ -6,13 +6,16 @@
 
 #include <Arduino_compat.h>
 #include "JsonBaseReader.h"
+#include "JsonFlatMap.h"
 #include "JsonVar.h"
 
 namespace KFCJson {
 
     // read (and filter) JSON into key/value pairs
 
-    typedef std::map<String, JsonVar> JsonMemoryMap;
+    // JsonMemoryMap used to be std::map<String, JsonVar>. the key and value of an entry are available through
+    // JsonFlatMap::getKey(), getValue() and getVar()
+    typedef JsonFlatMap JsonMemoryMap;
 
     class JsonMapReader : public JsonBaseReader {
     public:
@@ -22,15 +25,26 @@ namespace KFCJson {
 
         void setFilter(FilterCallback_t filter);
 
+        // use a hash table for get() instead of binary search
+        void setHashIndex(bool enable);
+
+        virtual bool beginObject(bool isArray) override;
+        virtual bool endObject() override;
         virtual bool processElement() override;
 
         JsonVar get(const String &path) const;
 
         void dump(Print &out);
 
+        inline JsonMemoryMap &getMap() {
+            return _map;
+        }
+
     private:
         FilterCallback_t _filter;
-        JsonMemoryMap _map;
+        mutable JsonMemoryMap _map;
+        // object path of each level, added to the map with the first element
+        std::vector<JsonFlatMap::String_t> _prefixes;
     };
 
 }
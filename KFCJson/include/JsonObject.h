@@ -61,12 +61,15 @@ namespace KFCJson {
         AbstractJsonValue &add(const JsonString &name, int32_t value) {
             return add(new JsonNamedVariant<int32_t>(name, value));
         }
-        AbstractJsonValue &add(const JsonString &name, unsigned long value) {
-            return add(new JsonNamedVariant<uint32_t>(name, (uint32_t)value));
-        }
-        AbstractJsonValue &add(const JsonString &name, long value) {
-            return add(new JsonNamedVariant<int32_t>(name, (int32_t)value));
-        }
+        // long and int64_t are the same type on LP64 hosts
+        #if LONG_MAX == INT32_MAX
+            AbstractJsonValue &add(const JsonString &name, unsigned long value) {
+                return add(new JsonNamedVariant<uint32_t>(name, (uint32_t)value));
+            }
+            AbstractJsonValue &add(const JsonString &name, long value) {
+                return add(new JsonNamedVariant<int32_t>(name, (int32_t)value));
+            }
+        #endif
         AbstractJsonValue &add(const JsonString &name, uint64_t value) {
             return add(new JsonNamedVariant<uint64_t>(name, value));
         }
@@ -116,12 +119,15 @@ namespace KFCJson {
         AbstractJsonValue &replace(const JsonString &name, int32_t value) {
             return replace(name, new JsonNamedVariant<int32_t>(name, value));
         }
-        AbstractJsonValue &replace(const JsonString &name, unsigned long value) {
-            return replace(name, new JsonNamedVariant<uint32_t>(name, (uint32_t)value));
-        }
-        AbstractJsonValue &replace(const JsonString &name, long value) {
-            return replace(name, new JsonNamedVariant<int32_t>(name, (int32_t)value));
-        }
+        // long and int64_t are the same type on LP64 hosts
+        #if LONG_MAX == INT32_MAX
+            AbstractJsonValue &replace(const JsonString &name, unsigned long value) {
+                return replace(name, new JsonNamedVariant<uint32_t>(name, (uint32_t)value));
+            }
+            AbstractJsonValue &replace(const JsonString &name, long value) {
+                return replace(name, new JsonNamedVariant<int32_t>(name, (int32_t)value));
+            }
+        #endif
         AbstractJsonValue &replace(const JsonString &name, uint64_t value) {
             return replace(name, new JsonNamedVariant<uint64_t>(name, value));
         }
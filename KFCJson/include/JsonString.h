@@ -31,7 +31,8 @@ namespace KFCJson {
             length_t length;
         } _str_t;
 
-        const static size_t buffer_size = 8;    // minimum size = sizeof(char *) + sizeof(length_t) + sizeof(char)
+        // minimum size = sizeof(char *) + sizeof(length_t) + sizeof(char), 8 byte on 32 bit platforms
+        const static size_t buffer_size = sizeof(char *) + sizeof(length_t) + sizeof(char) < 8 ? 8 : sizeof(char *) + sizeof(length_t) + sizeof(char);
 
         JsonString(const JsonString &str);
         JsonString(JsonString &&str);
@@ -35,6 +35,9 @@ namespace KFCJson {
         // length of converted JSON data
         virtual size_t length() const = 0;
 
+        // write value as CBOR, see JsonCbor
+        virtual size_t printCborTo(Print &output) const = 0;
+
         virtual JsonVariantEnum_t getType() const = 0;
 
         String toString() const {
@@ -5,6 +5,7 @@
 #pragma once
 
 #include <Arduino_compat.h>
+#include <memory>
 #include "JsonString.h"
 #include "JsonBaseReader.h"
 
@@ -23,17 +24,135 @@ namespace JsonVariableReader {
         Result(Result &&) = default;
         Result &operator=(Result &&) = default;
 
+        // empty results are not stored
         virtual bool empty() const = 0;
+    };
+
+    // results are stored in slabs of kSlabSize objects that are allocated when needed and reused after reset()
+    class ResultStoreBase {
+    public:
+        virtual ~ResultStoreBase() {
+        }
+
+        // object that receives the values of the current element
+        virtual Result &current() = 0;
+        // store the current object if it is not empty and start a new one
+        virtual void flush() = 0;
+        // remove all results. the memory is kept for the next use
+        virtual void reset() = 0;
+        // number of stored results
+        virtual size_t size() const = 0;
+    };
+
+    template <class T, size_t kSlabSize = 8>
+    class ResultStore : public ResultStoreBase {
+    public:
+        static_assert(kSlabSize > 0, "kSlabSize must be greater than 0");
+
+        ResultStore() : _size(0) {
+        }
+
+        virtual Result &current() override {
+            return at(_size);
+        }
+
+        virtual void flush() override {
+            if (at(_size).empty()) {
+                // reuse current object
+                at(_size) = T();
+                return;
+            }
+            _size++;
+            if (_size < _slabs.size() * kSlabSize) {
+                at(_size) = T();
+            }
+        }
+
+        virtual void reset() override {
+            _size = 0;
+            if (!_slabs.empty()) {
+                at(0) = T();
+            }
+        }
+
+        virtual size_t size() const override {
+            return _size;
+        }
+
+        // index must be less or equal to size(), the slab is allocated if required
+        T &at(size_t index) {
+            auto slab = index / kSlabSize;
+            while (slab >= _slabs.size()) {
+                _slabs.emplace_back(new T[kSlabSize]);
+            }
+            return _slabs[slab][index % kSlabSize];
+        }
 
-        virtual Result *create() = 0;
+        const T &at(size_t index) const {
+            return _slabs[index / kSlabSize][index % kSlabSize];
+        }
+
+    private:
+        std::vector<std::unique_ptr<T[]>> _slabs;
+        size_t _size;
+    };
+
+    // view of the stored results
+    template <class T>
+    class ResultView {
+    public:
+        using Store = ResultStore<T>;
+
+        class iterator {
+        public:
+            iterator(Store *store, size_t index) : _store(store), _index(index) {
+            }
+            T &operator*() const {
+                return _store->at(_index);
+            }
+            T *operator->() const {
+                return &_store->at(_index);
+            }
+            iterator &operator++() {
+                ++_index;
+                return *this;
+            }
+            bool operator==(const iterator &iter) const {
+                return _index == iter._index;
+            }
+            bool operator!=(const iterator &iter) const {
+                return _index != iter._index;
+            }
+        private:
+            Store *_store;
+            size_t _index;
+        };
+
+        ResultView(Store *store) : _store(store) {
+        }
+
+        size_t size() const {
+            return _store ? _store->size() : 0;
+        }
+
+        bool empty() const {
+            return size() == 0;
+        }
+
+        T &operator[](size_t index) {
+            return _store->at(index);
+        }
+
+        iterator begin() const {
+            return iterator(_store, 0);
+        }
 
-        //virtual Result *create() {
-        //    // destroy results
-        //    *this = Result();
-        //    return nullptr;
-        //    // save results
-        //    return new Result(std::move(*this));
-        //}
+        iterator end() const {
+            return iterator(_store, size());
+        }
+
+    private:
+        Store *_store;
     };
 
     class Reader;
@@ -58,7 +177,6 @@ namespace JsonVariableReader {
         typedef Element *ElementPtr;
         typedef std::vector<ElementPtr> ElementsVector;
         typedef Result *ResultPtr;
-        typedef std::vector<ResultPtr> ResultsVector;
         typedef std::vector<ElementGroup> Vector;
 
         ElementGroup(const KFCJson::JsonString &path);
@@ -73,42 +191,31 @@ namespace JsonVariableReader {
         bool isPath(const String &path);
         ElementPtr findPath(const String &path);
 
-        // adds a new result object stored using _results::create
+        // store the current result and start a new one
         void flushResult();
 
-        // retrieves last result added
+        // retrieves the result that is currently filled
         ResultPtr getLastResult();
 
-        // retrieve stored results
+        // remove all results and keep the allocated memory for reuse
+        void clearResults();
+
+        // retrieve stored results. T must match the type passed to initResultType()
         template <class T>
-        std::vector<T *> &getResults() {
-            _results.erase(std::remove_if(_results.begin(), _results.end(), [](Result *result) {
-                if (result->empty()) {
-                    delete result;
-                    return true;
-                }
-                return false;
-            }), _results.end()); // remove invalid results
-#ifndef  _MSC_VER
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wstrict-aliasing"
-#endif
-            return reinterpret_cast<std::vector<T *> &>(_results);
-#ifndef  _MSC_VER
-#pragma GCC diagnostic pop
-#endif
+        ResultView<T> getResults() {
+            return ResultView<T>(static_cast<ResultStore<T> *>(_results.get()));
         }
 
         // set result class type
         template <class T>
         void initResultType() {
-            _results.emplace_back(new T());
+            _results.reset(new ResultStore<T>());
         }
 
     private:
         KFCJson::JsonString _path;
         ElementsVector _elements;
-        ResultsVector _results;
+        std::unique_ptr<ResultStoreBase> _results;
     };
 
     class Reader : public KFCJson::JsonBaseReader {
@@ -118,6 +225,9 @@ namespace JsonVariableReader {
 
         ElementGroup::Vector *getElementGroups();
 
+        // the results of the previous parse are removed
+        virtual void initParser();
+
         virtual bool beginObject(bool isArray);
         virtual bool endObject();
         virtual bool processElement();
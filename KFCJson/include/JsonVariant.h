@@ -9,6 +9,7 @@
 #include "JsonValue.h"
 #include "JsonString.h"
 #include "JsonNumber.h"
+#include "JsonCbor.h"
 
 namespace KFCJson {
 
@@ -46,6 +47,9 @@ namespace KFCJson {
         virtual size_t length() const {
             return _length(_value);
         }
+        virtual size_t printCborTo(Print &output) const {
+            return _printCborTo(output, _value);
+        }
 
         virtual JsonVariantEnum_t getType() const {
             return JsonVariantEnum_t::JSON_UNNAMED_VARIANT;
@@ -112,6 +116,57 @@ namespace KFCJson {
             return length;
         }
 
+        size_t _printCborTo(Print &output, const __FlashStringHelper *value) const {
+            return JsonCbor::writeString(output, value);
+        }
+        size_t _printCborTo(Print &output, const char *value) const {
+            return JsonCbor::writeString(output, value);
+        }
+        size_t _printCborTo(Print &output, const JsonVar &value) const {
+            return JsonCbor::writeVar(output, value);
+        }
+        size_t _printCborTo(Print &output, const JsonNumber &value) const {
+            if (value.isProgMem()) {
+                return JsonCbor::writeNumber(output, value.toString().c_str());
+            }
+            return JsonCbor::writeNumber(output, value.getPtr());
+        }
+        size_t _printCborTo(Print &output, const JsonString &value) const {
+            return JsonCbor::writeString(output, value);
+        }
+        size_t _printCborTo(Print &output, const String &value) const {
+            return JsonCbor::writeString(output, value);
+        }
+        size_t _printCborTo(Print &output, bool value) const {
+            return JsonCbor::writeBool(output, value);
+        }
+        size_t _printCborTo(Print &output, std::nullptr_t value) const {
+            return JsonCbor::writeNull(output);
+        }
+        size_t _printCborTo(Print &output, uint32_t value) const {
+            return JsonCbor::writeUnsigned(output, value);
+        }
+        size_t _printCborTo(Print &output, int32_t value) const {
+            return JsonCbor::writeInt(output, value);
+        }
+        size_t _printCborTo(Print &output, uint64_t value) const {
+            return JsonCbor::writeUnsigned(output, value);
+        }
+        size_t _printCborTo(Print &output, int64_t value) const {
+            return JsonCbor::writeInt(output, value);
+        }
+        size_t _printCborTo(Print &output, double value) const {
+            return JsonCbor::writeDouble(output, value);
+        }
+        // objects are written as map with the name of each element as key
+        size_t _printCborTo(Print &output, const AbstractJsonValue::JsonVariantVector &value) const {
+            size_t length = isObject() ? JsonCbor::writeMap(output, value.size()) : JsonCbor::writeArray(output, value.size());
+            for (auto variant : value) {
+                length += variant->printCborTo(output);
+            }
+            return length;
+        }
+
         size_t _length(const __FlashStringHelper *value) const {
             JsonTools::Utf8Buffer buffer;
             return JsonTools::lengthEscaped(value, &buffer) + 2;
@@ -226,6 +281,9 @@ namespace KFCJson {
         virtual size_t length() const {
             return _nameLength() + JsonUnnamedVariant<T>::length();
         }
+        virtual size_t printCborTo(Print &output) const {
+            return JsonCbor::writeString(output, _name) + JsonUnnamedVariant<T>::printCborTo(output);
+        }
 
         virtual AbstractJsonValue::JsonVariantEnum_t getType() const {
             return AbstractJsonValue::JsonVariantEnum_t::JSON_VARIANT;
@@ -196,6 +196,9 @@ namespace KFCJson {
 
     bool JsonBaseReader::parseStream()
     {
+        if (_cbor) {
+            return _parseCborStream();
+        }
     #if DEBUG_KFC_JSON
         if (_stream) {
             __LDBG_printf("JSONparseStream available %d", _stream->available());
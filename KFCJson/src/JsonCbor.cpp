@@ -0,0 +1,140 @@
+/**
+* Author: sascha_lammers@gmx.de
+*/
+
+#include "JsonCbor.h"
+#include <float.h>
+
+#if DEBUG_KFC_JSON
+#    include <debug_helper_enable.h>
+#else
+#    include <debug_helper_disable.h>
+#endif
+
+namespace KFCJson {
+
+    size_t JsonCbor::writeHeader(Print &output, MajorType type, uint64_t value)
+    {
+        uint8_t buf[9];
+        uint8_t len;
+        if (value < kUInt8) {
+            buf[0] = initialByte(type, static_cast<uint8_t>(value));
+            return output.write(buf[0]);
+        }
+        else if (value <= 0xff) {
+            buf[0] = initialByte(type, kUInt8);
+            len = 1;
+        }
+        else if (value <= 0xffff) {
+            buf[0] = initialByte(type, kUInt16);
+            len = 2;
+        }
+        else if (value <= 0xffffffffULL) {
+            buf[0] = initialByte(type, kUInt32);
+            len = 4;
+        }
+        else {
+            buf[0] = initialByte(type, kUInt64);
+            len = 8;
+        }
+        // network byte order
+        for(uint8_t i = len; i > 0; i--) {
+            buf[i] = static_cast<uint8_t>(value);
+            value >>= 8;
+        }
+        return output.write(buf, len + 1);
+    }
+
+    size_t JsonCbor::writeDouble(Print &output, double value)
+    {
+        uint8_t buf[9];
+        float fValue;
+        bool isSingle;
+        // converting a value outside the range of float is undefined
+        if (isnan(value)) {
+            fValue = NAN;
+            isSingle = true;
+        }
+        else if (isinf(value)) {
+            fValue = value < 0 ? -INFINITY : INFINITY;
+            isSingle = true;
+        }
+        else if (fabs(value) <= FLT_MAX) {
+            fValue = static_cast<float>(value);
+            isSingle = static_cast<double>(fValue) == value;
+        }
+        else {
+            fValue = 0;
+            isSingle = false;
+        }
+        if (isSingle) {
+            uint32_t bits;
+            memcpy(&bits, &fValue, sizeof(bits));
+            buf[0] = initialByte(MajorType::SIMPLE, kFloat);
+            for(uint8_t i = 4; i > 0; i--) {
+                buf[i] = static_cast<uint8_t>(bits);
+                bits >>= 8;
+            }
+            return output.write(buf, 5);
+        }
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        buf[0] = initialByte(MajorType::SIMPLE, kDouble);
+        for(uint8_t i = 8; i > 0; i--) {
+            buf[i] = static_cast<uint8_t>(bits);
+            bits >>= 8;
+        }
+        return output.write(buf, 9);
+    }
+
+    size_t JsonCbor::writeString(Print &output, PGM_P value, size_t length)
+    {
+        size_t written = writeHeader(output, MajorType::TEXT_STRING, length);
+        // copy in chunks to support PROGMEM
+        uint8_t buf[32];
+        while (length) {
+            auto len = std::min(length, sizeof(buf));
+            memcpy_P(buf, value, len);
+            if (output.write(buf, len) != len) {
+                return 0;
+            }
+            written += len;
+            value += len;
+            length -= len;
+        }
+        return written;
+    }
+
+    size_t JsonCbor::writeNumber(Print &output, const char *value)
+    {
+        auto type = JsonVar::getNumberType(value);
+        if ((type & JsonVar::NumberType_t::TYPE_MASK) == JsonVar::NumberType_t::INVALID) {
+            return writeNull(output);
+        }
+        if ((type & JsonVar::NumberType_t::TYPE_MASK) == JsonVar::NumberType_t::INT && !(type & JsonVar::NumberType_t::EXPONENT)) {
+            if (type & JsonVar::NumberType_t::NEGATIVE) {
+                return writeInt(output, strtoll(value, nullptr, 10));
+            }
+            return writeUnsigned(output, strtoull(value, nullptr, 10));
+        }
+        return writeDouble(output, JsonVar::getDouble(value));
+    }
+
+    size_t JsonCbor::writeVar(Print &output, const JsonVar &value)
+    {
+        switch(value.getType()) {
+            case JsonBaseReader::JSON_TYPE_STRING:
+                return writeString(output, value.getValue());
+            case JsonBaseReader::JSON_TYPE_BOOLEAN:
+                return writeBool(output, value.getBooleanValue() == JsonVar::BooleanValueType::TRUE);
+            case JsonBaseReader::JSON_TYPE_INT:
+            case JsonBaseReader::JSON_TYPE_FLOAT:
+            case JsonBaseReader::JSON_TYPE_NUMBER:
+                return writeNumber(output, value.getValue().c_str());
+            default:
+                break;
+        }
+        return writeNull(output);
+    }
+
+}
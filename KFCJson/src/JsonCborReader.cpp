@@ -0,0 +1,398 @@
+/**
+* Author: sascha_lammers@gmx.de
+*/
+
+#include <math.h>
+#include <stdlib.h>
+#include <misc.h>
+#include "JsonBaseReader.h"
+#include "JsonCbor.h"
+
+#if DEBUG_KFC_JSON
+#include <debug_helper_enable.h>
+#else
+#include <debug_helper_disable.h>
+#endif
+
+// Streaming CBOR decoder for JsonBaseReader
+//
+// The decoder maintains the same state as the JSON parser (key, value, type, path, array index and level) and
+// calls beginObject(), endObject() and processElement(). Numbers, booleans and null are converted to the same
+// string representation the JSON parser provides. Byte strings are passed as hex encoded string, tags are ignored
+
+namespace KFCJson {
+
+    namespace {
+
+        struct CborContainer {
+            uint64_t remaining;         // items left for containers with definite length. keys and values of maps are counted separately
+            bool indefinite;
+            bool isMap;
+            bool expectKey;
+        };
+
+        double halfToDouble(uint16_t half)
+        {
+            int exponent = (half >> 10) & 0x1f;
+            int mantissa = half & 0x3ff;
+            double value;
+            if (exponent == 0) {
+                value = ldexp(mantissa, -24);
+            }
+            else if (exponent != 31) {
+                value = ldexp(mantissa + 1024, exponent - 25);
+            }
+            else {
+                value = mantissa == 0 ? INFINITY : NAN;
+            }
+            return (half & 0x8000) ? -value : value;
+        }
+
+        void uint64ToString(String &str, uint64_t value, bool negative)
+        {
+            char buf[24];
+            char *ptr = &buf[sizeof(buf) - 1];
+            *ptr = 0;
+            do {
+                *--ptr = '0' + (value % 10);
+                value /= 10;
+            } while (value);
+            if (negative) {
+                *--ptr = '-';
+            }
+            str = ptr;
+        }
+
+        // shortest representation that is read back as the same double. single and half precision values are
+        // stored by the encoder if the value of the JSON number can be represented exactly. they require up to 17
+        // digits as well to be read back as the same value
+        void doubleToString(String &str, double value, int digits)
+        {
+            char buf[32];
+            for(; digits < 17; digits++) {
+                snprintf_P(buf, sizeof(buf), PSTR("%.*g"), digits, value);
+                if (strtod(buf, nullptr) == value) {
+                    str = buf;
+                    return;
+                }
+            }
+            snprintf_P(buf, sizeof(buf), PSTR("%.*g"), digits, value);
+            str = buf;
+        }
+
+    }
+
+    bool JsonBaseReader::_readCborArgument(uint8_t info, uint64_t &value)
+    {
+        if (info < JsonCbor::kUInt8) {
+            value = info;
+            return true;
+        }
+        uint8_t len;
+        switch(info) {
+            case JsonCbor::kUInt8:
+                len = 1;
+                break;
+            case JsonCbor::kUInt16:
+                len = 2;
+                break;
+            case JsonCbor::kUInt32:
+                len = 4;
+                break;
+            case JsonCbor::kUInt64:
+                len = 8;
+                break;
+            default:
+                error(F("Invalid CBOR argument"), JSON_ERROR_INVALID_VALUE);
+                return false;
+        }
+        value = 0;
+        while (len--) {
+            int ch = readByte();
+            if (ch == -1) {
+                error(F("Unexpected end of stream"), JSON_ERROR_UNEXPECTED_END);
+                return false;
+            }
+            value = (value << 8) | static_cast<uint8_t>(ch);
+        }
+        return true;
+    }
+
+    bool JsonBaseReader::_readCborString(uint64_t length, String &str, bool hex)
+    {
+        if (!str.reserve(str.length() + (hex ? length * 2 : length))) {
+            error(F("Out of memory"), JSON_ERROR_INVALID_VALUE);
+            return false;
+        }
+        while (length--) {
+            int ch = readByte();
+            if (ch == -1) {
+                error(F("Unexpected end of stream"), JSON_ERROR_UNEXPECTED_END);
+                return false;
+            }
+            if (hex) {
+                static const char hexChars[] PROGMEM = "0123456789abcdef";
+                str += static_cast<char>(pgm_read_byte(&hexChars[(ch >> 4) & 0xf]));
+                str += static_cast<char>(pgm_read_byte(&hexChars[ch & 0xf]));
+            }
+            else {
+                str += static_cast<char>(ch);
+            }
+        }
+        return true;
+    }
+
+    bool JsonBaseReader::_processCborElement()
+    {
+        if (_arrayIndex == -1 && !_keyStr.length()) {
+            error(F("An object requires a key"), JSON_ERROR_OBJECT_VALUE_WITHOUT_KEY);
+            if (!recoverableError(JSON_ERROR_OBJECT_VALUE_WITHOUT_KEY)) {
+                return false;
+            }
+        }
+        else {
+            _count++;
+            __LDBG_printf("processing key '%s' data %s type %d level %d at %d", _keyStr.c_str(), JsonVar::formatValue(_valueStr, getType()).c_str(), (int)getType(), (int)getLevel(), (int)getLength());
+            if (!processElement()) {
+                return false;
+            }
+        }
+        _valueStr = String();
+        _type = JSON_TYPE_INVALID;
+        return true;
+    }
+
+    bool JsonBaseReader::_parseCborStream()
+    {
+        std::vector<CborContainer> containers;
+        int ch;
+        while ((ch = readByte()) != -1) {
+            auto itemPosition = _position - 1;
+            auto major = static_cast<JsonCbor::MajorType>(ch >> 5);
+            uint8_t info = ch & 0x1f;
+            uint64_t argument = 0;
+            bool indefinite = (info == JsonCbor::kIndefinite);
+            bool isKey = !containers.empty() && containers.back().isMap && containers.back().expectKey;
+            bool closed = false;
+
+            if (ch == JsonCbor::initialByte(JsonCbor::MajorType::SIMPLE, JsonCbor::kBreak)) {
+                if (containers.empty() || !containers.back().indefinite || (containers.back().isMap && !containers.back().expectKey)) {
+                    error(F("Unexpected break"), JSON_ERROR_OUT_OF_BOUNDS);
+                    return false;
+                }
+                closed = true;
+            }
+            else if (indefinite) {
+                if (major != JsonCbor::MajorType::TEXT_STRING && major != JsonCbor::MajorType::BYTE_STRING && major != JsonCbor::MajorType::ARRAY && major != JsonCbor::MajorType::MAP) {
+                    error(F("Invalid CBOR argument"), JSON_ERROR_INVALID_VALUE);
+                    return false;
+                }
+            }
+            else if (major != JsonCbor::MajorType::SIMPLE && !_readCborArgument(info, argument)) {
+                return false;
+            }
+
+            if (closed) {
+                // handled below
+            }
+            else if (major == JsonCbor::MajorType::TAG) {
+                // tags are ignored, the next item is the tagged value
+                continue;
+            }
+            else if (major == JsonCbor::MajorType::ARRAY || major == JsonCbor::MajorType::MAP) {
+                bool isArray = (major == JsonCbor::MajorType::ARRAY);
+                if (isKey) {
+                    error(F("Invalid CBOR map key"), JSON_ERROR_INVALID_VALUE);
+                    return false;
+                }
+                __LDBG_printf("open %s level %d key %s array %d count %d", (isArray ? "array" : "object"), _level + 1, _keyStr.c_str(), _arrayIndex, _count);
+                _stack.push_back({_keyStr, _keyPosition, _arrayIndex, _count});
+                if (++_level <= 0) {
+                    error(F("Maximum nested level reached"), JSON_ERROR_MAX_NESTED_LEVEL);
+                    return false;
+                }
+                if (!beginObject(isArray)) {
+                    return false;
+                }
+                _arrayIndex = isArray ? 0 : -1;
+                _keyStr = String();
+                _valueStr = String();
+                _count = 0;
+                containers.push_back({isArray ? argument : argument * 2, indefinite, !isArray, !isArray});
+                if (indefinite || argument) {
+                    continue;
+                }
+                // empty container
+                closed = true;
+            }
+            else {
+                // scalar value or map key
+                _type = JSON_TYPE_INVALID;
+                _valueStr = String();
+                switch(major) {
+                    case JsonCbor::MajorType::UNSIGNED_INT:
+                        uint64ToString(_valueStr, argument, false);
+                        _type = JSON_TYPE_INT;
+                        break;
+                    case JsonCbor::MajorType::NEGATIVE_INT:
+                        // -1 - argument
+                        uint64ToString(_valueStr, argument == ~0ULL ? argument : argument + 1, true);
+                        _type = JSON_TYPE_INT;
+                        break;
+                    case JsonCbor::MajorType::BYTE_STRING:
+                    case JsonCbor::MajorType::TEXT_STRING: {
+                            bool hex = (major == JsonCbor::MajorType::BYTE_STRING);
+                            if (indefinite) {
+                                // sequence of chunks with definite length terminated by break
+                                int chunk;
+                                while ((chunk = readByte()) != JsonCbor::initialByte(JsonCbor::MajorType::SIMPLE, JsonCbor::kBreak)) {
+                                    if (chunk == -1) {
+                                        error(F("Unexpected end of stream"), JSON_ERROR_UNEXPECTED_END);
+                                        return false;
+                                    }
+                                    if (static_cast<JsonCbor::MajorType>(chunk >> 5) != major || (chunk & 0x1f) == JsonCbor::kIndefinite) {
+                                        error(F("Invalid CBOR string chunk"), JSON_ERROR_INVALID_VALUE);
+                                        return false;
+                                    }
+                                    if (!_readCborArgument(chunk & 0x1f, argument) || !_readCborString(argument, _valueStr, hex)) {
+                                        return false;
+                                    }
+                                }
+                            }
+                            else if (!_readCborString(argument, _valueStr, hex)) {
+                                return false;
+                            }
+                            _type = JSON_TYPE_STRING;
+                        }
+                        break;
+                    case JsonCbor::MajorType::SIMPLE:
+                        switch(info) {
+                            case JsonCbor::kSimpleFalse:
+                                _valueStr = FSPGM(false);
+                                _type = JSON_TYPE_BOOLEAN;
+                                break;
+                            case JsonCbor::kSimpleTrue:
+                                _valueStr = FSPGM(true);
+                                _type = JSON_TYPE_BOOLEAN;
+                                break;
+                            case JsonCbor::kSimpleNull:
+                            case JsonCbor::kSimpleUndefined:
+                                _valueStr = FSPGM(null);
+                                _type = JSON_TYPE_NULL;
+                                break;
+                            case JsonCbor::kHalfFloat:
+                            case JsonCbor::kFloat:
+                            case JsonCbor::kDouble: {
+                                    if (!_readCborArgument(info, argument)) {
+                                        return false;
+                                    }
+                                    double value;
+                                    int digits;
+                                    if (info == JsonCbor::kHalfFloat) {
+                                        value = halfToDouble(static_cast<uint16_t>(argument));
+                                        digits = 4;
+                                    }
+                                    else if (info == JsonCbor::kFloat) {
+                                        uint32_t bits = static_cast<uint32_t>(argument);
+                                        float fValue;
+                                        memcpy(&fValue, &bits, sizeof(fValue));
+                                        value = fValue;
+                                        digits = 6;
+                                    }
+                                    else {
+                                        memcpy(&value, &argument, sizeof(value));
+                                        digits = 15;
+                                    }
+                                    if (isnan(value) || isinf(value)) {
+                                        // not supported by JSON
+                                        _valueStr = FSPGM(null);
+                                        _type = JSON_TYPE_NULL;
+                                    }
+                                    else {
+                                        doubleToString(_valueStr, value, digits);
+                                        _isValidNumber(_valueStr, _type);
+                                    }
+                                }
+                                break;
+                            default:
+                                if (info == JsonCbor::kUInt8 && readByte() == -1) {
+                                    error(F("Unexpected end of stream"), JSON_ERROR_UNEXPECTED_END);
+                                    return false;
+                                }
+                                error(F("Unsupported CBOR simple value"), JSON_ERROR_INVALID_VALUE);
+                                if (!recoverableError(JSON_ERROR_INVALID_VALUE)) {
+                                    return false;
+                                }
+                                break;
+                        }
+                        break;
+                    default:
+                        break;
+                }
+
+                if (isKey) {
+                    if (_type != JSON_TYPE_STRING && _type != JSON_TYPE_INT) {
+                        error(F("Invalid CBOR map key"), JSON_ERROR_INVALID_VALUE);
+                        return false;
+                    }
+                    __LDBG_printf("got key '%s' at %d", _valueStr.c_str(), getLength());
+                    _keyStr = std::move(_valueStr);
+                    _keyPosition = itemPosition;
+                    _valueStr = String();
+                    _type = JSON_TYPE_INVALID;
+                }
+                else {
+                    _valuePosition = itemPosition;
+                    if (_type != JSON_TYPE_INVALID && !_processCborElement()) {
+                        return false;
+                    }
+                }
+            }
+
+            // the item is complete. close all containers that reached their end
+            for(;;) {
+                if (closed) {
+                    __LDBG_printf("closing level %d array %d count %d", _level, _arrayIndex, _count);
+                    _type = _count ? JSON_TYPE_INVALID : JSON_TYPE_OBJECT_END;
+                    if (!endObject()) {
+                        return false;
+                    }
+                    if (_level-- == 0) {
+                        error(F("Out of bounds"), JSON_ERROR_OUT_OF_BOUNDS);
+                        return false;
+                    }
+                    _arrayIndex = _stack.back().arrayIndex;
+                    _count = _stack.back().count;
+                    _stack.pop_back();
+                    containers.pop_back();
+                    _type = JSON_TYPE_OBJECT_END;
+                    closed = false;
+                }
+                if (containers.empty()) {
+                    break;
+                }
+                auto &parent = containers.back();
+                if (parent.isMap) {
+                    if (!parent.expectKey) {
+                        _keyStr = String();
+                    }
+                    parent.expectKey = !parent.expectKey;
+                }
+                else if (_arrayIndex != -1) {
+                    _arrayIndex++;
+                }
+                if (parent.indefinite || --parent.remaining) {
+                    break;
+                }
+                closed = true;
+            }
+        }
+        if (!containers.empty()) {
+            error(F("Unexpected end of stream"), JSON_ERROR_UNEXPECTED_END);
+            return false;
+        }
+        __LDBG_printf("CBOR parser end");
+        return true;
+    }
+
+}
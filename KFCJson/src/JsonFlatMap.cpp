@@ -0,0 +1,256 @@
+/**
+* Author: sascha_lammers@gmx.de
+*/
+
+#include <algorithm>
+#include "JsonFlatMap.h"
+
+#if DEBUG_KFC_JSON
+#include <debug_helper_enable.h>
+#else
+#include <debug_helper_disable.h>
+#endif
+
+namespace KFCJson {
+
+    namespace {
+
+        // compare two strings that consist of 2 segments each
+        int compareSegments(const char *a1, size_t a1Len, const char *a2, size_t a2Len, const char *b1, size_t b1Len, const char *b2, size_t b2Len)
+        {
+            for(;;) {
+                if (!a1Len && a2Len) {
+                    a1 = a2;
+                    a1Len = a2Len;
+                    a2Len = 0;
+                }
+                if (!b1Len && b2Len) {
+                    b1 = b2;
+                    b1Len = b2Len;
+                    b2Len = 0;
+                }
+                if (!a1Len || !b1Len) {
+                    return (a1Len ? 1 : 0) - (b1Len ? 1 : 0);
+                }
+                auto len = std::min(a1Len, b1Len);
+                int result = memcmp(a1, b1, len);
+                if (result) {
+                    return result;
+                }
+                a1 += len;
+                a1Len -= len;
+                b1 += len;
+                b1Len -= len;
+            }
+        }
+
+    }
+
+    void JsonFlatMap::clear()
+    {
+        _pool = decltype(_pool)();
+        _entries = decltype(_entries)();
+        _internTable = decltype(_internTable)();
+        _hashTable = decltype(_hashTable)();
+        _internCount = 0;
+        _sorted = true;
+    }
+
+    void JsonFlatMap::setHashIndex(bool enable)
+    {
+        _hashIndex = enable;
+        if (!enable) {
+            _hashTable = decltype(_hashTable)();
+        }
+        else if (_sorted && _entries.size()) {
+            _buildHashIndex();
+        }
+    }
+
+    JsonFlatMap::String_t JsonFlatMap::addString(const char *str, size_t length)
+    {
+        if (length > kMaxLength) {
+            __DBG_printf("string too long length=%u", static_cast<unsigned>(length));
+            return String_t();
+        }
+        String_t result(_pool.size(), length);
+        _pool.insert(_pool.end(), str, str + length);
+        return result;
+    }
+
+    JsonFlatMap::String_t JsonFlatMap::internString(const char *str, size_t length)
+    {
+        if (length > kMaxLength) {
+            return addString(str, length);
+        }
+        if (_internCount * 2 >= _internTable.size()) {
+            _growInternTable();
+        }
+        auto mask = _internTable.size() - 1;
+        auto index = _hash(str, length) & mask;
+        for(;;) {
+            auto &slot = _internTable[index];
+            if (!slot.isValid()) {
+                slot = addString(str, length);
+                _internCount++;
+                return slot;
+            }
+            if (slot.length == length && memcmp(_ptr(slot), str, length) == 0) {
+                return slot;
+            }
+            index = (index + 1) & mask;
+        }
+    }
+
+    void JsonFlatMap::_growInternTable()
+    {
+        decltype(_internTable) table(std::max<size_t>(32, _internTable.size() * 2));
+        auto mask = table.size() - 1;
+        for(const auto &str: _internTable) {
+            if (str.isValid()) {
+                auto index = _hash(_ptr(str), str.length) & mask;
+                while (table[index].isValid()) {
+                    index = (index + 1) & mask;
+                }
+                table[index] = str;
+            }
+        }
+        _internTable = std::move(table);
+    }
+
+    bool JsonFlatMap::add(const String_t &prefix, const String_t &suffix, JsonType_t type, const String &value)
+    {
+        if (!prefix.isValid() || !suffix.isValid()) {
+            return false;
+        }
+        auto str = addString(value.c_str(), value.length());
+        if (!str.isValid()) {
+            return false;
+        }
+        _entries.push_back({prefix, suffix, str, type});
+        _sorted = false;
+        return true;
+    }
+
+    void JsonFlatMap::finalize()
+    {
+        if (_sorted) {
+            return;
+        }
+        _sorted = true;
+        _internTable = decltype(_internTable)();
+        _internCount = 0;
+
+        std::stable_sort(_entries.begin(), _entries.end(), [this](const Entry &a, const Entry &b) {
+            return _compare(a, b) < 0;
+        });
+
+        // remove duplicates, keep the last value added
+        auto dst = _entries.begin();
+        for(auto iter = _entries.begin(); iter != _entries.end(); ++iter) {
+            auto next = iter + 1;
+            if (next != _entries.end() && _compare(*iter, *next) == 0) {
+                continue;
+            }
+            *dst++ = *iter;
+        }
+        _entries.erase(dst, _entries.end());
+        _entries.shrink_to_fit();
+        _pool.shrink_to_fit();
+
+        if (_hashIndex) {
+            _buildHashIndex();
+        }
+    }
+
+    void JsonFlatMap::_buildHashIndex()
+    {
+        size_t size = 16;
+        while (size < _entries.size() * 2) {
+            size <<= 1;
+        }
+        _hashTable = decltype(_hashTable)(size);
+        auto mask = size - 1;
+        for(size_t i = 0; i < _entries.size(); i++) {
+            auto index = _hash(_entries[i]) & mask;
+            while (_hashTable[index]) {
+                index = (index + 1) & mask;
+            }
+            _hashTable[index] = i + 1;
+        }
+    }
+
+    const JsonFlatMap::Entry *JsonFlatMap::find(const char *path, size_t length)
+    {
+        finalize();
+        if (_hashIndex && !_hashTable.empty()) {
+            auto mask = _hashTable.size() - 1;
+            auto index = _hash(path, length) & mask;
+            while (_hashTable[index]) {
+                auto &entry = _entries[_hashTable[index] - 1];
+                if (_compare(entry, path, length) == 0) {
+                    return &entry;
+                }
+                index = (index + 1) & mask;
+            }
+            return nullptr;
+        }
+        auto iter = std::lower_bound(_entries.begin(), _entries.end(), path, [this, length](const Entry &entry, const char *path) {
+            return _compare(entry, path, length) < 0;
+        });
+        if (iter != _entries.end() && _compare(*iter, path, length) == 0) {
+            return &(*iter);
+        }
+        return nullptr;
+    }
+
+    String JsonFlatMap::getKey(const Entry &entry) const
+    {
+        String key;
+        if (key.reserve(entry.prefix.length + entry.suffix.length)) {
+            key.concat(_ptr(entry.prefix), entry.prefix.length);
+            key.concat(_ptr(entry.suffix), entry.suffix.length);
+        }
+        return key;
+    }
+
+    String JsonFlatMap::getValue(const Entry &entry) const
+    {
+        String value;
+        if (value.reserve(entry.value.length)) {
+            value.concat(_ptr(entry.value), entry.value.length);
+        }
+        return value;
+    }
+
+    size_t JsonFlatMap::memoryUsage() const
+    {
+        return _pool.capacity() + (_entries.capacity() * sizeof(Entry)) + (_internTable.capacity() * sizeof(String_t)) + (_hashTable.capacity() * sizeof(uint32_t));
+    }
+
+    int JsonFlatMap::_compare(const Entry &entry, const char *str, size_t length) const
+    {
+        return compareSegments(_ptr(entry.prefix), entry.prefix.length, _ptr(entry.suffix), entry.suffix.length, str, length, nullptr, 0);
+    }
+
+    int JsonFlatMap::_compare(const Entry &a, const Entry &b) const
+    {
+        return compareSegments(_ptr(a.prefix), a.prefix.length, _ptr(a.suffix), a.suffix.length, _ptr(b.prefix), b.prefix.length, _ptr(b.suffix), b.suffix.length);
+    }
+
+    uint32_t JsonFlatMap::_hash(const char *str, size_t length, uint32_t hash) const
+    {
+        // FNV-1a
+        while (length--) {
+            hash ^= static_cast<uint8_t>(*str++);
+            hash *= 16777619U;
+        }
+        return hash;
+    }
+
+    uint32_t JsonFlatMap::_hash(const Entry &entry) const
+    {
+        return _hash(_ptr(entry.suffix), entry.suffix.length, _hash(_ptr(entry.prefix), entry.prefix.length));
+    }
+
+}
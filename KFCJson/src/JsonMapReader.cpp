@@ -21,25 +21,69 @@ namespace KFCJson {
         _filter = filter;
     }
 
+    void JsonMapReader::setHashIndex(bool enable)
+    {
+        _map.setHashIndex(enable);
+    }
+
+    bool JsonMapReader::beginObject(bool isArray)
+    {
+        if (getLevel() == 1) {
+            _prefixes.clear();
+        }
+        _prefixes.emplace_back();
+        return true;
+    }
+
+    bool JsonMapReader::endObject()
+    {
+        if (!_prefixes.empty()) {
+            _prefixes.pop_back();
+        }
+        return true;
+    }
+
     bool JsonMapReader::processElement() {
-        String path = getPath();
-        if (!_filter || _filter(path, getValue(), getType(), *this)) {
-            _map[path] = JsonVar(getType(), getValue());
+        if (_filter && !_filter(getPath(), getValue(), getType(), *this)) {
+            return true;
+        }
+        if (_prefixes.empty()) {
+            _prefixes.emplace_back();
+        }
+        auto &prefix = _prefixes.back();
+        if (!prefix.isValid()) {
+            auto path = getObjectPath();
+            prefix = _map.addString(path.c_str(), path.length());
+        }
+        // the suffix is the key or array index of the path
+        String suffix;
+        if (_keyStr.length()) {
+            if (prefix.length) {
+                suffix += '.';
+            }
+            suffix += _keyStr;
+        }
+        if (_arrayIndex != -1) {
+            _appendIndex(_arrayIndex, suffix, true);
+        }
+        if (!_map.add(prefix, _map.internString(suffix.c_str(), suffix.length()), getType(), _valueStr)) {
+            error(F("Path or value exceeds the maximum length"), JSON_ERROR_INVALID_VALUE);
+            return recoverableError(JSON_ERROR_INVALID_VALUE);
         }
         return true;
     }
 
     void JsonMapReader::dump(Print &out) {
-        for (auto &element : _map) {
-            auto &var = element.second;
-            out.printf_P(PSTR("%s=%s (%s)\n"), element.first.c_str(), JsonVar::formatValue(var.getValue().c_str(), var.getType()).c_str(), jsonType2String(var.getType()));
+        for (auto iter = _map.begin(); iter != _map.end(); ++iter) {
+            auto &entry = *iter;
+            out.printf_P(PSTR("%s=%s (%s)\n"), _map.getKey(entry).c_str(), JsonVar::formatValue(_map.getValue(entry), entry.type).c_str(), jsonType2String(entry.type));
         }
     }
 
     JsonVar JsonMapReader::get(const String &path) const {
-        auto it = _map.find(path);
-        if (it != _map.end()) {
-            return it->second;
+        auto entry = _map.find(path);
+        if (entry) {
+            return _map.getVar(*entry);
         }
         return JsonVar();
     }
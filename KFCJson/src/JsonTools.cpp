@@ -18,15 +18,106 @@ namespace KFCJson {
         return value ? FSPGM(true) : FSPGM(false);
     }
 
+    namespace {
+
+        // word at a time scanning for characters that need special treatment
+        //
+        // strings are read in aligned 32 bit words, which also works for PROGMEM. if a word does not contain any
+        // NUL byte, control character, quote, backslash or (with UTF8 encoding) non-ASCII byte, it is copied as a whole
+        // otherwise the characters of the word are processed one by one
+
+        static constexpr uint32_t kOnes = 0x01010101U;
+        static constexpr uint32_t kHighBits = 0x80808080U;
+
+        inline __attribute__((__always_inline__))
+        bool hasZeroByte(uint32_t word) {
+            return ((word - kOnes) & ~word & kHighBits) != 0;
+        }
+
+        // nonAsciiMask is kHighBits to detect bytes >= 0x80 or 0 to ignore them
+        inline __attribute__((__always_inline__))
+        bool hasSpecialChar(uint32_t word, uint32_t nonAsciiMask) {
+            return
+                ((word - (kOnes * 0x20)) & ~word & kHighBits) ||    // < 0x20, includes NUL
+                hasZeroByte(word ^ (kOnes * '"')) ||
+                hasZeroByte(word ^ (kOnes * '\\')) ||
+                (word & nonAsciiMask);
+        }
+
+        inline __attribute__((__always_inline__))
+        bool isAligned(PGM_P ptr) {
+            return (reinterpret_cast<uintptr_t>(ptr) & (sizeof(uint32_t) - 1)) == 0;
+        }
+
+        // collects characters that do not require encoding and writes them in chunks
+        class WriteBuffer {
+        public:
+            WriteBuffer(Print &output) : _output(output), _written(0), _length(0) {}
+
+            inline __attribute__((__always_inline__))
+            void write(char ch) {
+                if (_length == sizeof(_buf)) {
+                    flush();
+                }
+                _buf[_length++] = ch;
+            }
+
+            inline __attribute__((__always_inline__))
+            void write(uint32_t word) {
+                if (_length > sizeof(_buf) - sizeof(word)) {
+                    flush();
+                }
+                memcpy(&_buf[_length], &word, sizeof(word));
+                _length += sizeof(word);
+            }
+
+            inline __attribute__((__always_inline__))
+            void flush() {
+                if (_length) {
+                    _written += _output.write(_buf, _length);
+                    _length = 0;
+                }
+            }
+
+            inline __attribute__((__always_inline__))
+            size_t written() const {
+                return _written;
+            }
+
+        private:
+            Print &_output;
+            size_t _written;
+            uint8_t _length;
+            uint8_t _buf[32];
+        };
+
+    }
+
     size_t JsonTools::lengthEscaped(PGM_P value, size_t length, Utf8Buffer *buffer)
     {
         if (!length) {
             return 0;
         }
         size_t outputLen = 0;
+        uint32_t nonAsciiMask = buffer ? kHighBits : 0;
         char ch = 0;
-        if (buffer) {
-            while (length-- && (ch = static_cast<char>(pgm_read_byte(value++)))) {
+        while (length) {
+            // fast path for aligned words without special characters
+            if (isAligned(value) && (!buffer || !buffer->counter())) {
+                while (length >= sizeof(uint32_t) && !hasSpecialChar(pgm_read_dword(value), nonAsciiMask)) {
+                    outputLen += sizeof(uint32_t);
+                    value += sizeof(uint32_t);
+                    length -= sizeof(uint32_t);
+                }
+                if (!length) {
+                    break;
+                }
+            }
+            length--;
+            if (!(ch = static_cast<char>(pgm_read_byte(value++)))) {
+                break;
+            }
+            if (buffer) {
                 auto codepoint = buffer->feed(ch);
                 switch (static_cast<ErrorType>(codepoint)) {
                 case ErrorType::NO_ENCODING_REQUIRED:
@@ -46,15 +137,11 @@ namespace KFCJson {
                     break;
                 }
             }
-        }
-        else {
-            while (length-- && (ch = static_cast<char>(pgm_read_byte(value++)))) {
-                if (escape(ch)) {
-                    outputLen += 2;
-                }
-                else {
-                    outputLen++;
-                }
+            else if (escape(ch)) {
+                outputLen += 2;
+            }
+            else {
+                outputLen++;
             }
         }
         return outputLen;
@@ -66,44 +153,58 @@ namespace KFCJson {
             return 0;
         }
         size_t outputLen = 0;
+        WriteBuffer out(output);
+        uint32_t nonAsciiMask = buffer ? kHighBits : 0;
         char ch = 0;
-        if (buffer) {
-            while (length-- && (ch = static_cast<char>(pgm_read_byte(value++)))) {
+        while (length) {
+            // fast path for aligned words without special characters
+            if (isAligned(value) && (!buffer || !buffer->counter())) {
+                uint32_t word;
+                while (length >= sizeof(uint32_t) && !hasSpecialChar(word = pgm_read_dword(value), nonAsciiMask)) {
+                    out.write(word);
+                    value += sizeof(uint32_t);
+                    length -= sizeof(uint32_t);
+                }
+                if (!length) {
+                    break;
+                }
+            }
+            length--;
+            if (!(ch = static_cast<char>(pgm_read_byte(value++)))) {
+                break;
+            }
+            if (buffer) {
                 auto result = buffer->feed(ch);
                 switch (static_cast<ErrorType>(result)) {
-                case ErrorType::NO_ENCODING_REQUIRED: {
-                    size_t result;
+                case ErrorType::NO_ENCODING_REQUIRED:
                     if (escape(ch)) {
-                        result = printEscaped(output, ch);
+                        out.flush();
+                        outputLen += printEscaped(output, ch);
                     }
                     else {
-                        result = output.print(ch);
+                        out.write(ch);
                     }
-                    outputLen += result;
-                } break;
+                    break;
                 case ErrorType::MORE_DATA_REQUIRED:
                 case ErrorType::INVALID_SEQUENCE:
                 case ErrorType::INVALID_UNICODE_SYMBOL:
                     break;
                 default:
+                    out.flush();
                     outputLen += buffer->printTo(output, result);
                     break;
                 }
             }
-        }
-        else {
-            size_t result;
-            while (length-- && (ch = static_cast<char>(pgm_read_byte(value++)))) {
-                if (escape(ch)) {
-                    result = printEscaped(output, ch);
-                }
-                else {
-                    result = output.print(ch);
-                }
-                outputLen += result;
+            else if (escape(ch)) {
+                out.flush();
+                outputLen += printEscaped(output, ch);
+            }
+            else {
+                out.write(ch);
             }
         }
-        return outputLen;
+        out.flush();
+        return outputLen + out.written();
     }
 
     int32_t JsonTools::Utf8Buffer::feed(uint8_t ch)
@@ -35,9 +35,6 @@ namespace JsonVariableReader {
         for (auto element : _elements) {
             delete element;
         }
-        for (auto result : _results) {
-            delete result;
-        }
     }
 
     ElementGroup::ElementPtr ElementGroup::add(const JsonString &path, Element::AssignCallback callback)
@@ -69,15 +66,19 @@ namespace JsonVariableReader {
 
     ElementGroup::ResultPtr ElementGroup::getLastResult()
     {
-        __LDBG_assert(_results.size() != 0); // initResultType() must be used when creating the object
-        return _results.back();
+        __LDBG_assert(_results); // initResultType() must be used when creating the object
+        return &_results->current();
     }
 
     void ElementGroup::flushResult()
     {
-        auto result = getLastResult()->create();
-        if (result) {
-            _results.emplace_back(result);
+        _results->flush();
+    }
+
+    void ElementGroup::clearResults()
+    {
+        if (_results) {
+            _results->reset();
         }
     }
 
@@ -96,6 +97,17 @@ namespace JsonVariableReader {
         return _elementGroups;
     }
 
+    void Reader::initParser()
+    {
+        for (auto &group : *_elementGroups) {
+            group.clearResults();
+        }
+        _current = nullptr;
+        _level = 0;
+        _skip = false;
+        JsonBaseReader::initParser();
+    }
+
     bool Reader::beginObject(bool isArray)
     {
         //auto pathStr = getObjectPath(false);
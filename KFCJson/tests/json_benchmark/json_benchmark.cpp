@@ -0,0 +1,517 @@
+/**
+ * Author: sascha_lammers@gmx.de
+ */
+
+// Host benchmark for the KFCJson readers and the serializer
+//
+// Runs JsonCallbackReader, JsonVariableReader::Reader, JsonMapReader and JsonConverter + AbstractJsonValue::printTo()
+// against a set of generated documents and prints one JSON object per line
+//
+// {"corpus":"onecall","reader":"callback","bytes":18432,"iterations":200,"mb_per_s":12.345,"allocs":...,"allocs_per_kb":...,"peak_heap":...,"alloc_hook":"malloc"}
+//
+// allocs/peak_heap are tracked with
+// - crt: the CRT allocation hook (MSVC debug build)
+// - malloc: malloc(), calloc(), realloc() and free() wrapped by the linker. requires JSON_BENCHMARK_WRAP_MALLOC=1 and
+//   -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc,--wrap=free (GNU ld, see tests/host/CMakeLists.txt). operator
+//   new/delete are replaced to use the wrapped functions. the sizes are the usable sizes of the blocks
+// - operator_new: replacing the global operator new/delete. allocations made with malloc/realloc (String, JsonString)
+//   are not counted and the numbers are too low
+//
+// usage: json_benchmark [iterations]
+
+#include <Arduino_compat.h>
+#include <chrono>
+#include <HeapStream.h>
+#include <NullStream.h>
+#include <PrintString.h>
+#include "KFCJson.h"
+#include "JsonConverter.h"
+#include "JsonMapReader.h"
+#include "JsonVariableReader.h"
+
+#if _MSC_VER && _DEBUG
+#include <crtdbg.h>
+#elif JSON_BENCHMARK_WRAP_MALLOC
+#include <malloc.h>
+#endif
+
+using namespace KFCJson;
+
+namespace AllocStats {
+
+    static size_t count;
+    static size_t current;
+    static size_t peak;
+    static bool enabled;
+
+    void reset()
+    {
+        count = 0;
+        current = 0;
+        peak = 0;
+    }
+
+    inline void alloc(size_t size)
+    {
+        if (enabled) {
+            count++;
+            current += size;
+            if (current > peak) {
+                peak = current;
+            }
+        }
+    }
+
+    inline void free(size_t size)
+    {
+        if (enabled) {
+            current = (size > current) ? 0 : current - size;
+        }
+    }
+
+#if _MSC_VER && _DEBUG
+
+    int hook(int allocType, void *userData, size_t size, int blockType, long requestNumber, const unsigned char *filename, int lineNumber)
+    {
+        if (blockType == _CRT_BLOCK) {
+            return TRUE;
+        }
+        switch(allocType) {
+            case _HOOK_ALLOC:
+                alloc(size);
+                break;
+            case _HOOK_REALLOC:
+                if (userData) {
+                    free(_msize_dbg(userData, blockType));
+                }
+                alloc(size);
+                break;
+            case _HOOK_FREE:
+                if (userData) {
+                    free(_msize_dbg(userData, blockType));
+                }
+                break;
+        }
+        return TRUE;
+    }
+
+    void begin()
+    {
+        _CrtSetAllocHook(hook);
+    }
+
+    static constexpr auto kHook = "crt";
+
+#elif JSON_BENCHMARK_WRAP_MALLOC
+
+    void begin()
+    {
+    }
+
+    static constexpr auto kHook = "malloc";
+
+#else
+
+    void begin()
+    {
+    }
+
+    static constexpr auto kHook = "operator_new";
+
+#endif
+
+}
+
+#if JSON_BENCHMARK_WRAP_MALLOC && !(_MSC_VER && _DEBUG)
+
+extern "C" {
+
+    void *__real_malloc(size_t size);
+    void *__real_calloc(size_t count, size_t size);
+    void *__real_realloc(void *ptr, size_t size);
+    void __real_free(void *ptr);
+
+    void *__wrap_malloc(size_t size)
+    {
+        auto ptr = __real_malloc(size);
+        if (ptr) {
+            AllocStats::alloc(malloc_usable_size(ptr));
+        }
+        return ptr;
+    }
+
+    void *__wrap_calloc(size_t count, size_t size)
+    {
+        auto ptr = __real_calloc(count, size);
+        if (ptr) {
+            AllocStats::alloc(malloc_usable_size(ptr));
+        }
+        return ptr;
+    }
+
+    void *__wrap_realloc(void *ptr, size_t size)
+    {
+        auto oldSize = ptr ? malloc_usable_size(ptr) : 0;
+        auto newPtr = __real_realloc(ptr, size);
+        // the old block is kept if realloc() fails
+        if (newPtr || size == 0) {
+            AllocStats::free(oldSize);
+        }
+        if (newPtr) {
+            AllocStats::alloc(malloc_usable_size(newPtr));
+        }
+        return newPtr;
+    }
+
+    void __wrap_free(void *ptr)
+    {
+        if (ptr) {
+            AllocStats::free(malloc_usable_size(ptr));
+        }
+        __real_free(ptr);
+    }
+
+}
+
+// the default implementation in libstdc++ calls the malloc() that is not wrapped
+void *operator new(size_t size)
+{
+    auto ptr = malloc(size);
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void operator delete(void *ptr) noexcept
+{
+    free(ptr);
+}
+
+#elif !(_MSC_VER && _DEBUG)
+
+// the size is stored in front of the allocated block
+static constexpr size_t kAllocHeader = alignof(std::max_align_t);
+
+void *operator new(size_t size)
+{
+    auto ptr = reinterpret_cast<uint8_t *>(malloc(size + kAllocHeader));
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    *reinterpret_cast<size_t *>(ptr) = size;
+    AllocStats::alloc(size);
+    return ptr + kAllocHeader;
+}
+
+void operator delete(void *ptr) noexcept
+{
+    if (ptr) {
+        auto block = reinterpret_cast<uint8_t *>(ptr) - kAllocHeader;
+        AllocStats::free(*reinterpret_cast<size_t *>(block));
+        free(block);
+    }
+}
+
+#endif
+
+#if !(_MSC_VER && _DEBUG)
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    operator delete(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+    operator delete(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept
+{
+    operator delete(ptr);
+}
+
+#endif
+
+//
+// corpus
+//
+
+// OpenWeatherMap OneCall 3.0 response with 48 hourly and 8 daily forecasts
+String createOneCall()
+{
+    PrintString out;
+    out.print(F("{\"lat\":49.2827,\"lon\":-123.1207,\"timezone\":\"America/Vancouver\",\"timezone_offset\":-25200,\"current\":{\"dt\":1684929490,\"sunrise\":1684926645,\"sunset\":1684977332,\"temp\":292.55,\"feels_like\":292.87,\"pressure\":1014,\"humidity\":89,\"dew_point\":290.69,\"uvi\":0.16,\"clouds\":53,\"visibility\":10000,\"wind_speed\":3.13,\"wind_deg\":93,\"wind_gust\":6.71,\"weather\":[{\"id\":803,\"main\":\"Clouds\",\"description\":\"broken clouds\",\"icon\":\"04d\"}]},\"hourly\":["));
+    for(int i = 0; i < 48; i++) {
+        if (i) {
+            out.print(',');
+        }
+        out.printf_P(PSTR("{\"dt\":%u,\"temp\":%.2f,\"feels_like\":%.2f,\"pressure\":%u,\"humidity\":%u,\"dew_point\":%.2f,\"uvi\":%.2f,\"clouds\":%u,\"visibility\":10000,\"wind_speed\":%.2f,\"wind_deg\":%u,\"wind_gust\":%.2f,\"weather\":[{\"id\":%u,\"main\":\"Rain\",\"description\":\"light rain\",\"icon\":\"10d\"}],\"pop\":%.2f,\"rain\":{\"1h\":%.2f}}"),
+            1684926000 + i * 3600, 290.0 + (i % 7) * 0.37, 289.0 + (i % 5) * 0.41, 1010 + (i % 9), 60 + (i % 30), 285.0 + (i % 3) * 0.1,
+            (i % 12) * 0.33, (i * 7) % 100, (i % 11) * 0.57, (i * 37) % 360, (i % 13) * 0.61, 500 + (i % 4), (i % 10) * 0.1, (i % 6) * 0.23
+        );
+    }
+    out.print(F("],\"daily\":["));
+    for(int i = 0; i < 8; i++) {
+        if (i) {
+            out.print(',');
+        }
+        out.printf_P(PSTR("{\"dt\":%u,\"sunrise\":%u,\"sunset\":%u,\"moonrise\":%u,\"moonset\":%u,\"moon_phase\":%.2f,\"summary\":\"Expect a day of partly cloudy with rain\",\"temp\":{\"day\":%.2f,\"min\":%.2f,\"max\":%.2f,\"night\":%.2f,\"eve\":%.2f,\"morn\":%.2f},\"feels_like\":{\"day\":%.2f,\"night\":%.2f,\"eve\":%.2f,\"morn\":%.2f},\"pressure\":%u,\"humidity\":%u,\"dew_point\":%.2f,\"wind_speed\":%.2f,\"wind_deg\":%u,\"weather\":[{\"id\":500,\"main\":\"Rain\",\"description\":\"light rain\",\"icon\":\"10d\"}],\"clouds\":%u,\"pop\":%.2f,\"uvi\":%.2f}"),
+            1684951200 + i * 86400, 1684926645 + i * 86400, 1684977332 + i * 86400, 1684932000 + i * 86400, 1684990000 + i * 86400, i * 0.125,
+            292.0 + i, 284.0 + i, 296.0 + i, 287.0 + i, 293.0 + i, 285.0 + i, 291.0 + i, 286.0 + i, 292.0 + i, 284.0 + i,
+            1008 + i, 55 + i, 283.0 + i * 0.1, 4.0 + i * 0.3, (i * 45) % 360, 20 + i * 5, i * 0.1, 5.0 + i * 0.2
+        );
+    }
+    out.print(F("]}"));
+    return out;
+}
+
+// configuration export with mixed value types
+String createConfigExport()
+{
+    PrintString out;
+    out.print(F("{\"version\":\"0.1.6\",\"config\":{"));
+    for(int i = 0; i < 600; i++) {
+        if (i) {
+            out.print(',');
+        }
+        switch(i % 5) {
+            case 0:
+                out.printf_P(PSTR("\"plugin_%03u.value_%u\":%d"), i / 10, i, i * 1337 - 100000);
+                break;
+            case 1:
+                out.printf_P(PSTR("\"plugin_%03u.value_%u\":%.5f"), i / 10, i, i * 0.0173);
+                break;
+            case 2:
+                out.printf_P(PSTR("\"plugin_%03u.value_%u\":%s"), i / 10, i, (i & 1) ? "true" : "false");
+                break;
+            case 3:
+                out.printf_P(PSTR("\"plugin_%03u.value_%u\":null"), i / 10, i);
+                break;
+            default:
+                out.printf_P(PSTR("\"plugin_%03u.value_%u\":\"string value #%u for the configuration export\""), i / 10, i, i);
+                break;
+        }
+    }
+    out.print(F("}}"));
+    return out;
+}
+
+// nested objects and arrays up to the given level
+String createDeepNesting(int levels = 100, int repeat = 16)
+{
+    PrintString out;
+    out.print('[');
+    for(int n = 0; n < repeat; n++) {
+        if (n) {
+            out.print(',');
+        }
+        for(int i = 0; i < levels; i++) {
+            if (i & 1) {
+                out.printf_P(PSTR("[%u,"), i);
+            }
+            else {
+                out.printf_P(PSTR("{\"level_%u\":"), i);
+            }
+        }
+        out.print(F("\"bottom\""));
+        for(int i = levels - 1; i >= 0; i--) {
+            out.print((i & 1) ? ']' : '}');
+        }
+    }
+    out.print(']');
+    return out;
+}
+
+// long strings with a few escape sequences
+String createLongStrings(int count = 16, int length = 4096)
+{
+    PrintString out;
+    out.print(F("{\"items\":["));
+    for(int n = 0; n < count; n++) {
+        if (n) {
+            out.print(',');
+        }
+        out.print('"');
+        for(int i = 0; i < length; i++) {
+            if (i % 512 == 511) {
+                out.print(F("\\n"));
+            }
+            else if (i % 1024 == 777) {
+                out.print(F("\\\""));
+            }
+            else {
+                out.print((char)('a' + ((i + n) % 26)));
+            }
+        }
+        out.print('"');
+    }
+    out.print(F("]}"));
+    return out;
+}
+
+// strings made of \uXXXX sequences
+String createUnicodeEscapes(int count = 256)
+{
+    static const char *words[] = { "\\u00e4\\u00f6\\u00fc\\u00df", "\\u65e5\\u672c\\u8a9e", "\\u0416\\u0443\\u043a", "caf\\u00e9", "\\u20ac 100", "\\ud83d\\ude00" };
+    PrintString out;
+    out.print('[');
+    for(int n = 0; n < count; n++) {
+        if (n) {
+            out.print(',');
+        }
+        out.printf_P(PSTR("{\"id\":%u,\"name\":\"%s %s %s\"}"), n, words[n % 6], words[(n + 1) % 6], words[(n + 3) % 6]);
+    }
+    out.print(']');
+    return out;
+}
+
+//
+// readers
+//
+
+class OneCallHourly : public JsonVariableReader::Result {
+public:
+    OneCallHourly() : _dt(0), _temp(0), _humidity(0) {
+    }
+
+    virtual bool empty() const {
+        return _dt == 0;
+    }
+
+    static void apply(JsonVariableReader::ElementGroup &group) {
+        group.initResultType<OneCallHourly>();
+        group.add(F("dt"), [](JsonVariableReader::Result &result, JsonVariableReader::Reader &reader) {
+            reinterpret_cast<OneCallHourly &>(result)._dt = reader.getIntValue();
+            return true;
+        });
+        group.add(F("temp"), [](JsonVariableReader::Result &result, JsonVariableReader::Reader &reader) {
+            reinterpret_cast<OneCallHourly &>(result)._temp = reader.getFloatValue();
+            return true;
+        });
+        group.add(F("humidity"), [](JsonVariableReader::Result &result, JsonVariableReader::Reader &reader) {
+            reinterpret_cast<OneCallHourly &>(result)._humidity = reader.getIntValue();
+            return true;
+        });
+    }
+
+    uint32_t _dt;
+    float _temp;
+    uint8_t _humidity;
+};
+
+size_t runCallbackReader(const String &json)
+{
+    HeapStream stream(json);
+    size_t elements = 0;
+    JsonCallbackReader reader(stream, [&elements](const String &key, const String &value, size_t partialLength, JsonBaseReader &jsonReader) {
+        elements++;
+        return true;
+    });
+    reader.parse();
+    return elements;
+}
+
+size_t runVariableReader(const String &json)
+{
+    HeapStream stream(json);
+    JsonVariableReader::Reader reader;
+    auto groups = reader.getElementGroups();
+    groups->emplace_back(F("hourly[]"));
+    OneCallHourly::apply(groups->back());
+    reader.setStream(&stream);
+    reader.parse();
+    return groups->back().getResults<OneCallHourly>().size();
+}
+
+size_t runMapReader(const String &json)
+{
+    HeapStream stream(json);
+    JsonMapReader reader(stream);
+    reader.parse();
+    return reader.getLength();
+}
+
+size_t runSerializer(const String &json)
+{
+    HeapStream stream(json);
+    JsonConverter converter(stream);
+    converter.parse();
+    auto root = converter.getRoot();
+    if (!root) {
+        return 0;
+    }
+    NullStream out;
+    size_t length = 0;
+    for(int i = 0; i < 4; i++) {
+        length += root->printTo(out);
+    }
+    delete root;
+    return length;
+}
+
+//
+// runner
+//
+
+typedef size_t (*BenchmarkFunc)(const String &json);
+
+void benchmark(const char *corpus, const String &json, const char *name, BenchmarkFunc func, int iterations)
+{
+    func(json); // warm up
+
+    AllocStats::reset();
+    AllocStats::enabled = true;
+    auto start = std::chrono::steady_clock::now();
+    size_t result = 0;
+    for(int i = 0; i < iterations; i++) {
+        result += func(json);
+    }
+    auto end = std::chrono::steady_clock::now();
+    AllocStats::enabled = false;
+
+    auto seconds = std::chrono::duration<double>(end - start).count();
+    auto bytes = static_cast<double>(json.length()) * iterations;
+    auto mbPerSecond = seconds > 0 ? (bytes / (1024.0 * 1024.0)) / seconds : 0.0;
+    auto allocsPerKb = bytes > 0 ? AllocStats::count / (bytes / 1024.0) : 0.0;
+
+    ::printf("{\"corpus\":\"%s\",\"reader\":\"%s\",\"bytes\":%u,\"iterations\":%d,\"seconds\":%.6f,\"mb_per_s\":%.3f,\"allocs\":%u,\"allocs_per_kb\":%.3f,\"peak_heap\":%u,\"alloc_hook\":\"%s\",\"result\":%u}\n",
+        corpus, name, (unsigned)json.length(), iterations, seconds, mbPerSecond, (unsigned)AllocStats::count, allocsPerKb, (unsigned)AllocStats::peak, AllocStats::kHook, (unsigned)result
+    );
+}
+
+int main(int argc, const char *argv[])
+{
+    int iterations = (argc > 1) ? atoi(argv[1]) : 100;
+    if (iterations < 1) {
+        iterations = 1;
+    }
+
+    AllocStats::begin();
+
+    struct {
+        const char *name;
+        String json;
+    } corpus[] = {
+        { "onecall", createOneCall() },
+        { "config_export", createConfigExport() },
+        { "deep_nesting", createDeepNesting() },
+        { "long_strings", createLongStrings() },
+        { "unicode_escapes", createUnicodeEscapes() },
+    };
+
+    for(auto &item: corpus) {
+        benchmark(item.name, item.json, "callback", runCallbackReader, iterations);
+        benchmark(item.name, item.json, "variable", runVariableReader, iterations);
+        benchmark(item.name, item.json, "map", runMapReader, iterations);
+        benchmark(item.name, item.json, "serializer", runSerializer, iterations);
+    }
+
+    return 0;
+}
@@ -0,0 +1,343 @@
+/**
+ * Author: sascha_lammers@gmx.de
+ */
+
+// Host test for the CBOR encoding of the KFCJson value model
+//
+// - encoder: JsonCbor::write*() compared to known byte sequences. integers at the boundaries of the argument sizes,
+//   negative integers, single and double precision floats, NaN, infinity, values outside the range of float and
+//   strings at the boundaries of the length encoding
+// - decoder: the items of the encoder test are read back with JsonCallbackReader and compared to the expected value
+//   and type
+// - documents: JSON documents are converted to a value tree and written with printCborTo(). the result is compared to
+//   known byte sequences and read back. the keys, values, types, levels and indices reported by JsonCallbackReader
+//   must match the ones of the JSON document
+// - round_trip: numbers are written with JsonCbor::writeNumber() and read back. the decoded string must be parsed to
+//   the same value and decoded to the same string after it has been encoded again. known values and random single
+//   and double precision values
+//
+// prints one JSON object per line and returns 0 if all checks passed
+//
+// {"test":"encoder","vectors":55,"errors":0,"result":"OK"}
+// {"test":"decoder","vectors":55,"errors":0,"result":"OK"}
+// {"test":"documents","documents":6,"errors":0,"result":"OK"}
+// {"test":"round_trip","numbers":19970,"errors":0,"result":"OK"}
+//
+// usage: json_cbor
+
+#include <Arduino_compat.h>
+#include <HeapStream.h>
+#include <PrintString.h>
+#include <float.h>
+#include <stdio.h>
+#include <functional>
+#include <random>
+#include <vector>
+#include <host_test.h>
+#include "KFCJson.h"
+#include "JsonCbor.h"
+#include "JsonCallbackReader.h"
+#include "JsonConverter.h"
+
+using namespace KFCJson;
+using HostTest::result;
+
+static String toHex(const String &data)
+{
+    String str;
+    char buf[3];
+    for(auto ch: data) {
+        snprintf(buf, sizeof(buf), "%02x", static_cast<uint8_t>(ch));
+        str += buf;
+    }
+    return str;
+}
+
+static String repeat(const char *str, size_t count)
+{
+    String result;
+    while(count--) {
+        result += str;
+    }
+    return result;
+}
+
+struct Vector {
+    String name;
+    std::function<size_t(Print &)> write;
+    String expected;            // hex
+    String value;               // value and type reported by the reader
+    JsonBaseReader::JsonType_t type;
+};
+
+static std::vector<Vector> createVectors()
+{
+    std::vector<Vector> vectors;
+    auto addUnsigned = [&vectors](uint64_t value, const char *expected) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%llu", static_cast<unsigned long long>(value));
+        vectors.push_back({ String("uint ") + buf, [value](Print &output) { return JsonCbor::writeUnsigned(output, value); }, expected, buf, JsonBaseReader::JSON_TYPE_INT });
+    };
+    auto addInt = [&vectors](int64_t value, const char *expected) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%lld", static_cast<long long>(value));
+        vectors.push_back({ String("int ") + buf, [value](Print &output) { return JsonCbor::writeInt(output, value); }, expected, buf, JsonBaseReader::JSON_TYPE_INT });
+    };
+    auto addDouble = [&vectors](const char *name, double value, const char *expected, const char *decoded, JsonBaseReader::JsonType_t type) {
+        vectors.push_back({ String("double ") + name, [value](Print &output) { return JsonCbor::writeDouble(output, value); }, expected, decoded, type });
+    };
+    auto addString = [&vectors](size_t length, const String &header) {
+        String str = String(std::string(length, 'a'));
+        vectors.push_back({ String("string ") + String(static_cast<unsigned>(length)), [str](Print &output) { return JsonCbor::writeString(output, str); }, header + repeat("61", length), str, JsonBaseReader::JSON_TYPE_STRING });
+    };
+
+    // RFC 8949 appendix A and the boundaries of the argument sizes
+    addUnsigned(0, "00");
+    addUnsigned(1, "01");
+    addUnsigned(23, "17");
+    addUnsigned(24, "1818");
+    addUnsigned(255, "18ff");
+    addUnsigned(256, "190100");
+    addUnsigned(65535, "19ffff");
+    addUnsigned(65536, "1a00010000");
+    addUnsigned(4294967295ULL, "1affffffff");
+    addUnsigned(4294967296ULL, "1b0000000100000000");
+    addUnsigned(18446744073709551615ULL, "1bffffffffffffffff");
+
+    addInt(0, "00");
+    addInt(100, "1864");
+    addInt(-1, "20");
+    addInt(-10, "29");
+    addInt(-24, "37");
+    addInt(-25, "3818");
+    addInt(-100, "3863");
+    addInt(-256, "38ff");
+    addInt(-257, "390100");
+    addInt(-65536, "39ffff");
+    addInt(-65537, "3a00010000");
+    addInt(-4294967296LL, "3affffffff");
+    addInt(-4294967297LL, "3b0000000100000000");
+    addInt(std::numeric_limits<int64_t>::max(), "1b7fffffffffffffff");
+    addInt(std::numeric_limits<int64_t>::min(), "3b7fffffffffffffff");
+
+    // values that fit into a float are written with single precision
+    addDouble("1.5", 1.5, "fa3fc00000", "1.5", JsonBaseReader::JSON_TYPE_FLOAT);
+    addDouble("100000", 100000.0, "fa47c35000", "100000", JsonBaseReader::JSON_TYPE_INT);
+    addDouble("-0", -0.0, "fa80000000", "-0", JsonBaseReader::JSON_TYPE_INT);
+    addDouble("FLT_MAX", FLT_MAX, "fa7f7fffff", "3.4028234663852886e+38", JsonBaseReader::JSON_TYPE_NUMBER);
+    addDouble("0.1", 0.1, "fb3fb999999999999a", "0.1", JsonBaseReader::JSON_TYPE_FLOAT);
+    addDouble("-4.1", -4.1, "fbc010666666666666", "-4.1", JsonBaseReader::JSON_TYPE_FLOAT);
+    // outside the range of float
+    addDouble("1e39", 1e39, "fb48078287f49c4a1d", "1e+39", JsonBaseReader::JSON_TYPE_NUMBER);
+    addDouble("-1e39", -1e39, "fbc8078287f49c4a1d", "-1e+39", JsonBaseReader::JSON_TYPE_NUMBER);
+    addDouble("1e300", 1e300, "fb7e37e43c8800759c", "1e+300", JsonBaseReader::JSON_TYPE_NUMBER);
+    addDouble("DBL_MAX", DBL_MAX, "fb7fefffffffffffff", "1.7976931348623157e+308", JsonBaseReader::JSON_TYPE_NUMBER);
+    // not supported by JSON, read as null
+    addDouble("NaN", NAN, "fa7fc00000", "null", JsonBaseReader::JSON_TYPE_NULL);
+    addDouble("Infinity", INFINITY, "fa7f800000", "null", JsonBaseReader::JSON_TYPE_NULL);
+    addDouble("-Infinity", -INFINITY, "faff800000", "null", JsonBaseReader::JSON_TYPE_NULL);
+
+    addString(0, "60");
+    addString(1, "61");
+    addString(23, "77");
+    addString(24, "7818");
+    addString(255, "78ff");
+    addString(256, "790100");
+    addString(65535, "79ffff");
+    addString(65536, "7a00010000");
+
+    vectors.push_back({ "false", [](Print &output) { return JsonCbor::writeBool(output, false); }, "f4", "false", JsonBaseReader::JSON_TYPE_BOOLEAN });
+    vectors.push_back({ "true", [](Print &output) { return JsonCbor::writeBool(output, true); }, "f5", "true", JsonBaseReader::JSON_TYPE_BOOLEAN });
+    vectors.push_back({ "null", [](Print &output) { return JsonCbor::writeNull(output); }, "f6", "null", JsonBaseReader::JSON_TYPE_NULL });
+    vectors.push_back({ "number 42", [](Print &output) { return JsonCbor::writeNumber(output, "42"); }, "182a", "42", JsonBaseReader::JSON_TYPE_INT });
+    vectors.push_back({ "number -42", [](Print &output) { return JsonCbor::writeNumber(output, "-42"); }, "3829", "-42", JsonBaseReader::JSON_TYPE_INT });
+    vectors.push_back({ "number 2.5", [](Print &output) { return JsonCbor::writeNumber(output, "2.5"); }, "fa40200000", "2.5", JsonBaseReader::JSON_TYPE_FLOAT });
+    vectors.push_back({ "number 1e400", [](Print &output) { return JsonCbor::writeNumber(output, "1e400"); }, "fa7f800000", "null", JsonBaseReader::JSON_TYPE_NULL });
+    vectors.push_back({ "number invalid", [](Print &output) { return JsonCbor::writeNumber(output, "1.2.3"); }, "f6", "null", JsonBaseReader::JSON_TYPE_NULL });
+
+    return vectors;
+}
+
+static void testEncoder(const std::vector<Vector> &vectors)
+{
+    uint32_t errors = 0;
+    for(const auto &vector: vectors) {
+        PrintString output;
+        auto written = vector.write(output);
+        auto hex = toHex(output);
+        if (hex != vector.expected || written != output.length()) {
+            printf("{\"test\":\"encoder\",\"vector\":\"%s\",\"expected\":\"%.64s\",\"encoded\":\"%.64s\",\"written\":%u}\n", vector.name.c_str(), vector.expected.c_str(), hex.c_str(), static_cast<unsigned>(written));
+            errors++;
+        }
+    }
+    printf("{\"test\":\"encoder\",\"vectors\":%u,\"errors\":%u,\"result\":\"%s\"}\n", static_cast<unsigned>(vectors.size()), errors, result(errors == 0));
+}
+
+// key, value, type, level and index of each element
+static String readEvents(const String &data, JsonBaseReader::FormatType format, bool &success)
+{
+    HeapStream stream(data);
+    PrintString events;
+    JsonCallbackReader reader(stream, [&events](const String &key, const String &value, size_t partialLength, JsonBaseReader &json) {
+        events.printf_P(PSTR("%s=%s type=%s level=%d index=%d\n"), json.getPath().c_str(), value.c_str(), (const char *)json.jsonType2String(json.getType()), static_cast<int>(json.getLevel()), static_cast<int>(json.getIndex()));
+        return true;
+    });
+    reader.setFormat(format);
+    success = reader.parse();
+    return events;
+}
+
+static void testDecoder(const std::vector<Vector> &vectors)
+{
+    uint32_t errors = 0;
+    for(const auto &vector: vectors) {
+        // the items are read as single element of an array
+        PrintString output;
+        JsonCbor::writeArray(output, 1);
+        vector.write(output);
+
+        String value;
+        JsonBaseReader::JsonType_t type = JsonBaseReader::JSON_TYPE_INVALID;
+        uint32_t count = 0;
+        HeapStream stream(output);
+        JsonCallbackReader reader(stream, [&](const String &key, const String &_value, size_t partialLength, JsonBaseReader &json) {
+            value = _value;
+            type = json.getType();
+            count++;
+            return true;
+        });
+        reader.setFormat(JsonBaseReader::FormatType::CBOR);
+        if (!reader.parse() || count != 1 || value != vector.value || type != vector.type) {
+            printf("{\"test\":\"decoder\",\"vector\":\"%s\",\"count\":%u,\"expected\":\"%.64s\",\"decoded\":\"%.64s\",\"type\":%d}\n", vector.name.c_str(), count, vector.value.c_str(), value.c_str(), type);
+            errors++;
+        }
+    }
+    printf("{\"test\":\"decoder\",\"vectors\":%u,\"errors\":%u,\"result\":\"%s\"}\n", static_cast<unsigned>(vectors.size()), errors, result(errors == 0));
+}
+
+static void testDocuments()
+{
+    struct {
+        const char *json;
+        const char *expected;   // hex or nullptr
+    } documents[] = {
+        // RFC 8949 appendix A
+        { "{\"a\":1,\"b\":[2,3]}", "a26161016162820203" },
+        { "[\"a\",{\"b\":\"c\"}]", "826161a161626163" },
+        { "[1,[2,3],[4,5]]", "8301820203820405" },
+        // empty and nested containers
+        { "{\"a\":{},\"b\":[],\"c\":[[],[{}]]}", "a36161a06162806163828081a0" },
+        { "{\"int\":-25,\"u32\":123456,\"neg\":-1.25,\"t\":true,\"f\":false,\"n\":null,\"s\":\"str\"}", "a7" "63696e743818" "637533321a0001e240" "636e6567fabfa00000" "6174f5" "6166f4" "616ef6" "6173" "63737472" },
+        { "{\"l1\":{\"l2\":{\"l3\":{\"l4\":[1,{\"l5\":[true,\"x\"]}]}}},\"after\":0}", nullptr },
+    };
+
+    uint32_t errors = 0;
+    for(const auto &document: documents) {
+        HeapStream stream(document.json);
+        JsonConverter converter(stream);
+        if (!converter.parse()) {
+            printf("{\"test\":\"documents\",\"json\":\"%s\",\"error\":\"parse\"}\n", document.json);
+            errors++;
+            continue;
+        }
+        auto root = converter.getRoot();
+        PrintString cbor;
+        auto written = root->printCborTo(cbor);
+        PrintString json;
+        root->printTo(json);
+        delete root;
+
+        auto hex = toHex(cbor);
+        if (written != cbor.length() || (document.expected && hex != document.expected)) {
+            printf("{\"test\":\"documents\",\"json\":\"%s\",\"encoded\":\"%s\"}\n", json.c_str(), hex.c_str());
+            errors++;
+        }
+
+        bool jsonSuccess, cborSuccess;
+        auto jsonEvents = readEvents(json, JsonBaseReader::FormatType::JSON, jsonSuccess);
+        auto cborEvents = readEvents(cbor, JsonBaseReader::FormatType::CBOR, cborSuccess);
+        if (!jsonSuccess || !cborSuccess || jsonEvents != cborEvents) {
+            printf("{\"test\":\"documents\",\"json\":\"%s\",\"error\":\"events\"}\n%s---\n%s", json.c_str(), jsonEvents.c_str(), cborEvents.c_str());
+            errors++;
+        }
+    }
+    printf("{\"test\":\"documents\",\"documents\":%u,\"errors\":%u,\"result\":\"%s\"}\n", static_cast<unsigned>(sizeof(documents) / sizeof(documents[0])), errors, result(errors == 0));
+}
+
+// decoded value of a single number
+static String readNumber(const String &cbor)
+{
+    PrintString output;
+    JsonCbor::writeArray(output, 1);
+    output.write(reinterpret_cast<const uint8_t *>(cbor.c_str()), cbor.length());
+    String value;
+    HeapStream stream(output);
+    JsonCallbackReader reader(stream, [&](const String &key, const String &_value, size_t partialLength, JsonBaseReader &json) {
+        value = _value;
+        return true;
+    });
+    reader.setFormat(JsonBaseReader::FormatType::CBOR);
+    if (!reader.parse()) {
+        return String();
+    }
+    return value;
+}
+
+static void testRoundTrip(uint32_t count)
+{
+    std::vector<String> numbers = {
+        "0.1", "3.14159274", "3.14159265358979", "16777217", "1.0000001", "0.30000000000000004", "123456.789",
+        "1e-7", "2.5e-300", "3.4028235e38", "1.7976931348623157e308"
+    };
+    std::minstd_rand rnd(1);
+    char buf[32];
+    for(uint32_t i = 0; i < count; i++) {
+        uint64_t bits = (static_cast<uint64_t>(rnd()) << 33) ^ (static_cast<uint64_t>(rnd()) << 2) ^ rnd();
+        if (i % 2) {
+            uint32_t fBits = static_cast<uint32_t>(bits);
+            float fValue;
+            memcpy(&fValue, &fBits, sizeof(fValue));
+            if (!isfinite(fValue)) {
+                continue;
+            }
+            // exact value of the float, it is encoded with single precision
+            snprintf(buf, sizeof(buf), "%.17g", static_cast<double>(fValue));
+        }
+        else {
+            double value;
+            memcpy(&value, &bits, sizeof(value));
+            if (!isfinite(value)) {
+                continue;
+            }
+            snprintf(buf, sizeof(buf), "%.17g", value);
+        }
+        numbers.emplace_back(buf);
+    }
+
+    uint32_t errors = 0;
+    for(const auto &number: numbers) {
+        PrintString cbor;
+        JsonCbor::writeNumber(cbor, number.c_str());
+        auto value = readNumber(cbor);
+        // integers stored as double are decoded without fraction and encoded as integer
+        PrintString cbor2;
+        JsonCbor::writeNumber(cbor2, value.c_str());
+        auto value2 = readNumber(cbor2);
+        if (value.length() == 0 || strtod(value.c_str(), nullptr) != strtod(number.c_str(), nullptr) || value != value2) {
+            if (errors++ < 10) {
+                printf("{\"test\":\"round_trip\",\"number\":\"%s\",\"decoded\":\"%s\",\"encoded\":\"%s\"}\n", number.c_str(), value.c_str(), toHex(cbor).c_str());
+            }
+        }
+    }
+    printf("{\"test\":\"round_trip\",\"numbers\":%u,\"errors\":%u,\"result\":\"%s\"}\n", static_cast<unsigned>(numbers.size()), errors, result(errors == 0));
+}
+
+int main(int argc, const char *argv[])
+{
+    auto vectors = createVectors();
+    testEncoder(vectors);
+    testDecoder(vectors);
+    testDocuments();
+    testRoundTrip(20000);
+    return HostTest::exitCode();
+}
@@ -0,0 +1,178 @@
+/**
+ * Author: sascha_lammers@gmx.de
+ */
+
+// Host test for JsonFlatMap and JsonMapReader
+//
+// - map: entries added with addString(), internString() and add() are found by their path with binary search and the
+//   hash index, iterated in sorted order and duplicates keep the last value
+// - length_limit: strings with kMaxLength characters are stored, longer strings are rejected and not added
+// - reader: JsonMapReader results compared to the paths and values of the JSON document. a value that exceeds the
+//   maximum length is reported as error and skipped, the other values are kept
+//
+// prints one JSON object per line and returns 0 if all checks passed
+//
+// {"test":"map","hash_index":false,"entries":5,"errors":0,"result":"OK"}
+// {"test":"map","hash_index":true,"entries":5,"errors":0,"result":"OK"}
+// {"test":"length_limit","errors":0,"result":"OK"}
+// {"test":"reader","entries":7,"errors":0,"result":"OK"}
+//
+// usage: json_flat_map
+
+#include <Arduino_compat.h>
+#include <HeapStream.h>
+#include <PrintString.h>
+#include <stdio.h>
+#include <host_test.h>
+#include "KFCJson.h"
+#include "JsonFlatMap.h"
+#include "JsonMapReader.h"
+
+using namespace KFCJson;
+using HostTest::result;
+
+static uint32_t errors;
+
+static void check(const char *test, bool success, const String &message)
+{
+    if (!success) {
+        printf("{\"test\":\"%s\",\"error\":\"%s\"}\n", test, message.c_str());
+        errors++;
+    }
+}
+
+static void checkValue(const char *test, JsonFlatMap &map, const char *path, const char *value, JsonBaseReader::JsonType_t type)
+{
+    auto entry = map.find(path);
+    if (!entry) {
+        check(test, false, String("path not found: ") + path);
+        return;
+    }
+    check(test, map.getKey(*entry) == path, String("key mismatch: ") + path + "!=" + map.getKey(*entry));
+    check(test, map.getValue(*entry) == value, String("value mismatch: ") + path + "=" + map.getValue(*entry));
+    check(test, entry->type == type, String("type mismatch: ") + path);
+}
+
+static void testMap(bool hashIndex)
+{
+    errors = 0;
+    JsonFlatMap map;
+    map.setHashIndex(hashIndex);
+
+    auto root = map.addString("", 0);
+    auto object = map.addString("object", 6);
+    // added in random order, the suffixes are shared between objects
+    check("map", map.add(object, map.internString(".b", 2), JsonBaseReader::JSON_TYPE_INT, "2"), "add object.b");
+    check("map", map.add(root, map.internString("a", 1), JsonBaseReader::JSON_TYPE_STRING, "first"), "add a");
+    check("map", map.add(object, map.internString(".a", 2), JsonBaseReader::JSON_TYPE_BOOLEAN, "true"), "add object.a");
+    check("map", map.add(root, map.internString("array[1]", 8), JsonBaseReader::JSON_TYPE_NULL, "null"), "add array[1]");
+    check("map", map.add(root, map.internString("array[0]", 8), JsonBaseReader::JSON_TYPE_FLOAT, "1.5"), "add array[0]");
+    // duplicate, the last value is kept
+    check("map", map.add(root, map.internString("a", 1), JsonBaseReader::JSON_TYPE_STRING, "last"), "add a again");
+    // interned strings are stored once
+    auto suffix1 = map.internString(".b", 2);
+    auto suffix2 = map.internString(".b", 2);
+    check("map", suffix1.offset == suffix2.offset && suffix1.length == 2, "interned string added twice");
+    // invalid prefix or suffix
+    check("map", !map.add(JsonFlatMap::String_t(), suffix1, JsonBaseReader::JSON_TYPE_NULL, "null"), "invalid prefix added");
+    check("map", !map.add(root, JsonFlatMap::String_t(), JsonBaseReader::JSON_TYPE_NULL, "null"), "invalid suffix added");
+
+    checkValue("map", map, "a", "last", JsonBaseReader::JSON_TYPE_STRING);
+    checkValue("map", map, "array[0]", "1.5", JsonBaseReader::JSON_TYPE_FLOAT);
+    checkValue("map", map, "array[1]", "null", JsonBaseReader::JSON_TYPE_NULL);
+    checkValue("map", map, "object.a", "true", JsonBaseReader::JSON_TYPE_BOOLEAN);
+    checkValue("map", map, "object.b", "2", JsonBaseReader::JSON_TYPE_INT);
+    check("map", map.find("object") == nullptr, "prefix found");
+    check("map", map.find("object.") == nullptr, "partial path found");
+    check("map", map.find("object.bb") == nullptr, "unknown path found");
+    check("map", map.find("") == nullptr, "empty path found");
+    check("map", map.size() == 5, String("size=") + String(static_cast<unsigned>(map.size())));
+
+    // sorted by path
+    const char *expected[] = { "a", "array[0]", "array[1]", "object.a", "object.b" };
+    size_t index = 0;
+    for(const auto &entry: map) {
+        auto key = map.getKey(entry);
+        check("map", index < 5 && key == expected[index], String("iterator: ") + key);
+        index++;
+    }
+    check("map", index == 5, "iterator count");
+
+    // entries added after finalize() are sorted in again
+    check("map", map.add(root, map.internString("0", 1), JsonBaseReader::JSON_TYPE_INT, "0"), "add 0");
+    checkValue("map", map, "0", "0", JsonBaseReader::JSON_TYPE_INT);
+    check("map", map.getKey(*map.begin()) == "0", "first entry after adding");
+    checkValue("map", map, "object.b", "2", JsonBaseReader::JSON_TYPE_INT);
+
+    map.clear();
+    check("map", map.size() == 0 && map.find("a") == nullptr, "clear");
+
+    printf("{\"test\":\"map\",\"hash_index\":%s,\"entries\":5,\"errors\":%u,\"result\":\"%s\"}\n", hashIndex ? "true" : "false", errors, result(errors == 0));
+}
+
+static void testLengthLimit()
+{
+    errors = 0;
+    JsonFlatMap map;
+    std::string maxStr(JsonFlatMap::kMaxLength, 'x');
+    std::string longStr(JsonFlatMap::kMaxLength + 1, 'y');
+
+    auto root = map.addString("", 0);
+    auto str = map.addString(maxStr.c_str(), maxStr.length());
+    check("length_limit", str.isValid() && str.length == JsonFlatMap::kMaxLength, "kMaxLength rejected");
+    str = map.addString(longStr.c_str(), longStr.length());
+    check("length_limit", !str.isValid(), "kMaxLength + 1 added");
+    str = map.internString(longStr.c_str(), longStr.length());
+    check("length_limit", !str.isValid(), "kMaxLength + 1 interned");
+
+    check("length_limit", map.add(root, map.internString("max", 3), JsonBaseReader::JSON_TYPE_STRING, String(maxStr)), "value with kMaxLength rejected");
+    check("length_limit", !map.add(root, map.internString("long", 4), JsonBaseReader::JSON_TYPE_STRING, String(longStr)), "value with kMaxLength + 1 added");
+    check("length_limit", map.size() == 1, "rejected value added");
+    check("length_limit", map.find("long") == nullptr, "rejected value found");
+
+    auto entry = map.find("max");
+    check("length_limit", entry && map.getValue(*entry) == String(maxStr), "value with kMaxLength truncated");
+
+    printf("{\"test\":\"length_limit\",\"errors\":%u,\"result\":\"%s\"}\n", errors, result(errors == 0));
+}
+
+static void testReader()
+{
+    errors = 0;
+    std::string longStr(JsonFlatMap::kMaxLength + 1, 'y');
+    String json = "{\"name\":\"test\",\"long\":\"";
+    json += String(longStr);
+    json += "\",\"values\":[1,2.5,null],\"object\":{\"enabled\":true,\"nested\":{\"key\":\"value\"}},\"name\":\"last\",\"after\":false}";
+
+    HeapStream stream(json);
+    JsonMapReader reader(stream);
+    reader.parse();
+    check("reader", reader.getLastError().type == JsonBaseReader::JSON_ERROR_INVALID_VALUE, String("error: ") + reader.getLastErrorMessage());
+
+    auto &map = reader.getMap();
+    checkValue("reader", map, "name", "last", JsonBaseReader::JSON_TYPE_STRING);
+    checkValue("reader", map, "values[0]", "1", JsonBaseReader::JSON_TYPE_INT);
+    checkValue("reader", map, "values[1]", "2.5", JsonBaseReader::JSON_TYPE_FLOAT);
+    checkValue("reader", map, "values[2]", "null", JsonBaseReader::JSON_TYPE_NULL);
+    checkValue("reader", map, "object.enabled", "true", JsonBaseReader::JSON_TYPE_BOOLEAN);
+    checkValue("reader", map, "object.nested.key", "value", JsonBaseReader::JSON_TYPE_STRING);
+    checkValue("reader", map, "after", "false", JsonBaseReader::JSON_TYPE_BOOLEAN);
+    check("reader", map.find("long") == nullptr, "value exceeding the maximum length added");
+    check("reader", map.size() == 7, String("size=") + String(static_cast<unsigned>(map.size())));
+    check("reader", reader.get("object.nested.key").getValue() == "value", "get()");
+
+    PrintString dump;
+    reader.dump(dump);
+    check("reader", dump.startsWith("after=false (boolean)\n"), String("dump: ") + dump);
+
+    printf("{\"test\":\"reader\",\"entries\":%u,\"errors\":%u,\"result\":\"%s\"}\n", static_cast<unsigned>(map.size()), errors, result(errors == 0));
+}
+
+int main(int argc, const char *argv[])
+{
+    testMap(false);
+    testMap(true);
+    testLengthLimit();
+    testReader();
+    return HostTest::exitCode();
+}
@@ -0,0 +1,115 @@
+/**
+ * Author: sascha_lammers@gmx.de
+ */
+
+// Host test for JsonVariableReader::Reader
+//
+// - reuse: one reader parses documents with a different number of elements. each parse must return only the results
+//   of its own document and the results are stored in the slabs allocated by the previous parses
+//
+// prints one JSON object per line and returns 0 if all checks passed
+//
+// {"test":"reuse","parses":4,"errors":0,"result":"OK"}
+//
+// usage: json_variable_reader
+
+#include <Arduino_compat.h>
+#include <HeapStream.h>
+#include <PrintString.h>
+#include <stdio.h>
+#include <host_test.h>
+#include "KFCJson.h"
+#include "JsonVariableReader.h"
+
+using namespace KFCJson;
+using HostTest::result;
+
+class Hourly : public JsonVariableReader::Result {
+public:
+    Hourly() : _dt(0), _humidity(0) {
+    }
+
+    virtual bool empty() const {
+        return _dt == 0;
+    }
+
+    static void apply(JsonVariableReader::ElementGroup &group) {
+        group.initResultType<Hourly>();
+        group.add(F("dt"), [](JsonVariableReader::Result &result, JsonVariableReader::Reader &reader) {
+            reinterpret_cast<Hourly &>(result)._dt = reader.getIntValue();
+            return true;
+        });
+        group.add(F("humidity"), [](JsonVariableReader::Result &result, JsonVariableReader::Reader &reader) {
+            reinterpret_cast<Hourly &>(result)._humidity = reader.getIntValue();
+            return true;
+        });
+    }
+
+    uint32_t _dt;
+    uint8_t _humidity;
+};
+
+// document with count elements starting at dt=first
+static String createDocument(uint32_t first, uint32_t count)
+{
+    PrintString json;
+    json.print(F("{\"hourly\":["));
+    for(uint32_t i = 0; i < count; i++) {
+        if (i) {
+            json.print(',');
+        }
+        json.printf_P(PSTR("{\"dt\":%u,\"humidity\":%u}"), first + i, (first + i) % 100);
+    }
+    json.print(F("]}"));
+    return json;
+}
+
+static void testReuse()
+{
+    JsonVariableReader::Reader reader;
+    auto groups = reader.getElementGroups();
+    groups->emplace_back(F("hourly[]"));
+    Hourly::apply(groups->back());
+
+    // more than one slab, less and an empty document
+    const uint32_t counts[] = { 20, 3, 0, 9 };
+    uint32_t errors = 0;
+    const Hourly *firstResult = nullptr;
+    for(uint32_t n = 0; n < sizeof(counts) / sizeof(counts[0]); n++) {
+        auto first = (n + 1) * 1000;
+        auto json = createDocument(first, counts[n]);
+        HeapStream stream(json);
+        reader.setStream(&stream);
+        if (!reader.parse()) {
+            errors++;
+            continue;
+        }
+        auto results = groups->back().getResults<Hourly>();
+        if (results.size() != counts[n]) {
+            printf("{\"test\":\"reuse\",\"parse\":%u,\"expected\":%u,\"results\":%u}\n", n, counts[n], static_cast<unsigned>(results.size()));
+            errors++;
+            continue;
+        }
+        for(uint32_t i = 0; i < counts[n]; i++) {
+            if (results[i]._dt != first + i || results[i]._humidity != (first + i) % 100) {
+                errors++;
+            }
+        }
+        // the first slab is kept
+        if (counts[n]) {
+            if (!firstResult) {
+                firstResult = &results[0];
+            }
+            else if (firstResult != &results[0]) {
+                errors++;
+            }
+        }
+    }
+    printf("{\"test\":\"reuse\",\"parses\":%u,\"errors\":%u,\"result\":\"%s\"}\n", static_cast<unsigned>(sizeof(counts) / sizeof(counts[0])), errors, result(errors == 0));
+}
+
+int main(int argc, const char *argv[])
+{
+    testReuse();
+    return HostTest::exitCode();
+}
@@ -12,5 +12,8 @@
 #include "./monitor.h"
 #include "./push_button.h"
 #include "./rotary_encoder.h"
+#if PIN_MONITOR_GESTURES
+#    include "./gesture.h"
+#endif
 
 #endif
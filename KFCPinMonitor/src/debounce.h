@@ -135,6 +135,95 @@ namespace PinMonitor {
 
     // class Debounce
 
+    // debounces all pins of a GPIO register at once. the register is sampled in fixed intervals and each pin has a 2 bit
+    // counter, which is stored in two words with one bit per pin (vertical counter). the stable state of a pin changes
+    // after kSamples consecutive samples that differ from it, a sample that matches the stable state resets the counter
+    //
+    // a sample requires a few bitwise operations independent of the number of pins
+    template<typename _MaskType>
+    class VerticalCounterDebounce {
+    public:
+        using MaskType = _MaskType;
+
+        static constexpr uint8_t kSamples = 4;
+
+        struct Result {
+            MaskType started;       // first sample that differs from the stable state
+            MaskType bounced;       // the counter was reset before the new state has been reached
+            MaskType rising;        // stable state changed to high
+            MaskType falling;       // stable state changed to low
+
+            MaskType changed() const {
+                return started | bounced | rising | falling;
+            }
+
+            // event of a single pin, each pin has one event per sample at most
+            // stable is the debounced state after the sample
+            StateType getState(MaskType mask, MaskType stable) const {
+                if (rising & mask) {
+                    return StateType::IS_HIGH;
+                }
+                if (falling & mask) {
+                    return StateType::IS_LOW;
+                }
+                if (started & mask) {
+                    return (stable & mask) ? StateType::IS_FALLING : StateType::IS_RISING;
+                }
+                if (bounced & mask) {
+                    return (stable & mask) ? StateType::FALLING_BOUNCED : StateType::RISING_BOUNCED;
+                }
+                return StateType::NONE;
+            }
+        };
+
+        VerticalCounterDebounce() :
+            _state(0),
+            _count0(0),
+            _count1(0)
+        {
+        }
+
+        // set the stable state of the pins in mask and reset their counters
+        void reset(MaskType mask, MaskType values) {
+            _state = (_state & ~mask) | (values & mask);
+            _count0 &= ~mask;
+            _count1 &= ~mask;
+        }
+
+        inline __attribute__((__always_inline__))
+        Result sample(MaskType values) {
+            Result result;
+            MaskType delta = values ^ _state;
+            MaskType counting = _count0 | _count1;
+            result.started = delta & ~counting;
+            result.bounced = counting & ~delta;
+            // increment the counters of all pins that differ and reset the others
+            _count1 = (_count1 ^ _count0) & delta;
+            _count0 = ~_count0 & delta;
+            // counters that wrapped around to 0 have reached kSamples
+            MaskType toggle = delta & ~(_count0 | _count1);
+            _state ^= toggle;
+            result.rising = toggle & _state;
+            result.falling = toggle & ~_state;
+            return result;
+        }
+
+        // debounced state
+        MaskType getState() const {
+            return _state;
+        }
+
+        // pins that have a sample that differs from the stable state
+        MaskType getCounting() const {
+            return _count0 | _count1;
+        }
+
+    private:
+        MaskType _state;
+        MaskType _count0;
+        MaskType _count1;
+    };
+
 }
 
 #include <debug_helper_disable.h>
@@ -0,0 +1,245 @@
+/**
+ * Author: sascha_lammers@gmx.de
+ */
+
+#if PIN_MONITOR && PIN_MONITOR_GESTURES
+
+#include <Arduino_compat.h>
+#include "pin_monitor.h"
+
+#if DEBUG_PIN_MONITOR
+#    include <debug_helper_enable.h>
+#else
+#    include <debug_helper_disable.h>
+#endif
+
+using namespace PinMonitor;
+
+GestureEngine::GestureEngine() :
+    _timerDeadline(0),
+    _timerRunning(false),
+    _insideTimer(false),
+    _pinsAttached(false)
+{
+}
+
+GestureEngine::~GestureEngine()
+{
+    detachPins();
+}
+
+void GestureEngine::addClicks(uint8_t id, uint8_t pin, uint8_t clicks, Callback callback, uint16_t maxPressTime, uint16_t maxGapTime)
+{
+    if (clicks == 0 || clicks > kMaxClicks) {
+        __DBG_panic("clicks=%u max=%u", clicks, kMaxClicks);
+    }
+    auto &gesture = _add(id, callback, pin);
+    // 2 states per click, pressed and released
+    for(uint8_t i = 0; i < clicks; i++) {
+        uint8_t state = i * 2;
+        _addTransition(gesture, GestureTransition(state, GestureInputType::DOWN, 0, state + 1, maxPressTime));
+        _addTransition(gesture, GestureTransition(state + 1, GestureInputType::UP, 0, state + 2, maxGapTime));
+    }
+    uint8_t last = clicks * 2;
+    _addTransition(gesture, GestureTransition(last, GestureInputType::TIMEOUT, 0, 0, 0, true));
+    // ignore further clicks until the gap timeout has expired
+    _addTransition(gesture, GestureTransition(last, GestureInputType::DOWN, 0, last + 1));
+    _addTransition(gesture, GestureTransition(last + 1, GestureInputType::UP, 0, last + 2, maxGapTime));
+    _addTransition(gesture, GestureTransition(last + 2, GestureInputType::DOWN, 0, last + 1));
+    _addTransition(gesture, GestureTransition(last + 2, GestureInputType::TIMEOUT, 0, 0));
+}
+
+void GestureEngine::addHold(uint8_t id, uint8_t pin, uint16_t holdTime, Callback callback)
+{
+    auto &gesture = _add(id, callback, pin);
+    _addTransition(gesture, GestureTransition(0, GestureInputType::DOWN, 0, 1, holdTime));
+    // wait for the release in state 2
+    _addTransition(gesture, GestureTransition(1, GestureInputType::TIMEOUT, 0, 2, 0, true));
+}
+
+void GestureEngine::addChord(uint8_t id, uint8_t pin1, uint8_t pin2, Callback callback, uint16_t window)
+{
+    auto &gesture = _add(id, callback, pin1, pin2);
+    _addTransition(gesture, GestureTransition(0, GestureInputType::DOWN, 0, 1, window));
+    _addTransition(gesture, GestureTransition(0, GestureInputType::DOWN, 1, 2, window));
+    // wait for the release in state 3
+    _addTransition(gesture, GestureTransition(1, GestureInputType::DOWN, 1, 3, 0, true));
+    _addTransition(gesture, GestureTransition(2, GestureInputType::DOWN, 0, 3, 0, true));
+}
+
+void GestureEngine::addPressAndRotate(uint8_t id, uint8_t pin, uint8_t encoderId, Callback callback)
+{
+    auto &gesture = _add(id, callback, pin, encoderId, 0b10);
+    _addTransition(gesture, GestureTransition(0, GestureInputType::DOWN, 0, 1));
+    _addTransition(gesture, GestureTransition(1, GestureInputType::ROTATE, 1, 1, 0, true));
+}
+
+void GestureEngine::clear()
+{
+    _gestures.clear();
+    _transitions.clear();
+    _transitions.shrink_to_fit();
+    _updateTimer(millis());
+}
+
+void GestureEngine::attachPins(ActiveStateType activeState)
+{
+    detachPins();
+    GPIOMaskType attached = 0;
+    for(const auto &gesture: _gestures) {
+        for(uint8_t i = 0; i < 2; i++) {
+            auto pin = gesture.sources[i];
+            if (pin == kNoSource || (gesture.encoderSources & _BV(i))) {
+                continue;
+            }
+            // GPIO expanders and other pins above NUM_DIGITAL_PINS are not tracked and checked with getPins()
+            if (pin < NUM_DIGITAL_PINS) {
+                if (attached & GPIO_PIN_TO_MASK(pin)) {
+                    continue;
+                }
+                attached |= GPIO_PIN_TO_MASK(pin);
+            }
+            else if (pinMonitor.getPin(pin)) {
+                continue;
+            }
+            pinMonitor.attach<GestureButton>(pin, this, activeState);
+        }
+    }
+    _pinsAttached = true;
+}
+
+void GestureEngine::detachPins()
+{
+    if (_pinsAttached) {
+        pinMonitor.detach(static_cast<const void *>(this));
+        _pinsAttached = false;
+    }
+}
+
+void GestureEngine::buttonEvent(uint8_t pin, bool down, uint32_t now)
+{
+    _input(down ? GestureInputType::DOWN : GestureInputType::UP, pin, false, 0, now);
+}
+
+GestureEngine::Gesture &GestureEngine::_add(uint8_t id, Callback callback, uint8_t source1, uint8_t source2, uint8_t encoderSources)
+{
+    if (_transitions.size() >= std::numeric_limits<uint16_t>::max()) {
+        __DBG_panic("too many transitions");
+    }
+    _gestures.emplace_back(id, callback, static_cast<uint16_t>(_transitions.size()), source1, source2, encoderSources);
+    return _gestures.back();
+}
+
+void GestureEngine::_addTransition(Gesture &gesture, GestureTransition transition)
+{
+    // the transitions of a gesture must be added before the next gesture
+    if (gesture.first + gesture.count != _transitions.size()) {
+        __DBG_panic("gesture id=%u is not the last one", gesture.id);
+    }
+    _transitions.push_back(transition);
+    gesture.count++;
+}
+
+void GestureEngine::_input(GestureInputType input, uint8_t source, bool isEncoder, int16_t value, uint32_t now)
+{
+    for(auto &gesture: _gestures) {
+        uint8_t sourceIndex;
+        if (gesture.sources[0] == source && ((gesture.encoderSources & 0b01) != 0) == isEncoder) {
+            sourceIndex = 0;
+        }
+        else if (gesture.sources[1] == source && ((gesture.encoderSources & 0b10) != 0) == isEncoder) {
+            sourceIndex = 1;
+        }
+        else {
+            continue;
+        }
+        if (!_evaluate(gesture, input, sourceIndex, value, now) && gesture.state != 0) {
+            // start over, the input might begin a new gesture
+            __LDBG_printf("gesture id=%u reset state=%u input=%u", gesture.id, gesture.state, input);
+            gesture.state = 0;
+            gesture.timeoutRunning = false;
+            _evaluate(gesture, input, sourceIndex, value, now);
+        }
+    }
+    _updateTimer(now);
+}
+
+bool GestureEngine::_evaluate(Gesture &gesture, GestureInputType input, uint8_t sourceIndex, int16_t value, uint32_t now)
+{
+    auto iterator = _transitions.begin() + gesture.first;
+    auto end = iterator + gesture.count;
+    for(; iterator != end; ++iterator) {
+        const auto &transition = *iterator;
+        if (transition.from == gesture.state && transition.input == input && transition.source == sourceIndex) {
+            __LDBG_printf("gesture id=%u state=%u -> %u fire=%u timeout=%u", gesture.id, gesture.state, transition.to, transition.fire, transition.timeout);
+            gesture.state = transition.to;
+            gesture.timeoutRunning = transition.timeout != 0;
+            gesture.deadline = now + transition.timeout;
+            if (transition.fire) {
+                gesture.callback(gesture.id, value, now);
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+void GestureEngine::_timeout()
+{
+    _timerRunning = false;
+    _insideTimer = true;
+    auto now = millis();
+    for(auto &gesture: _gestures) {
+        if (gesture.timeoutRunning && static_cast<int32_t>(now - gesture.deadline) >= 0) {
+            gesture.timeoutRunning = false;
+            if (!_evaluate(gesture, GestureInputType::TIMEOUT, 0, 0, now)) {
+                gesture.state = 0;
+            }
+        }
+    }
+    _updateTimer(now);
+    _insideTimer = false;
+}
+
+void GestureEngine::_updateTimer(uint32_t now)
+{
+    // find the earliest timeout
+    bool found = false;
+    uint32_t deadline = 0;
+    for(const auto &gesture: _gestures) {
+        if (gesture.timeoutRunning && (!found || static_cast<int32_t>(gesture.deadline - deadline) < 0)) {
+            deadline = gesture.deadline;
+            found = true;
+        }
+    }
+    if (!found) {
+        if (_timer) {
+            // the timer is removed after the callback has returned
+            if (_insideTimer) {
+                _timer->disarm();
+            }
+            else {
+                _timer.remove();
+            }
+        }
+        _timerRunning = false;
+        return;
+    }
+    if (_timerRunning && deadline == _timerDeadline) {
+        return;
+    }
+    _timerDeadline = deadline;
+    _timerRunning = true;
+    int32_t delay = std::max<int32_t>(Event::kMinDelay, static_cast<int32_t>(deadline - now));
+    if (_timer) {
+        _timer->rearm(Event::milliseconds(delay));
+    }
+    else {
+        // the timer is repeating and rearmed or disarmed in _timeout()
+        _Timer(_timer).add(Event::milliseconds(delay), true, [this](Event::CallbackTimerPtr) {
+            _timeout();
+        });
+    }
+}
+
+#endif
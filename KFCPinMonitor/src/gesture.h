@@ -0,0 +1,187 @@
+/**
+ * Author: sascha_lammers@gmx.de
+ */
+
+#pragma once
+
+#include <Arduino_compat.h>
+#include <stl_ext/inplace_function.h>
+#include <vector>
+
+#if DEBUG_PIN_MONITOR
+#    include <debug_helper_enable.h>
+#else
+#    include <debug_helper_disable.h>
+#endif
+
+namespace PinMonitor {
+
+    // gestures are compiled into small transition tables when they are added. all tables are stored in a single vector
+    // of 4 byte entries and evaluated from the debounced button events, the steps of rotary encoders and a timeout
+    //
+    // each gesture has a state (0 = idle) and up to 2 sources, a button or an encoder. an input of a source looks up
+    // the transition for the current state. if none exists, the gesture is reset to idle and the input is evaluated
+    // again from the idle state. a transition can fire the callback and arm a timeout for the next state. all gestures
+    // share one timer that expires at the earliest timeout
+    //
+    // the gestures are evaluated independently, a button event can advance multiple gestures
+
+    enum class GestureInputType : uint8_t {
+        DOWN = 0,
+        UP,
+        ROTATE,
+        TIMEOUT,
+    };
+
+    struct __attribute__((packed)) GestureTransition {
+        uint8_t from: 4;                // state
+        uint8_t to: 4;                  // next state
+        GestureInputType input: 2;
+        uint8_t source: 1;              // index of the source
+        uint8_t fire: 1;                // invoke the callback
+        uint8_t __reserved: 4;
+        uint16_t timeout;               // timeout of the next state in milliseconds, 0 = none
+
+        GestureTransition(uint8_t _from, GestureInputType _input, uint8_t _source, uint8_t _to, uint16_t _timeout = 0, bool _fire = false) :
+            from(_from),
+            to(_to),
+            input(_input),
+            source(_source),
+            fire(_fire),
+            __reserved(0),
+            timeout(_timeout)
+        {
+        }
+    };
+
+    static_assert(sizeof(GestureTransition) == 4, "size of GestureTransition changed");
+
+    class GestureEngine {
+    public:
+        // id is the value passed to add*()
+        // value is the number of steps for press and rotate gestures and 0 otherwise
+        // now is millis() when the gesture has been recognized
+        using Callback = stdex::inplace_function<void(uint8_t id, int16_t value, uint32_t now)>;
+
+        static constexpr uint8_t kMaxStates = 16;
+        // 2 states per click and 2 states for ignoring further clicks
+        static constexpr uint8_t kMaxClicks = (kMaxStates - 3) / 2;
+        static constexpr uint8_t kNoSource = 0xff;
+
+    public:
+        GestureEngine();
+        ~GestureEngine();
+
+        // the button is pressed and released clicks times. each press is shorter than maxPressTime and the button is
+        // pressed again within maxGapTime. the callback is invoked maxGapTime after the last release
+        void addClicks(uint8_t id, uint8_t pin, uint8_t clicks, Callback callback, uint16_t maxPressTime = 250, uint16_t maxGapTime = 300);
+        // the button is held for holdTime milliseconds. the callback is invoked while the button is still pressed
+        void addHold(uint8_t id, uint8_t pin, uint16_t holdTime, Callback callback);
+        // both buttons are pressed within window milliseconds in any order
+        void addChord(uint8_t id, uint8_t pin1, uint8_t pin2, Callback callback, uint16_t window = 100);
+        // the encoder is turned while the button is pressed. the callback is invoked for each rotation with the steps
+        // see rotate()
+        void addPressAndRotate(uint8_t id, uint8_t pin, uint8_t encoderId, Callback callback);
+
+        // remove all gestures
+        void clear();
+
+        // attach a GestureButton to the pin monitor for each pin used by the gestures, must be called before
+        // pinMonitor.begin()
+        void attachPins(ActiveStateType activeState = PIN_MONITOR_ACTIVE_STATE);
+        void detachPins();
+
+        // inputs
+        void buttonEvent(uint8_t pin, bool down, uint32_t now);
+        // steps of a rotary encoder, positive values for steps to the right. encoderId is chosen by the caller
+        // and must match the one passed to addPressAndRotate(). nowMillis is millis(), the time passed to
+        // RotaryEncoder::rotated() is in microseconds and cannot be used
+        void rotate(uint8_t encoderId, int16_t steps, uint32_t nowMillis);
+
+        size_t size() const;
+        // number of transitions of all gestures
+        size_t getTableSize() const;
+
+    private:
+        struct Gesture {
+            Callback callback;
+            uint32_t deadline;          // millis() of the timeout
+            uint16_t first;             // index of the first transition
+            uint8_t count;              // number of transitions
+            uint8_t sources[2];         // pin or encoder id
+            uint8_t encoderSources;     // bit set for each source that is an encoder
+            uint8_t id;
+            uint8_t state;
+            bool timeoutRunning;
+
+            Gesture(uint8_t _id, Callback _callback, uint16_t _first, uint8_t source1, uint8_t source2, uint8_t _encoderSources) :
+                callback(_callback),
+                deadline(0),
+                first(_first),
+                count(0),
+                sources{source1, source2},
+                encoderSources(_encoderSources),
+                id(_id),
+                state(0),
+                timeoutRunning(false)
+            {
+            }
+        };
+
+        Gesture &_add(uint8_t id, Callback callback, uint8_t source1, uint8_t source2 = kNoSource, uint8_t encoderSources = 0);
+        void _addTransition(Gesture &gesture, GestureTransition transition);
+        void _input(GestureInputType input, uint8_t source, bool isEncoder, int16_t value, uint32_t now);
+        // returns false if the gesture has no transition for the input
+        bool _evaluate(Gesture &gesture, GestureInputType input, uint8_t sourceIndex, int16_t value, uint32_t now);
+        void _timeout();
+        void _updateTimer(uint32_t now);
+
+    private:
+        std::vector<GestureTransition> _transitions;
+        std::vector<Gesture> _gestures;
+        Event::Timer _timer;
+        uint32_t _timerDeadline;    // millis() when _timer expires
+        bool _timerRunning;
+        bool _insideTimer;
+        bool _pinsAttached;
+    };
+
+    inline size_t GestureEngine::size() const
+    {
+        return _gestures.size();
+    }
+
+    inline size_t GestureEngine::getTableSize() const
+    {
+        return _transitions.size();
+    }
+
+    inline void GestureEngine::rotate(uint8_t encoderId, int16_t steps, uint32_t nowMillis)
+    {
+        if (steps) {
+            _input(GestureInputType::ROTATE, encoderId, true, steps, nowMillis);
+        }
+    }
+
+    // --------------------------------------------------------------------
+    // PinMonitor::GestureButton
+    // --------------------------------------------------------------------
+
+    // passes the debounced events of a pin to a GestureEngine
+    class GestureButton : public Pin {
+    public:
+        GestureButton(uint8_t pin, GestureEngine *engine, ActiveStateType activeState = PIN_MONITOR_ACTIVE_STATE) :
+            Pin(pin, engine, StateType::UP_DOWN, activeState)
+        {
+        }
+
+        virtual void event(StateType state, uint32_t now) override {
+            reinterpret_cast<GestureEngine *>(const_cast<void *>(getArg()))->buttonEvent(getPin(), state == StateType::DOWN, now);
+        }
+    };
+
+}
+
+#if DEBUG_PIN_MONITOR
+#    include <debug_helper_disable.h>
+#endif
@@ -7,7 +7,7 @@
 #include <Arduino_compat.h>
 #include <PrintString.h>
 #include <stl_ext/utility.h>
-#include <stl_ext/fixed_circular_buffer.h>
+#include <stl_ext/spsc_ring_buffer.h>
 #include <pin.h>
 
 #if DEBUG_PIN_MONITOR
@@ -248,7 +248,10 @@ namespace PinMonitor {
 
         #endif
 
-        using EventBuffer = stdex::fixed_circular_buffer<Event, kEventQueueSize>;
+        static_assert((kEventQueueSize & (kEventQueueSize - 1)) == 0, "PIN_MONITOR_EVENT_QUEUE_SIZE must be a power of 2");
+
+        // written by the interrupt handler and drained by the main loop without disabling interrupts
+        using EventBuffer = stdex::spsc_ring_buffer<Event, kEventQueueSize>;
 
         static constexpr auto kEventSize = sizeof(Event);
         static constexpr auto kEventBufferSize = sizeof(EventBuffer);
@@ -21,6 +21,7 @@ namespace PinMonitor {
         Interrupt::EventBuffer eventBuffer;
     #endif
     uint16_t interrupt_levels;
+    volatile GPIOMaskType pendingPinMask;
 
 // ------------------------------------------------------------------------
 // implementation with GPIO interrupt instead of attachInterrupt...
@@ -67,7 +68,15 @@ namespace PinMonitor {
             ETS_GPIO_INTR_DISABLE();
             for(const auto pinNum: PinMonitor::Interrupt::kRotaryPins) {
                 if ((interrupt_levels ^ levels) & status & GPIO_PIN_TO_MASK(pinNum)) {
-                    PinMonitor::eventBuffer.emplace_back(micros(), pinNum, levels);
+                    #if PIN_MONITOR_STATISTICS
+                        for(const auto &pinPtr: pinMonitor.getPins()) {
+                            if (*pinPtr == pinNum) {
+                                pinPtr->_interrupts++;
+                                break;
+                            }
+                        }
+                    #endif
+                    PinMonitor::eventBuffer.emplace(micros(), pinNum, levels);
                 }
             }
             PinMonitor::interrupt_levels = levels;
@@ -132,6 +141,9 @@ namespace PinMonitor {
             #if PIN_MONITOR_ROTARY_ENCODER_SUPPORT || PIN_MONITOR_DEBOUNCED_PUSHBUTTON
                 auto _micros = micros();
             #endif
+            #if PIN_MONITOR_STATISTICS
+                pin->_interrupts++;
+            #endif
             switch(pin->_type) {
                 #if PIN_MONITOR_DEBOUNCED_PUSHBUTTON
                     case HardwarePinType::DEBOUNCE:
@@ -145,7 +157,7 @@ namespace PinMonitor {
                 #endif
                 #if PIN_MONITOR_ROTARY_ENCODER_SUPPORT
                     case HardwarePinType::ROTARY:
-                        PinMonitor::eventBuffer.emplace_back(_micros, pinNum, levels);
+                        PinMonitor::eventBuffer.emplace(_micros, pinNum, levels);
                         break;
                 #endif
                 default:
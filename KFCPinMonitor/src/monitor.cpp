@@ -128,12 +128,26 @@ namespace PinMonitor {
     #endif
 
     Monitor::Monitor() :
+        _activePins(0),
+        #if PIN_MONITOR_DEBOUNCED_PUSHBUTTON && PIN_MONITOR_VERTICAL_COUNTER_DEBOUNCE
+            _debouncePins(0),
+            _debounceEdges(0),
+            _debounceLevels(0),
+            _lastDebounceSample(0),
+        #endif
+        #if PIN_MONITOR_STATISTICS
+            _loopMicros(0),
+            _loops(0),
+            _maxLoopTime(0),
+        #endif
         _lastRun(0),
+        _lastEvent(0),
         _loopTimer(nullptr),
         _pinModeFlag(INPUT),
         _debounceTime(kDebounceTimeDefault),
         _running(false)
     {
+        _updatePinTable();
     }
 
     Monitor::~Monitor()
@@ -209,6 +223,11 @@ namespace PinMonitor {
         #else
             output.print(F("Rotary Encoder Support: Disabled" HTML_S(br)));
         #endif
+        #if PIN_MONITOR_DEBOUNCED_PUSHBUTTON && PIN_MONITOR_VERTICAL_COUNTER_DEBOUNCE
+            output.printf_P(PSTR("Debounce: Vertical Counter, %u samples every %ums" HTML_S(br)), VerticalDebounce::kSamples, _getDebounceSampleInterval());
+        #elif PIN_MONITOR_DEBOUNCED_PUSHBUTTON
+            output.printf_P(PSTR("Debounce: Timer per Pin, %ums" HTML_S(br)), _debounceTime);
+        #endif
         #if PIN_MONITOR_BUTTON_GROUPS
             output.print(F("Button Groups: Enabled" HTML_S(br)));
         #else
@@ -221,6 +240,22 @@ namespace PinMonitor {
             getPinModeStr(getPinMode()),
             _handlers.size(), _pins.size()
         );
+        #if PIN_MONITOR_STATISTICS
+            Statistics statistics;
+            getStatistics(statistics);
+            output.printf_P(PSTR("Interrupts: %u, dropped %u, bounces %u" HTML_S(br) "Loop: %u, max. %uus" HTML_S(br) "Latency: max. %uus"),
+                statistics.interrupts, statistics.dropped, statistics.bounces, statistics.loops, statistics.maxLoopTime, statistics.latency.max
+            );
+            for(uint8_t i = 0; i < LatencyHistogram::kBuckets; i++) {
+                if (i < LatencyHistogram::kBuckets - 1) {
+                    output.printf_P(PSTR(", <%uus %u"), LatencyHistogram::kLimits[i], statistics.latency.counts[i]);
+                }
+                else {
+                    output.printf_P(PSTR(", >=%uus %u"), LatencyHistogram::kLimits[i - 1], statistics.latency.counts[i]);
+                }
+            }
+            output.print(F(HTML_S(br)));
+        #endif
         for(const auto &handler: _handlers) {
             const auto pinNum = handler->getPin();
             output.printf_P(PSTR("Pin %u, %s, %s, events %u"),
@@ -237,11 +272,118 @@ namespace PinMonitor {
             }
             else {
                 const auto &pin = *iterator;
-                output.printf_P(PSTR(", type %s" HTML_S(br)), pin->getHardwarePinTypeStr());
+                #if PIN_MONITOR_STATISTICS
+                    output.printf_P(PSTR(", type %s, interrupts %u, changes %u" HTML_S(br)), pin->getHardwarePinTypeStr(), pin->_interrupts, pin->_changes);
+                #else
+                    output.printf_P(PSTR(", type %s" HTML_S(br)), pin->getHardwarePinTypeStr());
+                #endif
             }
         }
     }
 
+    #if PIN_MONITOR_STATISTICS
+
+        void Monitor::getStatistics(Statistics &statistics) const
+        {
+            statistics = Statistics();
+            statistics.loops = _loops;
+            statistics.maxLoopTime = _maxLoopTime;
+            statistics.latency = _latency;
+            #if PIN_MONITOR_ROTARY_ENCODER_SUPPORT
+                statistics.dropped = eventBuffer.getOverflows();
+            #endif
+            statistics.pins.reserve(_pins.size());
+            for(const auto &pinPtr: _pins) {
+                PinStatistics pin;
+                {
+                    InterruptLock lock;
+                    pin.interrupts = pinPtr->_interrupts;
+                }
+                pin.changes = pinPtr->_changes;
+                // each debounced state change requires at least one interrupt, all others have been filtered
+                pin.bounces = (pinPtr->_type == HardwarePinType::DEBOUNCE && pin.interrupts > pin.changes) ? pin.interrupts - pin.changes : 0;
+                pin.pin = pinPtr->getPin();
+                pin.type = pinPtr->_type;
+                statistics.interrupts += pin.interrupts;
+                statistics.bounces += pin.bounces;
+                statistics.pins.push_back(pin);
+            }
+        }
+
+        void Monitor::clearStatistics()
+        {
+            _latency.clear();
+            _loops = 0;
+            _maxLoopTime = 0;
+            #if PIN_MONITOR_ROTARY_ENCODER_SUPPORT
+                eventBuffer.clearOverflows();
+            #endif
+            for(const auto &pinPtr: _pins) {
+                {
+                    InterruptLock lock;
+                    pinPtr->_interrupts = 0;
+                }
+                pinPtr->_changes = 0;
+            }
+        }
+
+    #endif
+
+    bool Monitor::isBusy() const
+    {
+        if (!_running || _pins.empty()) {
+            return false;
+        }
+        // time based events like click timeouts or long press
+        if (get_time_since(_lastEvent, millis()) < PIN_MONITOR_SLEEP_IDLE_TIME) {
+            return true;
+        }
+        #if PIN_MONITOR_ROTARY_ENCODER_SUPPORT
+            if (!eventBuffer.empty()) {
+                return true;
+            }
+        #endif
+        #if PIN_MONITOR_DEBOUNCED_PUSHBUTTON && PIN_MONITOR_VERTICAL_COUNTER_DEBOUNCE
+            // a pin is changing its state
+            if (_verticalDebounce.getCounting() & _debouncePins) {
+                return true;
+            }
+        #endif
+        for(const auto &pinPtr: _pins) {
+            switch(pinPtr->_type) {
+                #if PIN_MONITOR_DEBOUNCED_PUSHBUTTON
+                    case HardwarePinType::DEBOUNCE:
+                        if (reinterpret_cast<DebouncedHardwarePin *>(pinPtr.get())->getEvents()._interruptCount) {
+                            return true;
+                        }
+                        break;
+                #endif
+                #if PIN_MONITOR_SIMPLE_PIN
+                    case HardwarePinType::SIMPLE:
+                        if (reinterpret_cast<SimpleHardwarePin *>(pinPtr.get())->getEvents() != SimpleHardwarePin::SimpleEventType::NONE) {
+                            return true;
+                        }
+                        break;
+                #endif
+                default:
+                    break;
+            }
+        }
+        // pressed buttons
+        auto values = GPIO::read();
+        for(const auto &handler: _handlers) {
+            if (handler->isEnabled() && ((values & GPIO_PIN_TO_MASK(handler->getPin())) != 0) == handler->isActiveHigh()) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    SleepPlanner::PinMaskType Monitor::getWakePinMask() const
+    {
+        return static_cast<SleepPlanner::PinMaskType>(_activePins);
+    }
+
     Pin &Monitor::attach(Pin *handler, HardwarePinType type)
     {
         _handlers.emplace_back(handler);
@@ -300,6 +442,7 @@ namespace PinMonitor {
                 #endif
             }
         #endif
+        _updatePinTable();
         if (pinsEmpty) {
             _attachLoop();
         }
@@ -371,9 +514,65 @@ namespace PinMonitor {
                 _detachLoop();
             }
         }
+        _updatePinTable();
         __LDBG_printf("handlers=%u pins=%u", _handlers.size(), _pins.size());
     }
 
+    void Monitor::_updatePinTable()
+    {
+        std::fill(std::begin(_pinTable), std::end(_pinTable), nullptr);
+        std::fill(std::begin(_handlerTable), std::end(_handlerTable), kNoHandler);
+        _activePins = 0;
+        #if PIN_MONITOR_DEBOUNCED_PUSHBUTTON && PIN_MONITOR_VERTICAL_COUNTER_DEBOUNCE
+            GPIOMaskType debouncePins = 0;
+        #endif
+        for(const auto &pinPtr: _pins) {
+            auto pinNum = pinPtr->getPin();
+            if (pinNum < kPinTableSize) {
+                _pinTable[pinNum] = pinPtr.get();
+                _activePins |= GPIO_PIN_TO_MASK(pinNum);
+                #if PIN_MONITOR_DEBOUNCED_PUSHBUTTON && PIN_MONITOR_VERTICAL_COUNTER_DEBOUNCE
+                    if (pinPtr->_type == HardwarePinType::DEBOUNCE) {
+                        debouncePins |= GPIO_PIN_TO_MASK(pinNum);
+                    }
+                #endif
+            }
+        }
+        #if PIN_MONITOR_DEBOUNCED_PUSHBUTTON && PIN_MONITOR_VERTICAL_COUNTER_DEBOUNCE
+            // the initial state of new pins is the current level
+            auto addedPins = debouncePins & ~_debouncePins;
+            if (addedPins) {
+                auto levels = GPIO::read();
+                _verticalDebounce.reset(addedPins, levels);
+                _debounceLevels = (_debounceLevels & ~addedPins) | (levels & addedPins);
+                _debounceEdges &= ~addedPins;
+            }
+            _debouncePins = debouncePins;
+        #endif
+        // link the handlers of each pin in the order they have been attached
+        if (_handlers.size() >= kNoHandler) {
+            __DBG_panic("too many handlers=%u", static_cast<unsigned>(_handlers.size()));
+        }
+        _nextHandler.assign(_handlers.size(), kNoHandler);
+        uint8_t lastHandler[kPinTableSize];
+        for(uint8_t i = 0; i < _handlers.size(); i++) {
+            if (!_handlers[i]) {
+                continue;
+            }
+            auto pinNum = _handlers[i]->getPin();
+            if (pinNum >= kPinTableSize) {
+                continue;
+            }
+            if (_handlerTable[pinNum] == kNoHandler) {
+                _handlerTable[pinNum] = i;
+            }
+            else {
+                _nextHandler[lastHandler[pinNum]] = i;
+            }
+            lastHandler[pinNum] = i;
+        }
+    }
+
     void Monitor::detach(Pin *handler)
     {
         if (_running) {
@@ -391,6 +590,14 @@ namespace PinMonitor {
         }
         else {
             LOOP_FUNCTION_ADD(loop);
+            #if !PIN_MONITOR_USE_POLLING
+                // the loop function can be skipped while no events are pending
+                SleepPlanner::addWakeSource(this, []() {
+                    return pinMonitor.isBusy();
+                }, []() {
+                    return pinMonitor.getWakePinMask();
+                }, loop);
+            #endif
         }
         #if PIN_MONITOR_USE_POLLING
             pollingTimer.start();
@@ -410,6 +617,7 @@ namespace PinMonitor {
         }
         else {
             LoopFunctions::remove(loop);
+            SleepPlanner::removeWakeSource(this);
         }
     }
 
@@ -428,50 +636,33 @@ namespace PinMonitor {
             }
             _lastRun = now;
 
-            #define MEASURE_PROCESSING_TIME 0
+            #if PIN_MONITOR_STATISTICS
+                _loopMicros = micros();
+            #endif
 
             #if PIN_MONITOR_ROTARY_ENCODER_SUPPORT
                 {
-                    #if MEASURE_PROCESSING_TIME
-                        uint32_t eventNum = 0;
-                        uint32_t start = micros();
-                    #endif
-
-                    // process all new events
-                    // the GPIO interrupts must be disabled while reading from eventBuffer or writing to it
-                    // new events might be added while processing
-                    GPIOInterruptLock lock;
-                    if (eventBuffer.size()) {
-                        auto bufIterator = eventBuffer.begin();
-                        while (bufIterator != eventBuffer.end()) {
-                            auto event = *bufIterator;
-                            // destroy object to unlock GPIO interrupts
-                            lock.~GPIOInterruptLock();
-                            #if MEASURE_PROCESSING_TIME
-                                eventNum++;
-                            #endif
-
-                            auto pinIterator = std::find_if(_handlers.begin(), _handlers.end(), [&event](const PinPtr &ptr) {
-                                return ptr->getPin() == event.pin();
-                            });
-                            __LDBG_printf("GPIO pin=%u rotary_encoder=%u", event.pin(), pinIterator != _handlers.end());
-                            if (pinIterator != _handlers.end()) {
-                                auto encoder = reinterpret_cast<RotaryEncoderPin *>(pinIterator->get())->getEncoder();
-                                encoder->processEvent(event);
-                            }
-
-                            // create in place to lock interrupts again
-                            // the destructor has been called already
-                            new(static_cast<void *>(&lock)) GPIOInterruptLock();
-                            ++bufIterator;
+                    // process all events that have been queued so far in a single batch
+                    // the interrupt handler is the only producer and the GPIO interrupts stay enabled. events added
+                    // while processing are picked up by the next call
+                    auto count = eventBuffer.consume([this](Interrupt::Event &&event) {
+                        #if PIN_MONITOR_STATISTICS
+                            _addLatency(event.getTime());
+                        #endif
+                        auto index = (event.pin() < kPinTableSize) ? _handlerTable[event.pin()] : kNoHandler;
+                        __LDBG_printf("GPIO pin=%u rotary_encoder=%u", event.pin(), index != kNoHandler);
+                        if (index != kNoHandler) {
+                            auto encoder = reinterpret_cast<RotaryEncoderPin *>(_handlers[index].get())->getEncoder();
+                            encoder->processEvent(event);
                         }
-                        if (bufIterator == eventBuffer.end()) {
-                            eventBuffer.clear();
+                    });
+                    if (count) {
+                        // one callback per encoder with the steps of the entire batch
+                        for(const auto &pinPtr: _pins) {
+                            if (pinPtr->getHardwarePinType() == HardwarePinType::ROTARY) {
+                                static_cast<RotaryHardwarePin &>(*pinPtr)._encoder.dispatchSteps();
+                            }
                         }
-                        #if MEASURE_PROCESSING_TIME
-                            uint32_t dur = micros() - start;
-                            __DBG_printf("processing rotary events size=%u time=%u", eventNum, dur);
-                        #endif
                         // update time
                         now = millis();
                     }
@@ -479,84 +670,177 @@ namespace PinMonitor {
             #endif
 
             #if PIN_MONITOR_DEBOUNCED_PUSHBUTTON || PIN_MONITOR_SIMPLE_PIN
-                #if MEASURE_PROCESSING_TIME
-                    uint32_t start = micros();
-                    uint32_t eventNum = 0;
+                // only pins that had an interrupt since the last call are visited
+                GPIOMaskType pending;
+                #if PIN_MONITOR_DEBOUNCED_PUSHBUTTON && PIN_MONITOR_VERTICAL_COUNTER_DEBOUNCE
+                    GPIOValueType levels;
                 #endif
-                for(const auto &pinPtr: _pins) {
-                    switch(pinPtr->_type) {
-                        #if PIN_MONITOR_DEBOUNCED_PUSHBUTTON
-                            case HardwarePinType::DEBOUNCE: {
-                                    auto &pin = *reinterpret_cast<DebouncedHardwarePin *>(pinPtr.get());
-                                    auto event = pin.getEventsClear();
-                                    if (event._interruptCount) {
-                                        #if MEASURE_PROCESSING_TIME
-                                            eventNum++;
-                                        #endif
-                                        _event(pin.getPin(), pin.getDebounce()->debounce(event._value, event._interruptCount, event._micros, now), now);
-                                    }
-                                }
-                                break;
-                        #endif
-                        #if PIN_MONITOR_SIMPLE_PIN
-                            case HardwarePinType::SIMPLE: {
-                                    #if MEASURE_PROCESSING_TIME
-                                        eventNum++;
-                                    #endif
-                                    auto &pin = *reinterpret_cast<SimpleHardwarePin *>(pinPtr.get());
-                                    auto event = pin.getEventsClear();
-                                    if (event != SimpleHardwarePin::SimpleEventType::NONE) {
-                                        __LDBG_printf("SIMPLE=%u event=%u", pin.getPin(), event);
-                                        _event(pin.getPin(), event == SimpleHardwarePin::SimpleEventType::HIGH_VALUE ? StateType::IS_HIGH : StateType::IS_LOW, now);
-                                    }
-                                }
-                                break;
-                        #endif
-                        default:
-                            break;
-                    }
+                {
+                    InterruptLock lock;
+                    pending = pendingPinMask;
+                    pendingPinMask = 0;
+                    #if PIN_MONITOR_DEBOUNCED_PUSHBUTTON && PIN_MONITOR_VERTICAL_COUNTER_DEBOUNCE
+                        // the levels must match the interrupts that have been collected
+                        levels = GPIO::read();
+                    #endif
+                }
+                #if PIN_MONITOR_DEBOUNCED_PUSHBUTTON && PIN_MONITOR_VERTICAL_COUNTER_DEBOUNCE
+                    // latch the edges until the next sample
+                    _debounceEdges |= pending & _debouncePins;
+                #endif
+                pending &= _activePins;
+                while(pending) {
+                    auto pinNum = (sizeof(GPIOMaskType) > sizeof(uint32_t)) ? __builtin_ctzll(pending) : __builtin_ctz(static_cast<uint32_t>(pending));
+                    pending &= pending - 1;
+                    _processPinEvents(*_pinTable[pinNum], now);
                 }
-                #if MEASURE_PROCESSING_TIME
-                    if (eventNum) {
-                        uint32_t dur = micros() - start;
-                        __DBG_printf("processing pins=%u time=%u events=%u", _pins.size(), dur, eventNum);
+                #if PIN_MONITOR_POLLING_GPIO_EXPANDER_SUPPORT
+                    // pins of the GPIO expander are not part of the pending mask
+                    for(const auto &pinPtr: _pins) {
+                        if (pinPtr->getPin() >= kPinTableSize) {
+                            _processPinEvents(*pinPtr, now);
+                        }
                     }
                 #endif
             #endif
 
             #if PIN_MONITOR_DEBOUNCED_PUSHBUTTON
 
-                uint32_t time = micros();
                 now = millis();
 
-                // inject "empty" events once per millisecond into the pins with debouncing to update states that are time based
-                for(const auto &pinPtr: _pins) {
-                    auto debounce = pinPtr->getDebounce();
-                    if (debounce) {
-                        auto pinNum = pinPtr->getPin();
-                        _event(pinNum, debounce->debounce(GPIO::read() & GPIO_PIN_TO_MASK(pinNum), 0, time, now), now);
+                #if PIN_MONITOR_VERTICAL_COUNTER_DEBOUNCE
+                    if (_debouncePins && get_time_since(_lastDebounceSample, now) >= _getDebounceSampleInterval()) {
+                        _lastDebounceSample = now;
+                        _sampleDebouncedPins(levels, now);
                     }
-                }
+                #endif
+
+                #if !PIN_MONITOR_VERTICAL_COUNTER_DEBOUNCE || PIN_MONITOR_POLLING_GPIO_EXPANDER_SUPPORT
+                    uint32_t time = micros();
+
+                    // inject "empty" events once per millisecond into the pins with debouncing to update states that are time based
+                    for(const auto &pinPtr: _pins) {
+                        #if PIN_MONITOR_VERTICAL_COUNTER_DEBOUNCE
+                            // GPIO expander pins only
+                            if (pinPtr->getPin() < kPinTableSize) {
+                                continue;
+                            }
+                        #endif
+                        auto debounce = pinPtr->getDebounce();
+                        if (debounce) {
+                            auto pinNum = pinPtr->getPin();
+                            _event(pinNum, debounce->debounce(GPIO::read() & GPIO_PIN_TO_MASK(pinNum), 0, time, now), now);
+                        }
+                    }
+                #endif
             #endif
 
             for(const auto &handler: _handlers) {
                 handler->loop();
             }
+            #if PIN_MONITOR_STATISTICS
+                _loops++;
+                _maxLoopTime = std::max<uint32_t>(_maxLoopTime, micros() - _loopMicros);
+            #endif
             _lastRun = millis(); // update time again
         }
     }
 
+    bool Monitor::_processPinEvents(HardwarePin &pinRef, uint32_t now)
+    {
+        switch(pinRef._type) {
+            #if PIN_MONITOR_DEBOUNCED_PUSHBUTTON
+                case HardwarePinType::DEBOUNCE: {
+                        auto &pin = static_cast<DebouncedHardwarePin &>(pinRef);
+                        auto event = pin.getEventsClear();
+                        #if PIN_MONITOR_STATISTICS
+                            // time of the last interrupt
+                            if (event._interruptCount) {
+                                _addLatency(event._micros);
+                            }
+                        #endif
+                        #if PIN_MONITOR_VERTICAL_COUNTER_DEBOUNCE
+                            // the interrupts are counted to wake up the loop, the pin is sampled by _sampleDebouncedPins()
+                            if (pin.getPin() < kPinTableSize) {
+                                break;
+                            }
+                        #endif
+                        if (event._interruptCount) {
+                            _event(pin.getPin(), pin.getDebounce()->debounce(event._value, event._interruptCount, event._micros, now), now);
+                            return true;
+                        }
+                    }
+                    break;
+            #endif
+            #if PIN_MONITOR_SIMPLE_PIN
+                case HardwarePinType::SIMPLE: {
+                        auto &pin = static_cast<SimpleHardwarePin &>(pinRef);
+                        auto event = pin.getEventsClear();
+                        if (event != SimpleHardwarePin::SimpleEventType::NONE) {
+                            __LDBG_printf("SIMPLE=%u event=%u", pin.getPin(), event);
+                            _event(pin.getPin(), event == SimpleHardwarePin::SimpleEventType::HIGH_VALUE ? StateType::IS_HIGH : StateType::IS_LOW, now);
+                            return true;
+                        }
+                    }
+                    break;
+            #endif
+            default:
+                break;
+        }
+        return false;
+    }
+
+    #if PIN_MONITOR_DEBOUNCED_PUSHBUTTON && PIN_MONITOR_VERTICAL_COUNTER_DEBOUNCE
+
+        void Monitor::_sampleDebouncedPins(GPIOValueType levels, uint32_t now)
+        {
+            // a pin with interrupts that has the same level as in the last sample had a pulse between the samples.
+            // the opposite level is used for this sample and the pulse is reported as bounce. it is not lost if it
+            // was shorter than the sample interval or the loop has been blocked
+            auto missed = _debounceEdges & ~(levels ^ _debounceLevels);
+            _debounceEdges = 0;
+            _debounceLevels = levels;
+            auto result = _verticalDebounce.sample(levels ^ missed);
+            auto changed = result.changed() & _debouncePins;
+            auto stable = _verticalDebounce.getState();
+            while(changed) {
+                auto pinNum = (sizeof(GPIOMaskType) > sizeof(uint32_t)) ? __builtin_ctzll(changed) : __builtin_ctz(static_cast<uint32_t>(changed));
+                changed &= changed - 1;
+                _event(pinNum, result.getState(GPIO_PIN_TO_MASK(pinNum), stable), now);
+            }
+        }
+
+    #endif
+
     void Monitor::_event(uint8_t pinNum, StateType state, uint32_t now)
     {
-        for(const auto &handler: _handlers) {
-            if (handler.get()) {
-                StateType tmp;
-                if (handler->getPin() == pinNum && handler->isEnabled() && (tmp = handler->_getStateIfEnabled(state)) != StateType::NONE) {
-                    InterruptLock lock;
-                    handler->_eventCounter++;
-                    handler->event(tmp, now);
+        #if PIN_MONITOR_STATISTICS
+            if (state == StateType::IS_HIGH || state == StateType::IS_LOW) {
+                auto pin = getPin(pinNum);
+                if (pin) {
+                    pin->_changes++;
                 }
             }
+        #endif
+        auto dispatch = [this, state, now](Pin &handler) {
+            StateType tmp;
+            if (handler.isEnabled() && (tmp = handler._getStateIfEnabled(state)) != StateType::NONE) {
+                InterruptLock lock;
+                handler._eventCounter++;
+                _lastEvent = now;
+                handler.event(tmp, now);
+            }
+        };
+        if (pinNum < kPinTableSize) {
+            for(auto index = _handlerTable[pinNum]; index != kNoHandler; index = _nextHandler[index]) {
+                dispatch(*_handlers[index]);
+            }
+            return;
+        }
+        for(const auto &handler: _handlers) {
+            if (handler.get() && handler->getPin() == pinNum) {
+                dispatch(*handler);
+            }
         }
     }
 
@@ -31,6 +31,12 @@ namespace PinMonitor {
 
         void printStatus(Print &output);
 
+        // returns true if events are waiting to be processed, a button is pressed or the last event has occurred less than
+        // PIN_MONITOR_SLEEP_IDLE_TIME milliseconds ago. the loop function is not required otherwise
+        bool isBusy() const;
+        // GPIOs with interrupts that can wake up the device
+        SleepPlanner::PinMaskType getWakePinMask() const;
+
         // add a pin object
         Pin &attach(Pin *pin, HardwarePinType type = HardwarePinType::_DEFAULT);
 
@@ -54,6 +60,17 @@ namespace PinMonitor {
         const Vector &getHandlers() const;
         const PinVector &getPins() const;
 
+        #if PIN_MONITOR_STATISTICS
+            // copy the counters of the monitor and all pins
+            void getStatistics(Statistics &statistics) const;
+            void clearStatistics();
+        #endif
+
+        // returns nullptr if the pin is not attached
+        HardwarePin *getPin(uint8_t pin) const;
+        // GPIOs that have a hardware pin attached
+        GPIOMaskType getActivePinMask() const;
+
     public:
         static void loop();
         static void loopTimer(Event::CallbackTimerPtr);
@@ -66,6 +83,22 @@ namespace PinMonitor {
     private:
         Pin &_attach(Pin &pin, HardwarePinType type = HardwarePinType::_DEFAULT);
         void _detach(Iterator begin, Iterator end, bool clear);
+        // rebuild the lookup tables after pins or handlers have been added or removed
+        void _updatePinTable();
+        // pass the events of a debounced or simple pin to the handlers
+        // returns false if the pin did not have any events
+        bool _processPinEvents(HardwarePin &pin, uint32_t now);
+        #if PIN_MONITOR_STATISTICS
+            // add the time between micros and the start of the loop to the latency histogram
+            void _addLatency(uint32_t micros);
+        #endif
+        #if PIN_MONITOR_DEBOUNCED_PUSHBUTTON && PIN_MONITOR_VERTICAL_COUNTER_DEBOUNCE
+            // sample all debounced GPIOs and pass the state changes to the handlers
+            // levels is the GPIO register read together with the pending interrupts
+            void _sampleDebouncedPins(GPIOValueType levels, uint32_t now);
+            // milliseconds between samples
+            uint8_t _getDebounceSampleInterval() const;
+        #endif
     private:
         void _attachLoop();
         void _detachLoop();
@@ -75,10 +108,33 @@ namespace PinMonitor {
     private:
 
     private:
+        static constexpr uint8_t kNoHandler = 0xff;
+        static constexpr uint8_t kPinTableSize = NUM_DIGITAL_PINS;
+
         Vector _handlers;       // button handler, base class Pin
         PinVector _pins;        // pins class HardwarePin
+        // lookup tables for pins below NUM_DIGITAL_PINS, other pins are searched in _pins and _handlers
+        HardwarePin *_pinTable[kPinTableSize];      // hardware pin by GPIO number
+        uint8_t _handlerTable[kPinTableSize];       // index of the first handler in _handlers or kNoHandler
+        std::vector<uint8_t> _nextHandler;          // index of the next handler with the same pin or kNoHandler
+        GPIOMaskType _activePins;                   // GPIOs with a hardware pin attached
+        #if PIN_MONITOR_DEBOUNCED_PUSHBUTTON && PIN_MONITOR_VERTICAL_COUNTER_DEBOUNCE
+            using VerticalDebounce = VerticalCounterDebounce<GPIOMaskType>;
+            VerticalDebounce _verticalDebounce;
+            GPIOMaskType _debouncePins;             // GPIOs debounced by _verticalDebounce
+            GPIOMaskType _debounceEdges;            // GPIOs with interrupts since the last sample
+            GPIOValueType _debounceLevels;          // GPIO register of the last sample
+            uint32_t _lastDebounceSample;           // millis() of the last sample
+        #endif
+        #if PIN_MONITOR_STATISTICS
+            LatencyHistogram _latency;
+            uint32_t _loopMicros;                   // micros() when _loop() has started
+            uint32_t _loops;
+            uint32_t _maxLoopTime;
+        #endif
         SemaphoreMutex _lock;   // lock for _loop() in loopTimer()
         uint32_t _lastRun;
+        uint32_t _lastEvent;    // millis() of the last event passed to a handler
         Event::Timer *_loopTimer;
         uint8_t _pinModeFlag;
         uint8_t _debounceTime;
@@ -96,6 +152,27 @@ namespace PinMonitor {
         return _debounceTime;
     }
 
+    #if PIN_MONITOR_DEBOUNCED_PUSHBUTTON && PIN_MONITOR_VERTICAL_COUNTER_DEBOUNCE
+
+        inline uint8_t Monitor::_getDebounceSampleInterval() const
+        {
+            // round up to reach the debounce time with kSamples
+            return std::max<uint8_t>(1, (_debounceTime + VerticalDebounce::kSamples - 1) / VerticalDebounce::kSamples);
+        }
+
+    #endif
+
+    #if PIN_MONITOR_STATISTICS
+
+        inline void Monitor::_addLatency(uint32_t micros)
+        {
+            // events can be added after the loop has started
+            auto latency = static_cast<int32_t>(_loopMicros - micros);
+            _latency.add(latency > 0 ? latency : 0);
+        }
+
+    #endif
+
     // set default pin mode for adding new pins
     inline void Monitor::setDefaultPinMode(uint8_t mode)
     {
@@ -127,6 +204,22 @@ namespace PinMonitor {
         return _pins;
     }
 
+    inline HardwarePin *Monitor::getPin(uint8_t pin) const
+    {
+        if (pin < kPinTableSize) {
+            return _pinTable[pin];
+        }
+        auto iterator = std::find_if(_pins.begin(), _pins.end(), [pin](const HardwarePinPtr &pinPtr) {
+            return pinPtr->getPin() == pin;
+        });
+        return (iterator == _pins.end()) ? nullptr : iterator->get();
+    }
+
+    inline GPIOMaskType Monitor::getActivePinMask() const
+    {
+        return _activePins;
+    }
+
     extern Monitor pinMonitor;
 
     inline void Monitor::loop()
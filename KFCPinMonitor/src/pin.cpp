@@ -22,6 +22,10 @@
 
 using namespace PinMonitor;
 
+#if PIN_MONITOR_SIMULATED_GPIO
+    GPIOValueType GPIOSimulated::value;
+#endif
+
 #if PIN_MONITOR_USE_GPIO_INTERRUPT == 0 || PIN_MONITOR_USE_POLLING == 1
 
     // #if ESP32
@@ -54,7 +58,7 @@ using namespace PinMonitor;
     //             #endif
     //             #if PIN_MONITOR_ROTARY_ENCODER_SUPPORT
     //                 case HardwarePinType::ROTARY:
-    //                     PinMonitor::eventBuffer.emplace_back(_micros, pinPtr->getPin(), _GPI);
+    //                     PinMonitor::eventBuffer.emplace(_micros, pinPtr->getPin(), _GPI);
     //                     break;
     //             #endif
     //             default:
@@ -74,6 +78,9 @@ using namespace PinMonitor;
             #if PIN_MONITOR_DEBOUNCED_PUSHBUTTON || PIN_MONITOR_ROTARY_ENCODER_SUPPORT
                 auto _micros = micros();
             #endif
+            #if PIN_MONITOR_STATISTICS
+                pinPtr->_interrupts++;
+            #endif
             switch(pinPtr->_type) {
                 #if PIN_MONITOR_DEBOUNCED_PUSHBUTTON
                     case HardwarePinType::DEBOUNCE:
@@ -87,7 +94,7 @@ using namespace PinMonitor;
                 #endif
                 #if PIN_MONITOR_ROTARY_ENCODER_SUPPORT
                     case HardwarePinType::ROTARY:
-                        PinMonitor::eventBuffer.emplace_back(_micros, pinPtr->getPin(), GPIOValues);
+                        PinMonitor::eventBuffer.emplace(_micros, pinPtr->getPin(), GPIOValues);
                         break;
                 #endif
                 default:
@@ -27,7 +27,9 @@ namespace PinMonitor {
             }
         };
 
-        using GPIO = GPIO32;
+        #if !PIN_MONITOR_SIMULATED_GPIO
+            using GPIO = GPIO32;
+        #endif
 
     #elif ESP32
 
@@ -53,12 +55,34 @@ namespace PinMonitor {
             }
         };
 
-        using GPIO = GPIO64;
+        #if !PIN_MONITOR_SIMULATED_GPIO
+            using GPIO = GPIO64;
+        #endif
+
+    #endif
+
+    #if PIN_MONITOR_SIMULATED_GPIO
+
+        struct GPIOSimulated {
+            using type = GPIOValueType;
+            static GPIOValueType value;
+            static GPIOValueType read() {
+                return value;
+            }
+        };
+
+        using GPIO = GPIOSimulated;
 
     #endif
 
     #define GPIO_PIN_TO_MASK(pin) (static_cast<GPIOMaskType>(1) << pin)
 
+    static_assert(NUM_DIGITAL_PINS <= sizeof(GPIOMaskType) * 8, "GPIOMaskType too small");
+
+    // GPIOs with events that have not been processed by the main loop. set by HardwarePin::addEvent() and
+    // cleared by Monitor::_loop(). pins above NUM_DIGITAL_PINS are not included
+    extern volatile GPIOMaskType pendingPinMask;
+
     // --------------------------------------------------------------------
     // PinMonitor::Pin
     // --------------------------------------------------------------------
@@ -182,6 +206,10 @@ namespace PinMonitor {
     class HardwarePin {
     public:
         HardwarePin(uint8_t pin, HardwarePinType type) :
+            #if PIN_MONITOR_STATISTICS
+                _interrupts(0),
+                _changes(0),
+            #endif
             _pin(pin),
             _count(0),
             _type(type)
@@ -206,6 +234,17 @@ namespace PinMonitor {
             return _type;
         }
 
+    protected:
+        // must be called with interrupts locked
+        inline __attribute__((__always_inline__))
+        void _setPending() {
+            if (_pin < NUM_DIGITAL_PINS) {
+                pendingPinMask |= GPIO_PIN_TO_MASK(_pin);
+            }
+        }
+
+    public:
+
         const __FlashStringHelper *getHardwarePinTypeStr() const  {
             return PinMonitor::getHardwarePinTypeStr(_type);
         }
@@ -249,6 +288,10 @@ namespace PinMonitor {
             return pin != _pin;
         }
 
+        #if PIN_MONITOR_STATISTICS
+            uint32_t _interrupts;       // incremented by the interrupt handler
+            uint32_t _changes;          // debounced state changes
+        #endif
         uint8_t _pin;
         uint8_t _count;
         HardwarePinType _type;
@@ -282,6 +325,7 @@ namespace PinMonitor {
         void addEvent(bool value) {
             InterruptLock lock;
             _event = value ? SimpleEventType::HIGH_VALUE : SimpleEventType::LOW_VALUE;
+            _setPending();
         }
 
         inline __attribute__((__always_inline__))
@@ -356,6 +400,7 @@ namespace PinMonitor {
             _events._micros = micros;
             _events._interruptCount++;
             _events._value = value;
+            _setPending();
         }
 
         inline __attribute__((__always_inline__))
@@ -7,6 +7,7 @@
 #include <Arduino_compat.h>
 #include <EventScheduler.h>
 #include <vector>
+#include <stl_ext/inplace_function.h>
 
 // Pin Monitor offers interrupt bases PIN monitoring with support for toggle switches, push buttons, rotary encoders with or without software debouncing
 // Arduino interrupt functions can be used or the optimized version of the pin monitor, which saves a couple hundred byte IRAM
@@ -35,6 +36,7 @@
 // - support for touch buttons
 // - support for multi touch and button combinations (i.e. hold key1 + key4 for 5 seconds to reboot the device)
 // - 2 pin rotary encoders with acceleration
+// - gestures like multiple clicks, hold, chords and press and rotate, see PIN_MONITOR_GESTURES
 // - any kind of pin monitoring
 //
 // pins can be configured active low or active high globally, or set individually
@@ -156,20 +158,41 @@
 #    define PIN_MONITOR_DEBOUNCE_TIME 10
 #endif
 
+// debounce all GPIOs with a vertical counter instead of a debounce timer per pin
+// the GPIO register is read once per interval (debounce time / 4) and the state of a pin changes after 4 equal samples
+// interrupts are latched until the next sample, pulses between two samples are reported as bounce
+// pins above NUM_DIGITAL_PINS like GPIO expanders use the debounce timer
+#ifndef PIN_MONITOR_VERTICAL_COUNTER_DEBOUNCE
+#    define PIN_MONITOR_VERTICAL_COUNTER_DEBOUNCE 1
+#endif
+
 // support for button groups
 // allows to detect single/double clicks across multiple buttons
 #ifndef PIN_MONITOR_BUTTON_GROUPS
 #    define PIN_MONITOR_BUTTON_GROUPS 0
 #endif
 
+// support for gestures, see GestureEngine
+// gestures are compiled into transition tables and share a single timer instead of using PushButton objects
+#ifndef PIN_MONITOR_GESTURES
+#    define PIN_MONITOR_GESTURES 0
+#endif
+
+// time in milliseconds after the last event until the pin monitor allows the device to sleep
+// it must exceed the longest timeout of the push buttons. see SleepPlanner
+#ifndef PIN_MONITOR_SLEEP_IDLE_TIME
+#    define PIN_MONITOR_SLEEP_IDLE_TIME 2500
+#endif
+
 // global default configuration
 #ifndef PIN_MONITOR_ACTIVE_STATE
 #    define PIN_MONITOR_ACTIVE_STATE ActiveStateType::ACTIVE_HIGH
 // #define PIN_MONITOR_ACTIVE_STATE                                ActiveStateType::ACTIVE_LOW
 #endif
 
-// max. number of events that can be stored before processing is required. old events get dropped
-// each event requires 6 byte of RAM + the queue overhead (64 events = 396 byte, 16 = 108 byte)
+// max. number of events that can be stored before processing is required. must be a power of 2
+// new events get dropped if the queue is full and counted as overflows
+// each event requires 6 byte of RAM + the queue overhead (64 events = 400 byte, 16 = 112 byte)
 //
 // the required size depends on how often the queue is processed and how many events the buttons and encoders produce
 // hardware debounces buttons will create 2 events, down and up while buttons with capacitors and pull-down/up resistors
@@ -179,6 +202,18 @@
 #    define PIN_MONITOR_EVENT_QUEUE_SIZE 64
 #endif
 
+// count interrupts, dropped events, bounces, the latency between the interrupt and the main loop and the loop
+// processing time. see Monitor::getStatistics()
+#ifndef PIN_MONITOR_STATISTICS
+#    define PIN_MONITOR_STATISTICS 1
+#endif
+
+// replace the GPIO input register with GPIOSimulated::value, which is set by the host test harness
+// see tests/pin_monitor_replay
+#ifndef PIN_MONITOR_SIMULATED_GPIO
+#    define PIN_MONITOR_SIMULATED_GPIO 0
+#endif
+
 #if DEBUG_PIN_MONITOR
 #    define IF_DEBUG_PIN_MONITOR(...) __VA_ARGS__
 #else
@@ -187,6 +222,13 @@
 
 namespace PinMonitor {
 
+    #if EVENT_SCHEDULER_SIMULATED_CLOCK
+        // hides ::millis() and ::micros() inside the PinMonitor namespace. the interrupt timestamps, debouncing and
+        // button timeouts use the simulated clock of the event scheduler
+        using Event::millis;
+        using Event::micros;
+    #endif
+
     // all frequencies above (1000 / kDebounceTimeDefault) Hz will be filtered
     static constexpr uint8_t kDebounceTimeDefault = PIN_MONITOR_DEBOUNCE_TIME; // milliseconds
 
@@ -204,7 +246,7 @@ namespace PinMonitor {
     using Iterator = Vector::iterator;
     using HardwarePinPtr = std::unique_ptr<HardwarePin>;
     using PinVector = std::vector<HardwarePinPtr>;
-    using Predicate = std::function<bool(const PinPtr &pin)>;
+    using Predicate = stdex::inplace_function<bool(const PinPtr &pin)>;
 
     enum class HardwarePinType : uint8_t {
         NONE = 0,
@@ -247,11 +289,15 @@ namespace PinMonitor {
 }
 
 #include "debounce.h"
+#include "statistics.h"
 #include "interrupt_impl.h"
 #include "monitor.h"
 #include "pin.h"
 #include "push_button.h"
 #include "rotary_encoder.h"
+#if PIN_MONITOR_GESTURES
+#    include "gesture.h"
+#endif
 
 #if !ESP8266
 #    if PIN_MONITOR_USE_POLLING
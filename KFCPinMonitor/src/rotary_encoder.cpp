@@ -45,164 +45,91 @@ void RotaryEncoder::attachPins(uint8_t pin1, uint8_t pin2)
     _mask2 = GPIO_PIN_TO_MASK(pin2);
     pinMode(pin1, PinMonitor::pinMonitor.getPinMode());
     pinMode(pin2, PinMonitor::pinMonitor.getPinMode());
+    // start with the current state of the pins, the first transition is decoded in the wrong direction otherwise
+    _state = _getValue(GPIO::read());
+    _position = 0;
+    _pendingSteps = 0;
+    _lastDirection = 0;
 }
 
-// https://github.com/buxtronix/arduino/blob/master/libraries/Rotary/Rotary.cpp
-
-/* Rotary encoder handler for arduino. v1.1
- *
- * Copyright 2011 Ben Buxton. Licenced under the GNU GPL Version 3.
- * Contact: bb@cactii.net
- *
- * A typical mechanical rotary encoder emits a two bit gray code
- * on 3 output pins. Every step in the output (often accompanied
- * by a physical 'click') generates a specific sequence of output
- * codes on the pins.
- *
- * There are 3 pins used for the rotary encoding - one common and
- * two 'bit' pins.
- *
- * The following is the typical sequence of code on the output when
- * moving from one step to the next:
- *
- *   Position   Bit1   Bit2
- *   ----------------------
- *     Step1     0      0
- *      1/4      1      0
- *      1/2      1      1
- *      3/4      0      1
- *     Step2     0      0
- *
- * From this table, we can see that when moving from one 'click' to
- * the next, there are 4 changes in the output code.
- *
- * - From an initial 0 - 0, Bit1 goes high, Bit0 stays low.
- * - Then both bits are high, halfway through the step.
- * - Then Bit1 goes low, but Bit2 stays high.
- * - Finally at the end of the step, both bits return to 0.
- *
- * Detecting the direction is easy - the table simply goes in the other
- * direction (read up instead of down).
- *
- * To decode this, we use a simple state machine. Every time the output
- * code changes, it follows state, until finally a full steps worth of
- * code is received (in the correct order). At the final 0-0, it returns
- * a value indicating a step in one direction or the other.
- *
- * It's also possible to use 'half-step' mode. This just emits an event
- * at both the 0-0 and 1-1 positions. This might be useful for some
- * encoders where you want to detect all positions.
- *
- * If an invalid state happens (for example we go from '0-1' straight
- * to '1-0'), the state machine resets to the start until 0-0 and the
- * next valid codes occur.
- *
- * The biggest advantage of using a state machine over other algorithms
- * is that this has inherent debounce built in. Other algorithms emit spurious
- * output with switch bounce, but this one will simply flip between
- * sub-states until the bounce settles, then continue along the state
- * machine.
- * A side effect of debounce is that fast rotations can cause steps to
- * be skipped. By not requiring debounce, fast rotations can be accurately
- * measured.
- * Another advantage is the ability to properly handle bad state, such
- * as due to EMI, etc.
- * It is also a lot simpler than others - a static state table and less
- * than 10 lines of logic.
- */
-
-// #include "Arduino.h"
-// #include "Rotary.h"
+// transitions of the pins indexed by (previous state << 2) | state. the states are gray coded, moving to the left
+// is 00 -> 01 -> 11 -> 10 -> 00 (pin1 leads)
+//
+// +1 = quarter step to the right, -1 = quarter step to the left, 0 = no change, kInvalid = both pins changed
 
-/*
- * The below state table has, for each state (row), the new state
- * to set based on the next encoder output. From left to right in,
- * the table, the encoder outputs are 00, 01, 10, 11, and the value
- * in that position is the new state to set.
- */
+static constexpr int8_t kInvalid = 2;
 
-#define R_START 0x0
-
-	// Values returned by 'process'
-// No complete step yet.
-#define DIR_NONE 0x0
-// Clockwise step.
-#define DIR_CW 0x10
-// Anti-clockwise step.
-#define DIR_CCW 0x20
-
-//#define HALF_STEP
-
-#ifdef HALF_STEP
-    // Use the half-step state table (emits a code at 00 and 11)
-    #define R_CCW_BEGIN 0x1
-    #define R_CW_BEGIN 0x2
-    #define R_START_M 0x3
-    #define R_CW_BEGIN_M 0x4
-    #define R_CCW_BEGIN_M 0x5
-
-    static const uint8_t stateTable_P[6][4] PROGMEM = {
-        // R_START (00)
-        {R_START_M,            R_CW_BEGIN,     R_CCW_BEGIN,  R_START},
-        // R_CCW_BEGIN
-        {R_START_M | DIR_CCW, R_START,        R_CCW_BEGIN,  R_START},
-        // R_CW_BEGIN
-        {R_START_M | DIR_CW,  R_CW_BEGIN,     R_START,      R_START},
-        // R_START_M (11)
-        {R_START_M,            R_CCW_BEGIN_M,  R_CW_BEGIN_M, R_START},
-        // R_CW_BEGIN_M
-        {R_START_M,            R_START_M,      R_CW_BEGIN_M, R_START | DIR_CW},
-        // R_CCW_BEGIN_M
-    {R_START_M,            R_CCW_BEGIN_M,  R_START_M,    R_START | DIR_CCW},
-    };
-#else
-    // Use the full-step state table (emits a code at 00 only)
-    #define R_CW_FINAL 0x1
-    #define R_CW_BEGIN 0x2
-    #define R_CW_NEXT 0x3
-    #define R_CCW_BEGIN 0x4
-    #define R_CCW_FINAL 0x5
-    #define R_CCW_NEXT 0x6
-
-    static const uint8_t stateTable_P[7][4] PROGMEM = {
-        // R_START
-        {R_START,    R_CW_BEGIN,  R_CCW_BEGIN, R_START},
-        // R_CW_FINAL
-        {R_CW_NEXT,  R_START,     R_CW_FINAL,  R_START | DIR_CW},
-        // R_CW_BEGIN
-        {R_CW_NEXT,  R_CW_BEGIN,  R_START,     R_START},
-        // R_CW_NEXT
-        {R_CW_NEXT,  R_CW_BEGIN,  R_CW_FINAL,  R_START},
-        // R_CCW_BEGIN
-        {R_CCW_NEXT, R_START,     R_CCW_BEGIN, R_START},
-        // R_CCW_FINAL
-        {R_CCW_NEXT, R_CCW_FINAL, R_START,     R_START | DIR_CCW},
-        // R_CCW_NEXT
-        {R_CCW_NEXT, R_CCW_FINAL, R_CCW_BEGIN, R_START},
-    };
-#endif
+static const int8_t kTransitionTable_P[16] PROGMEM = {
+    // from 00
+    0,          -1,         +1,         kInvalid,
+    // from 01
+    +1,         0,          kInvalid,   -1,
+    // from 10
+    -1,         kInvalid,   0,          +1,
+    // from 11
+    kInvalid,   +1,         -1,         0
+};
 
 void RotaryEncoder::processEvent(const Interrupt::Event &eventData)
 {
-    // uint8_t value = ((eventData.gpiRegValue() & _mask1) != 0) | (((eventData.gpiRegValue() & _mask2) != 0) << 1);
-    uint8_t value = (eventData.gpiRegValue() & _mask1) ? 0b01 : 0b00;
-    if (eventData.gpiRegValue() & _mask2) {
-        value |= 0b10;
+    uint8_t value = _getValue(eventData.gpiRegValue());
+    int8_t transition = static_cast<int8_t>(pgm_read_byte(reinterpret_cast<const uint8_t *>(kTransitionTable_P) + ((_state << 2) | value)));
+
+    __LDBG_printf("rotary value=0b%u%u state=%u transition=%d position=%d", value & 1, value >> 1, _state, transition, _position);
+
+    _state = value;
+    if (transition == kInvalid) {
+        // the direction is unknown. the quarter steps are missing and the position is rounded at the next detent
+        _invalidTransitions++;
     }
-    if (_activeState == ActiveStateType::ACTIVE_LOW) {
-        value ^= 0b11;
+    else {
+        _position += transition;
     }
 
-    // reads stateTable_P[_state & 0xf][value]
-    uint8_t newState = pgm_read_byte(reinterpret_cast<const uint8_t *>(stateTable_P) + (((_state & 0xf) * 4) + value));
+    // detents at 00 for full steps and at 00 and 11 for half steps
+    int8_t quarterSteps;
+    if (value == 0b00) {
+        quarterSteps = (_mode == StepMode::HALF_STEP) ? 2 : 4;
+    }
+    else if (value == 0b11 && _mode == StepMode::HALF_STEP) {
+        quarterSteps = 2;
+    }
+    else {
+        return;
+    }
+    // round to the nearest step
+    int8_t steps = (_position + ((_position < 0) ? -(quarterSteps / 2) : (quarterSteps / 2))) / quarterSteps;
+    _position = 0;
+    if (steps) {
+        _addSteps(steps, eventData.getTime());
+    }
+}
+
+void RotaryEncoder::_addSteps(int8_t steps, uint32_t now)
+{
+    int8_t direction = (steps < 0) ? -1 : 1;
+    int16_t factor = 1;
+    if (_accelerationMax > 1 && direction == _lastDirection) {
+        uint32_t interval = std::max<uint32_t>(1, now - _lastStepTime);
+        if (interval < _accelerationInterval) {
+            factor = std::min<uint32_t>(_accelerationMax, _accelerationInterval / interval);
+        }
+    }
+    _lastStepTime = now;
+    _lastDirection = direction;
+    _pendingTime = now;
 
-    __LDBG_printf("rotary value=0b%u%u state=0x%02x/%u -> 0x%02x %02x", value&1, value>>1, _state&0xf, _state, newState);
+    // saturate the pending steps if the loop does not dispatch them
+    int32_t pending = _pendingSteps + static_cast<int32_t>(steps) * factor;
+    _pendingSteps = std::max<int32_t>(INT16_MIN, std::min<int32_t>(INT16_MAX, pending));
+}
 
-    // _state = stateTable[_state & 0xf][state];
-    if (newState >= DIR_CW) {
-        event(static_cast<EventType>(newState), eventData.getTime());
+void RotaryEncoder::rotated(int16_t steps, uint32_t now)
+{
+    auto eventType = (steps < 0) ? EventType::LEFT : EventType::RIGHT;
+    for(auto count = std::abs(steps); count; count--) {
+        event(eventType, now);
     }
-    _state = newState;
 }
 
 #endif
@@ -42,26 +42,73 @@ namespace PinMonitor {
         RotaryEncoderDirection _direction;
     };
 
+    // quadrature decoder for 2 pin rotary encoders
+    //
+    // each event is decoded with a 16 entry table indexed by the previous and current pin state. valid transitions
+    // move the position by one quarter step, transitions that change both pins are rejected and counted. a step is
+    // reported when the position returns to a detent, contact bounce between two states cancels itself out
+    //
+    // all steps decoded from one batch of events are passed to a single rotated() callback. the steps can be multiplied
+    // depending on the time between the steps, see setAcceleration()
     class RotaryEncoder {
     public:
         using EventType = RotaryEncoderEventType;
 
+        enum class StepMode : uint8_t {
+            FULL_STEP = 0,      // one step per cycle, detent at 00
+            HALF_STEP,          // two steps per cycle, detents at 00 and 11
+        };
+
+        // default time between two steps for the acceleration
+        static constexpr uint32_t kAccelerationIntervalDefault = 25000; // microseconds
+
     public:
-        RotaryEncoder(ActiveStateType state) :
+        RotaryEncoder(ActiveStateType state, StepMode mode = StepMode::FULL_STEP) :
             _activeState(state),
             _mask1(0),
             _mask2(0),
-            _state(0)
+            _lastStepTime(0),
+            _accelerationInterval(kAccelerationIntervalDefault),
+            _pendingTime(0),
+            _invalidTransitions(0),
+            _pendingSteps(0),
+            _mode(mode),
+            _state(0),
+            _position(0),
+            _lastDirection(0),
+            _accelerationMax(1)
         {
         }
         virtual ~RotaryEncoder() {}
 
+        // called for each step by the default implementation of rotated()
         virtual void event(EventType eventType, uint32_t now) {
             __DBG_panic("pure virtual call event_type=%u now=%u", eventType, now);
         }
 
+        // sum of the steps of a batch of events, positive values are steps to the right (clock wise)
+        // now is the time of the last step in microseconds
+        virtual void rotated(int16_t steps, uint32_t now);
+
         void attachPins(uint8_t pin1, uint8_t pin2);
+        // decode a single event and add the steps to the pending steps
         void processEvent(const Interrupt::Event &event);
+        // pass the pending steps to rotated()
+        void dispatchSteps();
+
+        // steps with less than interval microseconds in between and in the same direction as the previous step are
+        // multiplied by interval / time between the steps, up to maxFactor. a maxFactor of 1 disables the acceleration
+        void setAcceleration(uint8_t maxFactor, uint32_t interval = kAccelerationIntervalDefault);
+
+        void setStepMode(StepMode mode);
+        StepMode getStepMode() const;
+
+        // number of transitions where both pins changed. each one is caused by at least one missing event
+        uint32_t getInvalidTransitions() const;
+
+    private:
+        uint8_t _getValue(GPIOValueType values) const;
+        void _addSteps(int8_t steps, uint32_t now);
 
     public:
         friend HardwarePin;
@@ -69,9 +116,61 @@ namespace PinMonitor {
         ActiveStateType _activeState;
         GPIOMaskType _mask1;
         GPIOMaskType _mask2;
-        uint8_t _state;
+        uint32_t _lastStepTime;
+        uint32_t _accelerationInterval;
+        uint32_t _pendingTime;
+        uint32_t _invalidTransitions;
+        int16_t _pendingSteps;
+        StepMode _mode;
+        uint8_t _state;             // last value of the pins, bit 0 = pin1, bit 1 = pin2
+        int8_t _position;           // quarter steps since the last detent
+        int8_t _lastDirection;
+        uint8_t _accelerationMax;
     };
 
+    inline void RotaryEncoder::setAcceleration(uint8_t maxFactor, uint32_t interval)
+    {
+        _accelerationMax = std::max<uint8_t>(1, maxFactor);
+        _accelerationInterval = interval;
+    }
+
+    inline void RotaryEncoder::setStepMode(StepMode mode)
+    {
+        _mode = mode;
+        _position = 0;
+    }
+
+    inline RotaryEncoder::StepMode RotaryEncoder::getStepMode() const
+    {
+        return _mode;
+    }
+
+    inline uint32_t RotaryEncoder::getInvalidTransitions() const
+    {
+        return _invalidTransitions;
+    }
+
+    inline void RotaryEncoder::dispatchSteps()
+    {
+        if (_pendingSteps) {
+            auto steps = _pendingSteps;
+            _pendingSteps = 0;
+            rotated(steps, _pendingTime);
+        }
+    }
+
+    inline uint8_t RotaryEncoder::_getValue(GPIOValueType values) const
+    {
+        uint8_t value = (values & _mask1) ? 0b01 : 0b00;
+        if (values & _mask2) {
+            value |= 0b10;
+        }
+        if (_activeState == ActiveStateType::ACTIVE_LOW) {
+            value ^= 0b11;
+        }
+        return value;
+    }
+
 }
 
 #if DEBUG_PIN_MONITOR
@@ -0,0 +1,67 @@
+/**
+  Author: sascha_lammers@gmx.de
+*/
+
+#pragma once
+
+#include <Arduino_compat.h>
+#include <vector>
+
+// counters of the pin monitor, see Monitor::getStatistics() and PIN_MONITOR_STATISTICS
+
+namespace PinMonitor {
+
+    // time between the interrupt and processing the event in the main loop
+    struct LatencyHistogram {
+        static constexpr uint8_t kBuckets = 8;
+        // upper limits of the buckets in microseconds, the last bucket has no limit
+        static constexpr uint32_t kLimits[kBuckets - 1] = { 250, 500, 1000, 2000, 5000, 10000, 20000 };
+
+        uint32_t counts[kBuckets];
+        uint32_t max;               // microseconds
+
+        LatencyHistogram() : counts{}, max(0) {}
+
+        void add(uint32_t latency) {
+            uint8_t index = 0;
+            while(index < kBuckets - 1 && latency >= kLimits[index]) {
+                index++;
+            }
+            counts[index]++;
+            max = std::max(max, latency);
+        }
+
+        void clear() {
+            *this = LatencyHistogram();
+        }
+
+        uint32_t getCount() const {
+            uint32_t count = 0;
+            for(auto value: counts) {
+                count += value;
+            }
+            return count;
+        }
+    };
+
+    struct PinStatistics {
+        uint32_t interrupts;        // interrupts of the pin
+        uint32_t changes;           // debounced state changes
+        uint32_t bounces;           // interrupts that did not change the debounced state
+        uint8_t pin;
+        HardwarePinType type;
+    };
+
+    struct Statistics {
+        uint32_t interrupts;        // sum of all pins
+        uint32_t dropped;           // events dropped because the event queue was full
+        uint32_t bounces;           // sum of all pins
+        uint32_t loops;             // number of times the main loop has been executed
+        uint32_t maxLoopTime;       // longest execution time of the main loop in microseconds
+        LatencyHistogram latency;
+        std::vector<PinStatistics> pins;
+
+        Statistics() : interrupts(0), dropped(0), bounces(0), loops(0), maxLoopTime(0) {}
+    };
+
+}
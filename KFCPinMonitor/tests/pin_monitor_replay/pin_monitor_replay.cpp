@@ -0,0 +1,847 @@
+/**
+  Author: sascha_lammers@gmx.de
+*/
+
+// Host replay harness for the pin monitor
+//
+// feeds streams of Interrupt::Event through the pin monitor. for each event the simulated GPIO input register is set
+// to the value of the event and the interrupt handler of the pin is invoked at the time of the event. the main loop
+// is executed in fixed or random intervals between the events. time is simulated by Event::SimulatedClock, the
+// processing cost is the wall clock time of the interrupt handlers and the main loop divided by the number of events
+//
+// requires EVENT_SCHEDULER_SIMULATED_CLOCK=1, PIN_MONITOR_SIMULATED_GPIO=1, PIN_MONITOR_ROTARY_ENCODER_SUPPORT=1 and
+// PIN_MONITOR_USE_FUNCTIONAL_INTERRUPTS=1
+//
+// without arguments, streams are generated and checked. prints one JSON object per line and returns 0 if all checks
+// passed
+//
+// bounce: push button presses with contact bounce of up to 5ms on both edges. each press must be decoded as a single
+// DOWN and UP event
+// blocked_loop: short presses while the main loop is blocked for 100ms. each press must be reported as RISING followed
+// by RISING_BOUNCED. a long press is reported as HIGH and LOW
+// jitter: rotary encoder with random edge timing and changes of direction. the main loop is executed in random
+// intervals of up to 20ms. all steps must be decoded
+// rotation: rotary encoder at increasing speeds until the event queue overflows. the steps of each batch of events
+// are passed to a single callback
+// acceleration: slow rotation followed by fast rotation with acceleration enabled
+// gestures: clicks, hold, chord and press and rotate with bouncing buttons. requires PIN_MONITOR_GESTURES=1. each
+// gesture must be recognized once and no other gesture may fire. the latency is the time between the expected timeout
+// and the callback
+//
+// with PIN_MONITOR_STATISTICS=1, the bounce test checks the counters of the pin monitor. all interrupts that did not
+// change the debounced state are bounces
+//
+// {"test":"bounce","presses":200,"interrupts":2652,"down":200,"up":200,"errors":0,"max_latency_us":11999,"ns_per_event":16484.998,"stats":{...},"result":"OK"}
+// {"test":"blocked_loop","presses":20,"loop_ms":100,"rising":21,"rising_bounced":20,"high":1,"low":1,"errors":0,"result":"OK"}
+// {"test":"jitter","steps":2000,"reversals":36,"interrupts":8000,"right":952,"left":1048,"errors":0,"overflows":0,"callbacks":1413,"ns_per_event":454.233,"result":"OK"}
+// {"test":"rotation","steps_per_s":1000,"steps":2000,"interrupts":8000,"decoded":2000,"errors":0,"overflows":0,"callbacks":2000,"ns_per_event":421.425}
+// ...
+// {"test":"rotation","max_lossless_steps_per_s":8000,"result":"OK"}
+// {"test":"acceleration","steps":200,"right":1091,"left":0,"expected":1091,"callbacks":199,"result":"OK"}
+// {"test":"gestures","gestures":5,"transitions":24,"fired":"1,2,3,4,5,5,5,5,5","steps":1,"errors":0,"max_latency_ms":11,"result":"OK"}
+//
+// a captured stream is replayed if a file is passed. the decoded events are printed as JSON objects, followed by a
+// summary. lines of the capture file
+//
+// # comment
+// button <pin>                 attach push button, active high
+// encoder <pin1> <pin2>        attach rotary encoder, active high
+// loop <milliseconds>          interval of the main loop, default is 1
+// <micros> <pin> <GPI>         event, micros() and the GPIO input register in hex when the interrupt occurred
+//
+// the events must be sorted by time. the generated streams can be printed in this format with --dump
+//
+// {"time_us":1012000,"pin":4,"event":"DOWN"}
+// {"capture":"bounce.txt","interrupts":256,"decoded":60,"unknown_pins":0,"overflows":0,"ns_per_event":15424.656}
+//
+// usage: pin_monitor_replay [<capture file>|--dump bounce|jitter]
+
+#include <Arduino_compat.h>
+#include <EventScheduler.h>
+#include <SimulatedClock.h>
+#include <PinMonitor.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <host_test.h>
+
+#if !EVENT_SCHEDULER_SIMULATED_CLOCK
+#    error EVENT_SCHEDULER_SIMULATED_CLOCK=1 required
+#endif
+
+#if !PIN_MONITOR_SIMULATED_GPIO
+#    error PIN_MONITOR_SIMULATED_GPIO=1 required
+#endif
+
+#if !PIN_MONITOR_ROTARY_ENCODER_SUPPORT || !PIN_MONITOR_DEBOUNCED_PUSHBUTTON || !PIN_MONITOR_USE_FUNCTIONAL_INTERRUPTS
+#    error PIN_MONITOR_ROTARY_ENCODER_SUPPORT=1, PIN_MONITOR_DEBOUNCED_PUSHBUTTON=1 and PIN_MONITOR_USE_FUNCTIONAL_INTERRUPTS=1 required
+#endif
+
+using namespace PinMonitor;
+using Event::SimulatedClock::getMicros64;
+
+static constexpr uint8_t kButtonPin = 4;
+static constexpr uint8_t kButtonPin2 = 5;
+static constexpr uint8_t kEncoderPin1 = 12;
+static constexpr uint8_t kEncoderPin2 = 13;
+
+// minimum speed of the rotation test without lost steps
+static constexpr uint32_t kMinLosslessSpeed = 1000;
+
+using HostTest::result;
+
+// event passed to a handler
+struct Decoded {
+    uint64_t time;              // simulated microseconds
+    uint8_t pin;
+    uint16_t type;              // PushButtonEventType or RotaryEncoderEventType
+    bool encoder;
+
+    const char *getName() const {
+        if (encoder) {
+            return static_cast<RotaryEncoderEventType>(type) == RotaryEncoderEventType::RIGHT ? "RIGHT" : "LEFT";
+        }
+        return reinterpret_cast<const char *>(PushButton::eventTypeToString(static_cast<PushButtonEventType>(type)));
+    }
+};
+
+static std::vector<Decoded> decoded;
+static uint32_t rotatedCallbacks;
+
+#if PIN_MONITOR_GESTURES
+    // receives the steps of all encoders
+    static GestureEngine *gestureEngine;
+#endif
+
+class Button : public PushButton {
+public:
+    Button(uint8_t pin) : PushButton(pin, nullptr, PushButtonConfig(EventType::ALL), ActiveStateType::ACTIVE_HIGH) {}
+
+    virtual void event(EventType eventType, uint32_t now) override {
+        decoded.push_back(Decoded({getMicros64(), getPin(), static_cast<uint16_t>(eventType), false}));
+    }
+};
+
+// receives all states of the pin including the unstable ones
+class StateRecorder : public Pin {
+public:
+    StateRecorder(uint8_t pin, std::vector<StateType> &states) : Pin(pin, nullptr, StateType::ANY, ActiveStateType::ACTIVE_HIGH), _states(states) {}
+
+    virtual void event(StateType state, uint32_t now) override {
+        _states.push_back(state);
+    }
+
+private:
+    std::vector<StateType> &_states;
+};
+
+// owned by the pin monitor
+class Encoder : public RotaryEncoder {
+public:
+    Encoder(uint8_t pin) : RotaryEncoder(ActiveStateType::ACTIVE_HIGH), _pin(pin) {}
+
+    virtual void rotated(int16_t steps, uint32_t now) override {
+        rotatedCallbacks++;
+        #if PIN_MONITOR_GESTURES
+            if (gestureEngine) {
+                gestureEngine->rotate(_pin, steps, Event::millis());
+            }
+        #endif
+        RotaryEncoder::rotated(steps, now);
+    }
+
+    virtual void event(EventType eventType, uint32_t now) override {
+        decoded.push_back(Decoded({getMicros64(), _pin, static_cast<uint16_t>(eventType), true}));
+    }
+
+private:
+    uint8_t _pin;
+};
+
+// the time of the events is relative to the start of the stream
+using EventStream = std::vector<Interrupt::Event>;
+
+// creates an event stream from pin changes
+class StreamWriter {
+public:
+    StreamWriter() : _time(0), _levels(0) {}
+
+    void set(uint8_t pin, bool level) {
+        _levels = level ? (_levels | GPIO_PIN_TO_MASK(pin)) : (_levels & ~GPIO_PIN_TO_MASK(pin));
+        _stream.emplace_back(static_cast<uint32_t>(_time), pin, _levels);
+    }
+
+    void wait(uint64_t micros) {
+        _time += micros;
+    }
+
+    uint64_t getTime() const {
+        return _time;
+    }
+
+    EventStream &getStream() {
+        return _stream;
+    }
+
+private:
+    EventStream _stream;
+    uint64_t _time;
+    GPIOValueType _levels;
+};
+
+class Replay {
+public:
+    // the interval of the main loop is a random value between loopInterval and loopInterval + loopJitter
+    Replay(uint32_t loopInterval = 1000, uint32_t loopJitter = 0) :
+        _rng(1),
+        _loopInterval(loopInterval),
+        _loopJitter(loopJitter),
+        _nanos(0),
+        _interrupts(0),
+        _unknownPins(0)
+    {
+    }
+
+    // the pins must be attached before
+    void begin() {
+        decoded.clear();
+        rotatedCallbacks = 0;
+        GPIOSimulated::value = 0;
+        eventBuffer.clearOverflows();
+        _start = getMicros64();
+        _nextLoop = _start + _getLoopInterval();
+        pinMonitor.begin();
+        #if PIN_MONITOR_STATISTICS
+            pinMonitor.clearStatistics();
+        #endif
+    }
+
+    // run the main loop for idleMillis and remove all pins
+    void end(uint32_t idleMillis = 2000) {
+        _runUntil(getMicros64() + idleMillis * 1000ULL);
+        #if PIN_MONITOR_STATISTICS
+            pinMonitor.getStatistics(_statistics);
+        #endif
+        pinMonitor.end();
+    }
+
+    void run(const EventStream &stream) {
+        for(const auto &event: stream) {
+            _runUntil(_start + event.getTime());
+            GPIOSimulated::value = event.gpiRegValue();
+            auto pin = pinMonitor.getPin(event.pin());
+            if (!pin) {
+                _unknownPins++;
+                continue;
+            }
+            auto start = std::chrono::steady_clock::now();
+            HardwarePin::callback(pin);
+            _nanos += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            _interrupts++;
+        }
+    }
+
+    uint64_t getStart() const {
+        return _start;
+    }
+
+    uint32_t getInterrupts() const {
+        return _interrupts;
+    }
+
+    uint32_t getUnknownPins() const {
+        return _unknownPins;
+    }
+
+    double getNanosPerEvent() const {
+        return _interrupts ? (_nanos / _interrupts) : 0;
+    }
+
+    #if PIN_MONITOR_STATISTICS
+        // statistics of the pin monitor before end() removed the pins
+        const Statistics &getStatistics() const {
+            return _statistics;
+        }
+    #endif
+
+private:
+    void _runUntil(uint64_t time) {
+        while(_nextLoop <= time) {
+            Event::SimulatedClock::advance(_nextLoop - getMicros64());
+            auto start = std::chrono::steady_clock::now();
+            LoopFunctions::run();
+            Event::Scheduler::run();
+            _nanos += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            _nextLoop += _getLoopInterval();
+        }
+        Event::SimulatedClock::advance(time - getMicros64());
+    }
+
+    uint32_t _getLoopInterval() {
+        return _loopInterval + (_loopJitter ? (_rng() % (_loopJitter + 1)) : 0);
+    }
+
+private:
+    std::mt19937 _rng;
+    uint32_t _loopInterval;
+    uint32_t _loopJitter;
+    uint64_t _start;
+    uint64_t _nextLoop;
+    double _nanos;
+    uint32_t _interrupts;
+    uint32_t _unknownPins;
+    #if PIN_MONITOR_STATISTICS
+        Statistics _statistics;
+    #endif
+};
+
+// generators
+
+// toggles the pin for up to 5ms before it settles at level. returns the time of the last change
+static uint64_t bounce(StreamWriter &writer, std::mt19937 &rng, uint8_t pin, bool level)
+{
+    auto count = rng() % 12;
+    for(uint32_t i = 0; i < count; i++) {
+        writer.set(pin, (i % 2) ? !level : level);
+        writer.wait(20 + rng() % 400);
+    }
+    writer.set(pin, level);
+    return writer.getTime();
+}
+
+// times of the last change of each press are stored in settled
+static EventStream generateBounce(uint32_t presses, std::vector<uint64_t> &settled)
+{
+    std::mt19937 rng(1);
+    StreamWriter writer;
+    writer.wait(10000);
+    for(uint32_t i = 0; i < presses; i++) {
+        settled.push_back(bounce(writer, rng, kButtonPin, true));
+        writer.wait(80000 + rng() % 400000);
+        bounce(writer, rng, kButtonPin, false);
+        writer.wait(100000 + rng() % 800000);
+    }
+    return std::move(writer.getStream());
+}
+
+// quadrature signal of the encoder, pin1 leads pin2 for steps to the left
+// the time between two edges is edgeMicros +/- jitter percent
+static void rotate(StreamWriter &writer, std::mt19937 &rng, bool right, uint32_t steps, uint32_t edgeMicros, uint32_t jitter)
+{
+    static constexpr uint8_t kLeft[4][2] = { { kEncoderPin1, 1 }, { kEncoderPin2, 1 }, { kEncoderPin1, 0 }, { kEncoderPin2, 0 } };
+    static constexpr uint8_t kRight[4][2] = { { kEncoderPin2, 1 }, { kEncoderPin1, 1 }, { kEncoderPin2, 0 }, { kEncoderPin1, 0 } };
+    auto sequence = right ? kRight : kLeft;
+    for(uint32_t i = 0; i < steps; i++) {
+        for(uint8_t j = 0; j < 4; j++) {
+            writer.set(sequence[j][0], sequence[j][1]);
+            auto delay = edgeMicros;
+            if (jitter) {
+                auto range = edgeMicros * jitter / 100;
+                delay = delay - range + rng() % (2 * range + 1);
+            }
+            writer.wait(std::max<uint32_t>(1, delay));
+        }
+    }
+}
+
+static EventStream generateJitter(uint32_t steps, uint32_t &right, uint32_t &left, uint32_t &reversals)
+{
+    std::mt19937 rng(1);
+    StreamWriter writer;
+    writer.wait(10000);
+    right = 0;
+    left = 0;
+    reversals = 0;
+    bool direction = true;
+    while(right + left < steps) {
+        auto count = std::min<uint32_t>(steps - right - left, 1 + rng() % 100);
+        // 50 to 500 steps per second
+        rotate(writer, rng, direction, count, 500 + rng() % 4500, 40);
+        (direction ? right : left) += count;
+        direction = !direction;
+        reversals++;
+        writer.wait(50000 + rng() % 200000);
+    }
+    reversals--;
+    return std::move(writer.getStream());
+}
+
+static EventStream generateRotation(uint32_t steps, uint32_t stepsPerSecond)
+{
+    std::mt19937 rng(1);
+    StreamWriter writer;
+    writer.wait(10000);
+    rotate(writer, rng, true, steps, 1000000 / (stepsPerSecond * 4), 0);
+    return std::move(writer.getStream());
+}
+
+static void dumpStream(const EventStream &stream)
+{
+    for(const auto &event: stream) {
+        printf("%u %u %x\n", event.getTime(), event.pin(), static_cast<unsigned>(event.gpiRegValue()));
+    }
+}
+
+// tests
+
+static void testBounce(uint32_t presses)
+{
+    std::vector<uint64_t> settled;
+    auto stream = generateBounce(presses, settled);
+
+    pinMonitor.attach<Button>(kButtonPin);
+    Replay replay;
+    replay.begin();
+    replay.run(stream);
+    auto interrupts = replay.getInterrupts();
+    auto start = replay.getStart();
+    auto nanos = replay.getNanosPerEvent();
+    replay.end();
+
+    uint32_t down = 0;
+    uint32_t up = 0;
+    uint64_t maxLatency = 0;
+    uint32_t errors = 0;
+    for(const auto &event: decoded) {
+        switch(static_cast<PushButtonEventType>(event.type)) {
+            case PushButtonEventType::DOWN:
+                if (down < settled.size()) {
+                    auto time = start + settled[down];
+                    if (event.time < time) {
+                        errors++;
+                    }
+                    else {
+                        maxLatency = std::max(maxLatency, event.time - time);
+                    }
+                }
+                // DOWN and UP must alternate
+                if (down++ != up) {
+                    errors++;
+                }
+                break;
+            case PushButtonEventType::UP:
+                if (++up != down) {
+                    errors++;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    if (down != presses || up != presses) {
+        errors++;
+    }
+    #if PIN_MONITOR_STATISTICS
+        // all interrupts except one per state change are bounces
+        const auto &statistics = replay.getStatistics();
+        if (statistics.interrupts != interrupts || statistics.bounces != interrupts - presses * 2 || statistics.latency.getCount() == 0) {
+            errors++;
+        }
+        printf("{\"test\":\"bounce\",\"presses\":%u,\"interrupts\":%u,\"down\":%u,\"up\":%u,\"errors\":%u,\"max_latency_us\":%.0f,\"ns_per_event\":%.3f,"
+            "\"stats\":{\"interrupts\":%u,\"bounces\":%u,\"dropped\":%u,\"loops\":%u,\"max_loop_us\":%u,\"max_irq_latency_us\":%u},\"result\":\"%s\"}\n",
+            presses, interrupts, down, up, errors, maxLatency / 1.0, nanos,
+            statistics.interrupts, statistics.bounces, statistics.dropped, statistics.loops, statistics.maxLoopTime, statistics.latency.max, result(errors == 0)
+        );
+    #else
+        printf("{\"test\":\"bounce\",\"presses\":%u,\"interrupts\":%u,\"down\":%u,\"up\":%u,\"errors\":%u,\"max_latency_us\":%.0f,\"ns_per_event\":%.3f,\"result\":\"%s\"}\n",
+            presses, interrupts, down, up, errors, maxLatency / 1.0, nanos, result(errors == 0)
+        );
+    #endif
+}
+
+static void testBlockedLoop(uint32_t presses)
+{
+    static constexpr uint32_t kLoopMillis = 100;
+
+    // the main loop is executed at 100ms, 200ms, ... each press starts and ends between two loops
+    std::mt19937 rng(1);
+    StreamWriter writer;
+    writer.wait(130000);
+    for(uint32_t i = 0; i < presses; i++) {
+        bounce(writer, rng, kButtonPin, true);
+        writer.wait(20000);
+        bounce(writer, rng, kButtonPin, false);
+        writer.wait(200000 - (writer.getTime() - 130000) % 200000);
+    }
+    // longer than the debounce time, the blocked loop samples the pin only once per 100ms
+    writer.set(kButtonPin, true);
+    writer.wait(600000);
+    writer.set(kButtonPin, false);
+
+    std::vector<StateType> states;
+    pinMonitor.attach<StateRecorder>(kButtonPin, states);
+    Replay replay(kLoopMillis * 1000);
+    replay.begin();
+    replay.run(writer.getStream());
+    replay.end();
+
+    uint32_t rising = 0;
+    uint32_t risingBounced = 0;
+    uint32_t high = 0;
+    uint32_t low = 0;
+    uint32_t errors = 0;
+    for(const auto state: states) {
+        switch(state) {
+            case StateType::IS_RISING:
+                rising++;
+                break;
+            case StateType::RISING_BOUNCED:
+                // each bounce follows the start of a press
+                if (++risingBounced != rising) {
+                    errors++;
+                }
+                break;
+            case StateType::IS_HIGH:
+                high++;
+                break;
+            case StateType::IS_LOW:
+                low++;
+                break;
+            default:
+                break;
+        }
+    }
+    if (rising != presses + 1 || risingBounced != presses || high != 1 || low != 1) {
+        errors++;
+    }
+    printf("{\"test\":\"blocked_loop\",\"presses\":%u,\"loop_ms\":%u,\"rising\":%u,\"rising_bounced\":%u,\"high\":%u,\"low\":%u,\"errors\":%u,\"result\":\"%s\"}\n",
+        presses, kLoopMillis, rising, risingBounced, high, low, errors, result(errors == 0)
+    );
+}
+
+static void countSteps(uint32_t &right, uint32_t &left)
+{
+    right = 0;
+    left = 0;
+    for(const auto &event: decoded) {
+        if (event.encoder) {
+            if (static_cast<RotaryEncoderEventType>(event.type) == RotaryEncoderEventType::RIGHT) {
+                right++;
+            }
+            else {
+                left++;
+            }
+        }
+    }
+}
+
+static void testJitter(uint32_t steps)
+{
+    uint32_t expectedRight, expectedLeft, reversals;
+    auto stream = generateJitter(steps, expectedRight, expectedLeft, reversals);
+
+    (new Encoder(kEncoderPin1))->attachPins(kEncoderPin1, kEncoderPin2);
+    Replay replay(1000, 19000);
+    replay.begin();
+    replay.run(stream);
+    auto interrupts = replay.getInterrupts();
+    auto nanos = replay.getNanosPerEvent();
+    auto overflows = eventBuffer.getOverflows();
+    replay.end();
+
+    uint32_t right, left;
+    auto callbacks = rotatedCallbacks;
+    countSteps(right, left);
+    uint32_t errors = (std::max(right, expectedRight) - std::min(right, expectedRight)) + (std::max(left, expectedLeft) - std::min(left, expectedLeft));
+    printf("{\"test\":\"jitter\",\"steps\":%u,\"reversals\":%u,\"interrupts\":%u,\"right\":%u,\"left\":%u,\"errors\":%u,\"overflows\":%u,\"callbacks\":%u,\"ns_per_event\":%.3f,\"result\":\"%s\"}\n",
+        steps, reversals, interrupts, right, left, errors, overflows, callbacks, nanos, result(overflows == 0 && errors == 0)
+    );
+}
+
+static void testRotation(uint32_t steps)
+{
+    uint32_t maxLossless = 0;
+    for(uint32_t speed = 1000; speed <= 32000; speed *= 2) {
+        auto stream = generateRotation(steps, speed);
+
+        (new Encoder(kEncoderPin1))->attachPins(kEncoderPin1, kEncoderPin2);
+        Replay replay;
+        replay.begin();
+        replay.run(stream);
+        auto interrupts = replay.getInterrupts();
+        auto nanos = replay.getNanosPerEvent();
+        auto overflows = eventBuffer.getOverflows();
+        replay.end();
+
+        uint32_t right, left;
+        auto callbacks = rotatedCallbacks;
+        countSteps(right, left);
+        uint32_t errors = left + (steps - std::min(right, steps));
+        if (errors == 0 && overflows == 0) {
+            maxLossless = speed;
+        }
+        printf("{\"test\":\"rotation\",\"steps_per_s\":%u,\"steps\":%u,\"interrupts\":%u,\"decoded\":%u,\"errors\":%u,\"overflows\":%u,\"callbacks\":%u,\"ns_per_event\":%.3f}\n",
+            speed, steps, interrupts, right + left, errors, overflows, callbacks, nanos
+        );
+    }
+    printf("{\"test\":\"rotation\",\"max_lossless_steps_per_s\":%u,\"result\":\"%s\"}\n", maxLossless, result(maxLossless >= kMinLosslessSpeed));
+}
+
+static void testAcceleration(uint32_t steps)
+{
+    static constexpr uint8_t kMaxFactor = 10;
+    static constexpr uint32_t kInterval = 25000;
+
+    std::mt19937 rng(1);
+    StreamWriter writer;
+    writer.wait(10000);
+    // 20 steps/s, 50ms between steps
+    rotate(writer, rng, true, steps, 12500, 0);
+    // 400 steps/s, 2.5ms between steps
+    rotate(writer, rng, true, steps, 625, 0);
+
+    auto &encoder = *new Encoder(kEncoderPin1);
+    encoder.setAcceleration(kMaxFactor, kInterval);
+    encoder.attachPins(kEncoderPin1, kEncoderPin2);
+    Replay replay;
+    replay.begin();
+    replay.run(writer.getStream());
+    auto callbacks = rotatedCallbacks;
+    replay.end();
+
+    uint32_t right, left;
+    countSteps(right, left);
+    // the first fast step follows the last slow edge (12.5ms) and 3 fast edges, which is below the interval but
+    // less than twice as fast
+    uint32_t expected = steps + 1 + (steps - 1) * kMaxFactor;
+    printf("{\"test\":\"acceleration\",\"steps\":%u,\"right\":%u,\"left\":%u,\"expected\":%u,\"callbacks\":%u,\"result\":\"%s\"}\n",
+        steps * 2, right, left, expected, callbacks, result(left == 0 && right == expected)
+    );
+}
+
+#if PIN_MONITOR_GESTURES
+
+struct GestureFired {
+    uint8_t id;
+    int16_t value;
+    uint32_t time;
+};
+
+static void click(StreamWriter &writer, std::mt19937 &rng, uint8_t pin, uint32_t pressMillis, uint32_t releaseMillis)
+{
+    bounce(writer, rng, pin, true);
+    writer.wait(pressMillis * 1000);
+    bounce(writer, rng, pin, false);
+    writer.wait(releaseMillis * 1000);
+}
+
+static void testGestures()
+{
+    static constexpr uint16_t kMaxGapTime = 300;
+    static constexpr uint16_t kHoldTime = 1000;
+
+    std::vector<GestureFired> fired;
+    auto callback = [&fired](uint8_t id, int16_t value, uint32_t now) {
+        fired.push_back(GestureFired({id, value, now}));
+    };
+
+    GestureEngine engine;
+    engine.addClicks(1, kButtonPin, 1, callback, 250, kMaxGapTime);
+    engine.addClicks(2, kButtonPin, 2, callback, 250, kMaxGapTime);
+    engine.addHold(3, kButtonPin2, kHoldTime, callback);
+    engine.addChord(4, kButtonPin, kButtonPin2, callback);
+    engine.addPressAndRotate(5, kButtonPin2, kEncoderPin1, callback);
+    engine.attachPins(ActiveStateType::ACTIVE_HIGH);
+    gestureEngine = &engine;
+    (new Encoder(kEncoderPin1))->attachPins(kEncoderPin1, kEncoderPin2);
+
+    // time of the last release of the click gestures and the start of the hold gesture
+    std::vector<uint64_t> expected;
+    std::mt19937 rng(1);
+    StreamWriter writer;
+    writer.wait(10000);
+    // single click
+    click(writer, rng, kButtonPin, 100, 0);
+    expected.push_back(writer.getTime() + kMaxGapTime * 1000);
+    writer.wait(1000000);
+    // double click
+    click(writer, rng, kButtonPin, 100, 150);
+    click(writer, rng, kButtonPin, 100, 0);
+    expected.push_back(writer.getTime() + kMaxGapTime * 1000);
+    writer.wait(1000000);
+    // triple click
+    click(writer, rng, kButtonPin, 100, 150);
+    click(writer, rng, kButtonPin, 100, 150);
+    click(writer, rng, kButtonPin, 100, 1000);
+    // hold
+    bounce(writer, rng, kButtonPin2, true);
+    expected.push_back(writer.getTime() + kHoldTime * 1000);
+    writer.wait(1500000);
+    bounce(writer, rng, kButtonPin2, false);
+    writer.wait(1000000);
+    // chord, the button is pressed too long for a click
+    bounce(writer, rng, kButtonPin, true);
+    writer.wait(50000);
+    bounce(writer, rng, kButtonPin2, true);
+    writer.wait(400000);
+    bounce(writer, rng, kButtonPin, false);
+    bounce(writer, rng, kButtonPin2, false);
+    writer.wait(1000000);
+    // press and rotate, 3 steps to the right and 2 steps to the left at 20 steps per second
+    bounce(writer, rng, kButtonPin2, true);
+    writer.wait(100000);
+    auto rotateStart = writer.getTime();
+    rotate(writer, rng, true, 3, 12500, 0);
+    rotate(writer, rng, false, 2, 12500, 0);
+    auto rotateEnd = writer.getTime();
+    writer.wait(100000);
+    bounce(writer, rng, kButtonPin2, false);
+    writer.wait(1000000);
+    // rotate without pressing the button
+    rotate(writer, rng, true, 3, 12500, 0);
+
+    Replay replay;
+    replay.begin();
+    replay.run(writer.getStream());
+    auto start = replay.getStart();
+    replay.end();
+    gestureEngine = nullptr;
+
+    // the ids must fire in order, the press and rotate gesture once per batch
+    uint32_t errors = 0;
+    int32_t steps = 0;
+    uint32_t maxLatency = 0;
+    uint8_t lastId = 0;
+    uint32_t counts[6] = {};
+    String ids;
+    for(const auto &gesture: fired) {
+        counts[std::min<uint8_t>(gesture.id, 5)]++;
+        if (ids.length()) {
+            ids += ',';
+        }
+        ids += String(gesture.id);
+        if (gesture.id < lastId || (gesture.id == lastId && gesture.id != 5)) {
+            errors++;
+        }
+        lastId = gesture.id;
+        if (gesture.id == 5) {
+            steps += gesture.value;
+            // milliseconds like the other gestures
+            if (gesture.time < (start + rotateStart) / 1000 || gesture.time > (start + rotateEnd) / 1000 + 1) {
+                errors++;
+            }
+        }
+        else if (gesture.id != 4) {
+            auto time = (start + expected[gesture.id - 1]) / 1000;
+            if (gesture.time < time) {
+                errors++;
+            }
+            else {
+                maxLatency = std::max<uint32_t>(maxLatency, gesture.time - time);
+            }
+        }
+    }
+    for(uint8_t id = 1; id <= 4; id++) {
+        if (counts[id] != 1) {
+            errors++;
+        }
+    }
+    if (counts[0] || steps != 1) {
+        errors++;
+    }
+    printf("{\"test\":\"gestures\",\"gestures\":%u,\"transitions\":%u,\"fired\":\"%s\",\"steps\":%d,\"errors\":%u,\"max_latency_ms\":%u,\"result\":\"%s\"}\n",
+        static_cast<unsigned>(engine.size()), static_cast<unsigned>(engine.getTableSize()), ids.c_str(), steps, errors, maxLatency,
+        // the debounce time is the latency of the button events
+        result(errors == 0 && maxLatency <= pinMonitor.getDebounceTime() * 2U)
+    );
+}
+
+#endif
+
+// capture files
+
+static bool replayCapture(const char *filename)
+{
+    auto file = fopen(filename, "r");
+    if (!file) {
+        fprintf(stderr, "cannot open %s\n", filename);
+        return false;
+    }
+    EventStream stream;
+    uint32_t loopInterval = 1000;
+    bool first = true;
+    uint32_t firstTime = 0;
+    char line[256];
+    uint32_t lineNum = 0;
+    while(fgets(line, sizeof(line), file)) {
+        lineNum++;
+        unsigned pin1, pin2, value;
+        uint32_t time;
+        if (*line == '#' || *line == '\n' || *line == '\r') {
+            continue;
+        }
+        else if (sscanf(line, "button %u", &pin1) == 1) {
+            pinMonitor.attach<Button>(pin1);
+        }
+        else if (sscanf(line, "encoder %u %u", &pin1, &pin2) == 2) {
+            (new Encoder(pin1))->attachPins(pin1, pin2);
+        }
+        else if (sscanf(line, "loop %u", &value) == 1) {
+            loopInterval = value * 1000;
+        }
+        else if (sscanf(line, "%u %u %x", &time, &pin1, &value) == 3) {
+            if (first) {
+                first = false;
+                firstTime = time;
+            }
+            // start 10ms before the first event, micros() might have wrapped around
+            stream.emplace_back(time - firstTime + 10000, pin1, value);
+        }
+        else {
+            fprintf(stderr, "%s:%u: invalid line\n", filename, lineNum);
+            fclose(file);
+            return false;
+        }
+    }
+    fclose(file);
+
+    Replay replay(loopInterval);
+    replay.begin();
+    replay.run(stream);
+    auto overflows = eventBuffer.getOverflows();
+    replay.end();
+
+    for(const auto &event: decoded) {
+        printf("{\"time_us\":%.0f,\"pin\":%u,\"event\":\"%s\"}\n", (event.time - replay.getStart()) / 1.0, event.pin, event.getName());
+    }
+    printf("{\"capture\":\"%s\",\"interrupts\":%u,\"decoded\":%u,\"unknown_pins\":%u,\"overflows\":%u,\"ns_per_event\":%.3f}\n",
+        filename, replay.getInterrupts(), static_cast<unsigned>(decoded.size()), replay.getUnknownPins(), overflows, replay.getNanosPerEvent()
+    );
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    Event::SimulatedClock::reset();
+
+    if (argc > 2 && !strcmp(argv[1], "--dump")) {
+        uint32_t right, left, reversals;
+        std::vector<uint64_t> settled;
+        if (!strcmp(argv[2], "bounce")) {
+            printf("button %u\n", kButtonPin);
+            dumpStream(generateBounce(20, settled));
+        }
+        else {
+            printf("encoder %u %u\n", kEncoderPin1, kEncoderPin2);
+            dumpStream(generateJitter(200, right, left, reversals));
+        }
+        return 0;
+    }
+    if (argc > 1) {
+        return replayCapture(argv[1]) ? 0 : 1;
+    }
+
+    testBounce(200);
+    testBlockedLoop(20);
+    testJitter(2000);
+    testRotation(2000);
+    testAcceleration(100);
+    #if PIN_MONITOR_GESTURES
+        testGestures();
+    #endif
+
+    return HostTest::exitCode();
+}
@@ -0,0 +1,217 @@
+/**
+ * Author: sascha_lammers@gmx.de
+ */
+
+#pragma once
+
+#include "../stl_ext.h"
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+// default capacity in byte if not specified. it is at least the size of std::function to be able to store one
+#ifndef STL_EXT_INPLACE_FUNCTION_CAPACITY
+#    define STL_EXT_INPLACE_FUNCTION_CAPACITY (4 * sizeof(void *))
+#endif
+
+#pragma push_macro("new")
+#undef new
+
+namespace STL_STD_EXT_NAMESPACE_EX {
+
+    static constexpr size_t kInplaceFunctionDefaultCapacity = (sizeof(std::function<void()>) > (STL_EXT_INPLACE_FUNCTION_CAPACITY)) ?
+        sizeof(std::function<void()>) : (STL_EXT_INPLACE_FUNCTION_CAPACITY);
+
+    template<typename _Signature, size_t _Capacity = kInplaceFunctionDefaultCapacity, size_t _Alignment = alignof(std::max_align_t)>
+    class inplace_function;
+
+    // replacement for std::function that stores the callable object inside a fixed size buffer
+    //
+    // the object is never allocated on the heap. if a callable object does not fit into _Capacity, the
+    // compilation fails. calling the function uses a single indirect call without virtual dispatch
+    template<typename _Ret, typename... _Args, size_t _Capacity, size_t _Alignment>
+    class inplace_function<_Ret(_Args...), _Capacity, _Alignment> {
+    public:
+        using result_type = _Ret;
+        using storage_type = typename std::aligned_storage<_Capacity, _Alignment>::type;
+
+        static constexpr size_t capacity = _Capacity;
+
+    private:
+        template<typename _Tp>
+        using _is_callable = std::integral_constant<bool,
+            !std::is_same<_Tp, inplace_function>::value && !std::is_same<_Tp, std::nullptr_t>::value && std::is_invocable_r<_Ret, _Tp &, _Args...>::value
+        >;
+
+    public:
+
+        inplace_function() noexcept : _invoke(nullptr), _manage(nullptr) {}
+
+        inplace_function(std::nullptr_t) noexcept : _invoke(nullptr), _manage(nullptr) {}
+
+        template<typename _Fn, typename _Tp = typename std::decay<_Fn>::type, typename = typename std::enable_if<_is_callable<_Tp>::value>::type>
+        inplace_function(_Fn &&fn) : _invoke(nullptr), _manage(nullptr)
+        {
+            static_assert(sizeof(_Tp) <= _Capacity, "inplace_function: callable object exceeds the capacity");
+            static_assert(_Alignment % alignof(_Tp) == 0, "inplace_function: alignment of the callable object not supported");
+            if (_is_null(fn)) {
+                return;
+            }
+            ::new(static_cast<void *>(&_storage)) _Tp(std::forward<_Fn>(fn));
+            _invoke = &_invoke_fn<_Tp>;
+            _manage = &_manage_fn<_Tp>;
+        }
+
+        inplace_function(const inplace_function &fn) : _invoke(fn._invoke), _manage(fn._manage)
+        {
+            if (_manage) {
+                _manage(Operation::COPY, &_storage, const_cast<storage_type *>(&fn._storage));
+            }
+        }
+
+        inplace_function(inplace_function &&fn) noexcept : _invoke(fn._invoke), _manage(fn._manage)
+        {
+            if (_manage) {
+                _manage(Operation::MOVE, &_storage, &fn._storage);
+                fn._invoke = nullptr;
+                fn._manage = nullptr;
+            }
+        }
+
+        ~inplace_function() {
+            _destroy();
+        }
+
+        inplace_function &operator=(const inplace_function &fn) {
+            if (this != &fn) {
+                _destroy();
+                if (fn._manage) {
+                    fn._manage(Operation::COPY, &_storage, const_cast<storage_type *>(&fn._storage));
+                }
+                _invoke = fn._invoke;
+                _manage = fn._manage;
+            }
+            return *this;
+        }
+
+        inplace_function &operator=(inplace_function &&fn) noexcept {
+            if (this != &fn) {
+                _destroy();
+                if (fn._manage) {
+                    fn._manage(Operation::MOVE, &_storage, &fn._storage);
+                    _invoke = fn._invoke;
+                    _manage = fn._manage;
+                    fn._invoke = nullptr;
+                    fn._manage = nullptr;
+                }
+            }
+            return *this;
+        }
+
+        inplace_function &operator=(std::nullptr_t) noexcept {
+            _destroy();
+            return *this;
+        }
+
+        template<typename _Fn, typename _Tp = typename std::decay<_Fn>::type, typename = typename std::enable_if<_is_callable<_Tp>::value>::type>
+        inplace_function &operator=(_Fn &&fn) {
+            return *this = inplace_function(std::forward<_Fn>(fn));
+        }
+
+        _Ret operator()(_Args... args) const {
+            return _invoke(const_cast<storage_type *>(&_storage), std::forward<_Args>(args)...);
+        }
+
+        explicit operator bool() const noexcept {
+            return _invoke != nullptr;
+        }
+
+        bool operator==(std::nullptr_t) const noexcept {
+            return _invoke == nullptr;
+        }
+
+        bool operator!=(std::nullptr_t) const noexcept {
+            return _invoke != nullptr;
+        }
+
+        void swap(inplace_function &fn) noexcept {
+            inplace_function tmp(std::move(fn));
+            fn = std::move(*this);
+            *this = std::move(tmp);
+        }
+
+    private:
+        enum class Operation {
+            COPY,
+            MOVE,
+            DESTROY,
+        };
+
+        using InvokeFn = _Ret(*)(storage_type *storage, _Args&&... args);
+        using ManageFn = void(*)(Operation op, storage_type *dst, storage_type *src);
+
+        template<typename _Tp>
+        static _Ret _invoke_fn(storage_type *storage, _Args&&... args) {
+            return std::invoke(*reinterpret_cast<_Tp *>(storage), std::forward<_Args>(args)...);
+        }
+
+        template<typename _Tp>
+        static void _manage_fn(Operation op, storage_type *dst, storage_type *src) {
+            switch(op) {
+                case Operation::COPY:
+                    ::new(static_cast<void *>(dst)) _Tp(*reinterpret_cast<const _Tp *>(src));
+                    break;
+                case Operation::MOVE:
+                    ::new(static_cast<void *>(dst)) _Tp(std::move(*reinterpret_cast<_Tp *>(src)));
+                    reinterpret_cast<_Tp *>(src)->~_Tp();
+                    break;
+                case Operation::DESTROY:
+                    reinterpret_cast<_Tp *>(dst)->~_Tp();
+                    break;
+            }
+        }
+
+        void _destroy() {
+            if (_manage) {
+                _manage(Operation::DESTROY, &_storage, nullptr);
+                _invoke = nullptr;
+                _manage = nullptr;
+            }
+        }
+
+        // function pointers, member pointers and std::function can be empty
+        template<typename _Tp>
+        static bool _is_null(const _Tp &fn) {
+            return _is_null_impl(fn, 0);
+        }
+
+        template<typename _Tp>
+        static auto _is_null_impl(const _Tp &fn, int) -> decltype(fn == nullptr) {
+            return fn == nullptr;
+        }
+
+        template<typename _Tp>
+        static bool _is_null_impl(const _Tp &, long) {
+            return false;
+        }
+
+    private:
+        storage_type _storage;
+        InvokeFn _invoke;
+        ManageFn _manage;
+    };
+
+    template<typename _Signature, size_t _Capacity, size_t _Alignment>
+    inline bool operator==(std::nullptr_t, const inplace_function<_Signature, _Capacity, _Alignment> &fn) noexcept {
+        return !fn;
+    }
+
+    template<typename _Signature, size_t _Capacity, size_t _Alignment>
+    inline bool operator!=(std::nullptr_t, const inplace_function<_Signature, _Capacity, _Alignment> &fn) noexcept {
+        return static_cast<bool>(fn);
+    }
+
+}
+
+#pragma pop_macro("new")
@@ -0,0 +1,120 @@
+/**
+ * Author: sascha_lammers@gmx.de
+ */
+
+#pragma once
+
+#include "../stl_ext.h"
+#include <stdint.h>
+#include <atomic>
+#include <utility>
+
+namespace STL_STD_EXT_NAMESPACE_EX {
+
+    // bounded lock-free queue with multiple producers and a single consumer
+    //
+    // all storage is allocated inside the object. push() can be called from any context including interrupts
+    // if _Ta can be moved without allocating memory. pop() must be called from a single thread. the queue
+    // does not block, push() fails and increments the overflow counter if the queue is full
+    //
+    // each cell has a sequence number. a producer reserves a position by incrementing the write position and
+    // publishes the cell by setting the sequence to position + 1. the consumer releases the cell by setting the
+    // sequence to position + _Capacity
+    template<typename _Ta, size_t _Capacity>
+    class mpsc_ring_buffer {
+    public:
+        using value_type = _Ta;
+        using size_type = size_t;
+        using position_type = uint32_t;
+
+        static constexpr size_t capacity = _Capacity;
+        static constexpr position_type kMask = _Capacity - 1;
+
+        static_assert(_Capacity >= 2 && (_Capacity & (_Capacity - 1)) == 0, "capacity must be a power of 2");
+
+    public:
+        mpsc_ring_buffer() : _writePos(0), _readPos(0), _overflows(0) {
+            for(position_type i = 0; i < _Capacity; i++) {
+                _cells[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        mpsc_ring_buffer(const mpsc_ring_buffer &) = delete;
+        mpsc_ring_buffer &operator=(const mpsc_ring_buffer &) = delete;
+
+        // returns false if the queue is full
+        inline __attribute__((__always_inline__))
+        bool push(_Ta &&value) {
+            auto pos = _writePos.load(std::memory_order_relaxed);
+            Cell *cell;
+            for(;;) {
+                cell = &_cells[pos & kMask];
+                auto diff = static_cast<int32_t>(cell->sequence.load(std::memory_order_acquire) - pos);
+                if (diff == 0) {
+                    if (_writePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        break;
+                    }
+                }
+                else if (diff < 0) {
+                    _overflows.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+                else {
+                    pos = _writePos.load(std::memory_order_relaxed);
+                }
+            }
+            cell->value = std::move(value);
+            cell->sequence.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        inline __attribute__((__always_inline__))
+        bool push(const _Ta &value) {
+            return push(_Ta(value));
+        }
+
+        // returns false if the queue is empty or the next element has been reserved but not been published yet
+        bool pop(_Ta &value) {
+            auto &cell = _cells[_readPos & kMask];
+            if (static_cast<int32_t>(cell.sequence.load(std::memory_order_acquire) - (_readPos + 1)) < 0) {
+                return false;
+            }
+            value = std::move(cell.value);
+            // release captured objects
+            cell.value = _Ta();
+            cell.sequence.store(_readPos + _Capacity, std::memory_order_release);
+            _readPos++;
+            return true;
+        }
+
+        // number of reserved elements. the result is approximate if called while elements are added
+        size_type size() const {
+            return _writePos.load(std::memory_order_acquire) - _readPos;
+        }
+
+        bool empty() const {
+            return size() == 0;
+        }
+
+        // number of elements that have been dropped because the queue was full
+        uint32_t getOverflows() const {
+            return _overflows.load(std::memory_order_relaxed);
+        }
+
+        void clearOverflows() {
+            _overflows.store(0, std::memory_order_relaxed);
+        }
+
+    private:
+        struct Cell {
+            std::atomic<position_type> sequence;
+            _Ta value;
+        };
+
+        Cell _cells[_Capacity];
+        std::atomic<position_type> _writePos;
+        position_type _readPos;                 // consumer only
+        std::atomic<uint32_t> _overflows;
+    };
+
+}
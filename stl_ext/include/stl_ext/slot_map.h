@@ -0,0 +1,199 @@
+/**
+ * Author: sascha_lammers@gmx.de
+ */
+
+#pragma once
+
+#include "../stl_ext.h"
+#include <stdint.h>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace STL_STD_EXT_NAMESPACE_EX {
+
+    // key of an element in a slot_map
+    //
+    // the generation is incremented each time a slot is reused. keys of erased elements do not match any
+    // element that is inserted later into the same slot. generation 0 is never used
+    template<typename _Index = uint16_t, typename _Generation = _Index>
+    struct slot_map_key {
+        _Index index;
+        _Generation generation;
+
+        constexpr slot_map_key() : index(0), generation(0) {}
+        constexpr slot_map_key(_Index aIndex, _Generation aGeneration) : index(aIndex), generation(aGeneration) {}
+
+        constexpr bool operator==(const slot_map_key &key) const {
+            return index == key.index && generation == key.generation;
+        }
+
+        constexpr bool operator!=(const slot_map_key &key) const {
+            return !(*this == key);
+        }
+
+        constexpr explicit operator bool() const {
+            return generation != 0;
+        }
+    };
+
+    // container with O(1) insert, erase and lookup by key
+    //
+    // the elements are stored in a contiguous vector for fast iteration. erasing moves the last element into
+    // the position of the erased one, the order of the elements is not preserved. iterators and references
+    // are invalidated by insert and erase, keys stay valid until their element is erased
+    //
+    // a slot whose generation has wrapped around is retired and never reused, otherwise an old key would match
+    // the new element. a slot is retired after 2^N-1 reuses of an N bit generation
+    template<typename _Ta, typename _Index = uint16_t, typename _Generation = _Index>
+    class slot_map {
+    public:
+        using value_type = _Ta;
+        using key_type = slot_map_key<_Index, _Generation>;
+        using size_type = size_t;
+        using iterator = typename std::vector<_Ta>::iterator;
+        using const_iterator = typename std::vector<_Ta>::const_iterator;
+
+        static constexpr _Index kInvalidIndex = std::numeric_limits<_Index>::max();
+        static constexpr size_t kMaxSize = kInvalidIndex;
+
+    public:
+        slot_map() : _freeHead(kInvalidIndex) {}
+
+        template<typename... _Args>
+        key_type emplace(_Args&&... args) {
+            _Index slotIndex;
+            if (_freeHead != kInvalidIndex) {
+                slotIndex = _freeHead;
+                _freeHead = _slots[slotIndex].index;
+            }
+            else {
+                slotIndex = static_cast<_Index>(_slots.size());
+                _slots.emplace_back(0, 1);
+            }
+            auto &slot = _slots[slotIndex];
+            slot.index = static_cast<_Index>(_values.size());
+            _values.emplace_back(std::forward<_Args>(args)...);
+            _slotOfValue.push_back(slotIndex);
+            return key_type(slotIndex, slot.generation);
+        }
+
+        key_type insert(const _Ta &value) {
+            return emplace(value);
+        }
+
+        key_type insert(_Ta &&value) {
+            return emplace(std::move(value));
+        }
+
+        // returns false if the key is not valid
+        bool erase(key_type key) {
+            if (!contains(key)) {
+                return false;
+            }
+            auto &slot = _slots[key.index];
+            _Index pos = slot.index;
+            _Index last = static_cast<_Index>(_values.size() - 1);
+            if (pos != last) {
+                _values[pos] = std::move(_values[last]);
+                _slotOfValue[pos] = _slotOfValue[last];
+                _slots[_slotOfValue[pos]].index = pos;
+            }
+            _values.pop_back();
+            _slotOfValue.pop_back();
+            // invalidate all keys of this slot
+            if (++slot.generation == 0) {
+                // all generations have been used, retire the slot. it does not match any key
+                slot.index = kInvalidIndex;
+                return true;
+            }
+            slot.index = _freeHead;
+            _freeHead = key.index;
+            return true;
+        }
+
+        iterator erase(iterator iter) {
+            auto pos = std::distance(_values.begin(), iter);
+            erase(key_at(pos));
+            return _values.begin() + pos;
+        }
+
+        bool contains(key_type key) const {
+            return key.index < _slots.size() && key.generation != 0 && _slots[key.index].generation == key.generation;
+        }
+
+        // returns nullptr if the key is not valid
+        _Ta *find(key_type key) {
+            return contains(key) ? &_values[_slots[key.index].index] : nullptr;
+        }
+
+        const _Ta *find(key_type key) const {
+            return contains(key) ? &_values[_slots[key.index].index] : nullptr;
+        }
+
+        // key of the element at the given position
+        key_type key_at(size_type pos) const {
+            auto slotIndex = _slotOfValue[pos];
+            return key_type(slotIndex, _slots[slotIndex].generation);
+        }
+
+        _Ta &operator[](size_type pos) {
+            return _values[pos];
+        }
+
+        const _Ta &operator[](size_type pos) const {
+            return _values[pos];
+        }
+
+        size_type size() const {
+            return _values.size();
+        }
+
+        bool empty() const {
+            return _values.empty();
+        }
+
+        // keys of erased elements remain invalid
+        void clear() {
+            while(!_values.empty()) {
+                erase(key_at(_values.size() - 1));
+            }
+        }
+
+        void reserve(size_type size) {
+            _values.reserve(size);
+            _slotOfValue.reserve(size);
+            _slots.reserve(size);
+        }
+
+        iterator begin() {
+            return _values.begin();
+        }
+
+        iterator end() {
+            return _values.end();
+        }
+
+        const_iterator begin() const {
+            return _values.begin();
+        }
+
+        const_iterator end() const {
+            return _values.end();
+        }
+
+    private:
+        struct slot {
+            _Index index;           // position in _values or the next free slot
+            _Generation generation; // 0 if the slot has been retired
+
+            slot(_Index aIndex, _Generation aGeneration) : index(aIndex), generation(aGeneration) {}
+        };
+
+        std::vector<_Ta> _values;
+        std::vector<_Index> _slotOfValue;
+        std::vector<slot> _slots;
+        _Index _freeHead;
+    };
+
+}
@@ -0,0 +1,126 @@
+/**
+ * Author: sascha_lammers@gmx.de
+ */
+
+#pragma once
+
+#include "../stl_ext.h"
+#include <stdint.h>
+#include <atomic>
+#include <utility>
+
+namespace STL_STD_EXT_NAMESPACE_EX {
+
+    // bounded wait-free queue with a single producer and a single consumer
+    //
+    // all storage is allocated inside the object. the producer can be an interrupt handler, neither side
+    // disables interrupts or blocks. push() fails and increments the overflow counter if the queue is full,
+    // elements that have been queued already are not overwritten
+    //
+    // the write position is only modified by the producer, the read position only by the consumer. the
+    // positions are masked when an element is accessed, the difference is the number of queued elements. the
+    // overflow counter is only written by the producer, clearOverflows() stores the current value on the
+    // consumer side
+    template<typename _Ta, size_t _Capacity>
+    class spsc_ring_buffer {
+    public:
+        using value_type = _Ta;
+        using size_type = size_t;
+        using position_type = uint32_t;
+
+        static constexpr size_t capacity = _Capacity;
+        static constexpr position_type kMask = _Capacity - 1;
+
+        static_assert(_Capacity >= 2 && (_Capacity & (_Capacity - 1)) == 0, "capacity must be a power of 2");
+
+    public:
+        spsc_ring_buffer() : _writePos(0), _readPos(0), _overflows(0), _overflowsCleared(0) {}
+
+        spsc_ring_buffer(const spsc_ring_buffer &) = delete;
+        spsc_ring_buffer &operator=(const spsc_ring_buffer &) = delete;
+
+        // producer
+        // returns false if the queue is full
+        template<typename... _Args>
+        inline __attribute__((__always_inline__))
+        bool emplace(_Args&&... args) {
+            auto pos = _writePos.load(std::memory_order_relaxed);
+            if (pos - _readPos.load(std::memory_order_acquire) >= _Capacity) {
+                _overflows.store(_overflows.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                return false;
+            }
+            _values[pos & kMask] = _Ta(std::forward<_Args>(args)...);
+            _writePos.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        inline __attribute__((__always_inline__))
+        bool push(const _Ta &value) {
+            return emplace(value);
+        }
+
+        // consumer
+        // returns false if the queue is empty
+        bool pop(_Ta &value) {
+            auto pos = _readPos.load(std::memory_order_relaxed);
+            if (pos == _writePos.load(std::memory_order_acquire)) {
+                return false;
+            }
+            value = std::move(_values[pos & kMask]);
+            // release captured objects
+            _values[pos & kMask] = _Ta();
+            _readPos.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        // consumer
+        // invoke callback(_Ta &&value) for all elements that have been queued when the function was called. each
+        // element is released before its callback is invoked, the producer can use the space immediately.
+        // returns the number of elements
+        template<typename _Callback>
+        size_type consume(_Callback callback) {
+            auto pos = _readPos.load(std::memory_order_relaxed);
+            auto end = _writePos.load(std::memory_order_acquire);
+            size_type count = end - pos;
+            while(pos != end) {
+                _Ta value = std::move(_values[pos & kMask]);
+                _values[pos & kMask] = _Ta();
+                _readPos.store(++pos, std::memory_order_release);
+                callback(std::move(value));
+            }
+            return count;
+        }
+
+        // consumer
+        // remove all elements
+        void clear() {
+            consume([](_Ta &&) {});
+        }
+
+        size_type size() const {
+            return _writePos.load(std::memory_order_acquire) - _readPos.load(std::memory_order_acquire);
+        }
+
+        bool empty() const {
+            return size() == 0;
+        }
+
+        // number of elements that have been dropped because the queue was full
+        uint32_t getOverflows() const {
+            return _overflows.load(std::memory_order_relaxed) - _overflowsCleared;
+        }
+
+        // consumer
+        void clearOverflows() {
+            _overflowsCleared = _overflows.load(std::memory_order_relaxed);
+        }
+
+    private:
+        _Ta _values[_Capacity];
+        std::atomic<position_type> _writePos;       // producer only
+        std::atomic<position_type> _readPos;        // consumer only
+        std::atomic<uint32_t> _overflows;           // producer only
+        uint32_t _overflowsCleared;                 // consumer only
+    };
+
+}
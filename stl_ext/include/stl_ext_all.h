@@ -10,7 +10,11 @@
 #include "./stl_ext/array.h"
 #include "./stl_ext/is_trivially_copyable.h"
 #include "./stl_ext/memory.h"
+#include "./stl_ext/mpsc_ring_buffer.h"
+#include "./stl_ext/slot_map.h"
+#include "./stl_ext/spsc_ring_buffer.h"
 #include "./stl_ext/type_traits.h"
+#include "./stl_ext/inplace_function.h"
 #include "./stl_ext/iterator.h"
 #include "./stl_ext/utility.h"
 #include "./stl_ext/vector.h"
@@ -0,0 +1,155 @@
+/**
+ * Author: sascha_lammers@gmx.de
+ */
+
+// Host benchmark for stdex::inplace_function and std::function
+//
+// Measures construction, copy and call overhead for lambdas with different capture sizes and prints one
+// JSON object per line
+//
+// {"type":"inplace_function","capture":16,"op":"construct","iterations":1000000,"ns_per_op":1.234,"allocs":0,"allocs_per_op":0.000}
+//
+// allocations are counted by replacing the global operator new/delete
+//
+// usage: inplace_function_benchmark [iterations]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <chrono>
+#include <functional>
+#include <new>
+#include <stl_ext/inplace_function.h>
+
+namespace AllocStats {
+
+    static size_t count;
+
+    void reset()
+    {
+        count = 0;
+    }
+
+}
+
+void *operator new(size_t size)
+{
+    AllocStats::count++;
+    auto ptr = malloc(size ? size : 1);
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void operator delete(void *ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+    free(ptr);
+}
+
+// the capacity is large enough for all captures used in this benchmark
+using InplaceFunction = stdex::inplace_function<uint32_t(uint32_t), 32>;
+using StdFunction = std::function<uint32_t(uint32_t)>;
+
+static volatile uint32_t sink;
+
+template<size_t _Size>
+struct Capture {
+    uint32_t values[_Size / sizeof(uint32_t)];
+
+    Capture() {
+        for(auto &value: values) {
+            value = sink + 1;
+        }
+    }
+};
+
+template<size_t _Size>
+auto createLambda()
+{
+    Capture<_Size> capture;
+    return [capture](uint32_t value) {
+        return value + capture.values[0];
+    };
+}
+
+template<>
+auto createLambda<0>()
+{
+    return [](uint32_t value) {
+        return value + 1;
+    };
+}
+
+template<typename _Fn>
+void report(const char *type, size_t capture, const char *op, size_t iterations, _Fn fn)
+{
+    AllocStats::reset();
+    auto start = std::chrono::high_resolution_clock::now();
+    fn();
+    auto end = std::chrono::high_resolution_clock::now();
+    auto allocs = AllocStats::count;
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    printf("{\"type\":\"%s\",\"capture\":%u,\"op\":\"%s\",\"iterations\":%u,\"ns_per_op\":%.3f,\"allocs\":%u,\"allocs_per_op\":%.3f}\n",
+        type, static_cast<unsigned>(capture), op, static_cast<unsigned>(iterations), ns / iterations, static_cast<unsigned>(allocs), allocs / static_cast<double>(iterations)
+    );
+}
+
+template<typename _Function, size_t _Size>
+void run(const char *type, size_t iterations)
+{
+    // create and destroy the function object
+    report(type, _Size, "construct", iterations, [iterations]() {
+        for(size_t i = 0; i < iterations; i++) {
+            _Function fn = createLambda<_Size>();
+            sink = sink + fn(static_cast<uint32_t>(i));
+        }
+    });
+
+    // copy the function object, like passing it by value to Scheduler::add()
+    _Function source = createLambda<_Size>();
+    report(type, _Size, "copy", iterations, [iterations, &source]() {
+        for(size_t i = 0; i < iterations; i++) {
+            _Function fn = source;
+            sink = sink + fn(static_cast<uint32_t>(i));
+        }
+    });
+
+    // invoke the stored function object
+    _Function fn = createLambda<_Size>();
+    report(type, _Size, "call", iterations, [iterations, &fn]() {
+        uint32_t value = 0;
+        for(size_t i = 0; i < iterations; i++) {
+            value = fn(value);
+        }
+        sink = value;
+    });
+}
+
+template<size_t _Size>
+void runAll(size_t iterations)
+{
+    run<StdFunction, _Size>("std::function", iterations);
+    run<InplaceFunction, _Size>("inplace_function", iterations);
+}
+
+int main(int argc, const char **argv)
+{
+    size_t iterations = 1000000;
+    if (argc > 1) {
+        iterations = strtoul(argv[1], nullptr, 10);
+    }
+    printf("{\"sizeof_std_function\":%u,\"sizeof_inplace_function\":%u}\n", static_cast<unsigned>(sizeof(StdFunction)), static_cast<unsigned>(sizeof(InplaceFunction)));
+
+    runAll<0>(iterations);
+    runAll<4>(iterations);
+    runAll<8>(iterations);
+    runAll<16>(iterations);
+    runAll<24>(iterations);
+    return 0;
+}
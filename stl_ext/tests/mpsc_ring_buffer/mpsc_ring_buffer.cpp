@@ -0,0 +1,129 @@
+/**
+ * Author: sascha_lammers@gmx.de
+ */
+
+// Host test for stdex::mpsc_ring_buffer
+//
+// multiple producer threads push sequence numbers while a single consumer pops them. each producer counts the
+// failed pushes. the consumer verifies that the values of each producer are received in order and that no value
+// is lost or received twice. the second test stores inplace functions and verifies that captured objects are
+// released after pop()
+//
+// prints one JSON object per line and returns 0 if all checks passed
+//
+// {"test":"threads","producers":4,"pushed":400000,"popped":400000,"overflows":12345,"errors":0,"ns_per_op":85.000,"result":"OK"}
+// {"test":"functions","calls":64,"overflows":32,"live_objects":0,"errors":0,"result":"OK"}
+//
+// usage: mpsc_ring_buffer [values per producer]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <stl_ext/inplace_function.h>
+#include <stl_ext/mpsc_ring_buffer.h>
+#include <host_test.h>
+
+using HostTest::result;
+
+static void testThreads(uint32_t producers, uint32_t values)
+{
+    // producer index in the upper 8 bit
+    using Queue = stdex::mpsc_ring_buffer<uint32_t, 64>;
+    static Queue queue;
+
+    std::vector<uint32_t> failedPushes(producers);
+    std::vector<uint32_t> next(producers);
+    std::vector<std::thread> threads;
+    uint32_t popped = 0;
+    uint32_t errors = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for(uint32_t i = 0; i < producers; i++) {
+        threads.emplace_back([i, values, &failedPushes]() {
+            for(uint32_t n = 0; n < values; n++) {
+                while(!queue.push((i << 24) | n)) {
+                    failedPushes[i]++;
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    while(popped < producers * values) {
+        uint32_t value;
+        if (!queue.pop(value)) {
+            std::this_thread::yield();
+            continue;
+        }
+        auto producer = value >> 24;
+        if (producer >= producers || next[producer] != (value & 0xffffff)) {
+            errors++;
+        }
+        else {
+            next[producer]++;
+        }
+        popped++;
+    }
+    for(auto &thread: threads) {
+        thread.join();
+    }
+    auto nanos = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    uint32_t overflows = 0;
+    for(auto count: failedPushes) {
+        overflows += count;
+    }
+    uint32_t value;
+    if (queue.pop(value) || !queue.empty() || queue.getOverflows() != overflows) {
+        errors++;
+    }
+    printf("{\"test\":\"threads\",\"producers\":%u,\"pushed\":%u,\"popped\":%u,\"overflows\":%u,\"errors\":%u,\"ns_per_op\":%.3f,\"result\":\"%s\"}\n",
+        producers, producers * values, popped, overflows, errors, nanos / popped, result(errors == 0)
+    );
+}
+
+static void testFunctions()
+{
+    using Function = stdex::inplace_function<void()>;
+    using Queue = stdex::mpsc_ring_buffer<Function, 32>;
+
+    Queue queue;
+    auto object = std::make_shared<uint32_t>(0);
+    uint32_t errors = 0;
+    uint32_t calls = 0;
+    for(uint32_t round = 0; round < 2; round++) {
+        for(uint32_t i = 0; i < 48; i++) {
+            bool success = queue.push([object, &calls]() {
+                (*object)++;
+                calls++;
+            });
+            if (success != (i < 32)) {
+                errors++;
+            }
+        }
+        Function fn;
+        while(queue.pop(fn)) {
+            fn();
+        }
+        fn = nullptr;
+    }
+    if (*object != calls || queue.getOverflows() != 32) {
+        errors++;
+    }
+    // only the local copy is left
+    auto liveObjects = object.use_count() - 1;
+    printf("{\"test\":\"functions\",\"calls\":%u,\"overflows\":%u,\"live_objects\":%u,\"errors\":%u,\"result\":\"%s\"}\n",
+        calls, queue.getOverflows(), static_cast<unsigned>(liveObjects), errors, result(errors == 0 && liveObjects == 0 && calls == 64)
+    );
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t values = (argc > 1) ? static_cast<uint32_t>(atol(argv[1])) : 100000;
+    testThreads(4, values);
+    testFunctions();
+    return HostTest::exitCode();
+}
@@ -0,0 +1,124 @@
+/**
+ * Author: sascha_lammers@gmx.de
+ */
+
+// Host test for stdex::spsc_ring_buffer
+//
+// a producer thread pushes sequence numbers while the consumer drains them in batches with consume(). the
+// consumer verifies that the values are received in order and that no value is lost or received twice. the
+// second test fills the queue without a consumer and verifies that queued elements are not overwritten and
+// that the dropped elements are counted
+//
+// prints one JSON object per line and returns 0 if all checks passed
+//
+// {"test":"threads","pushed":1000000,"popped":1000000,"batches":15625,"max_batch":64,"overflows":15625,"errors":0,"ns_per_op":55.481,"result":"OK"}
+// {"test":"overflow","capacity":16,"pushed":40,"popped":16,"overflows":24,"errors":0,"result":"OK"}
+//
+// usage: spsc_ring_buffer [values]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <stl_ext/spsc_ring_buffer.h>
+#include <host_test.h>
+
+using HostTest::result;
+
+static void testThreads(uint32_t values)
+{
+    using Queue = stdex::spsc_ring_buffer<uint32_t, 64>;
+    static Queue queue;
+
+    uint32_t failedPushes = 0;
+    uint32_t popped = 0;
+    uint32_t batches = 0;
+    size_t maxBatch = 0;
+    uint32_t errors = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    std::thread producer([values, &failedPushes]() {
+        for(uint32_t n = 0; n < values; n++) {
+            while(!queue.push(n)) {
+                failedPushes++;
+                std::this_thread::yield();
+            }
+        }
+    });
+    while(popped < values) {
+        auto count = queue.consume([&popped, &errors](uint32_t &&value) {
+            if (value != popped) {
+                errors++;
+            }
+            popped++;
+        });
+        if (count == 0) {
+            std::this_thread::yield();
+            continue;
+        }
+        batches++;
+        maxBatch = std::max(maxBatch, count);
+    }
+    producer.join();
+    auto nanos = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    uint32_t value;
+    if (queue.pop(value) || !queue.empty() || queue.getOverflows() != failedPushes || maxBatch > Queue::capacity) {
+        errors++;
+    }
+    printf("{\"test\":\"threads\",\"pushed\":%u,\"popped\":%u,\"batches\":%u,\"max_batch\":%u,\"overflows\":%u,\"errors\":%u,\"ns_per_op\":%.3f,\"result\":\"%s\"}\n",
+        values, popped, batches, static_cast<unsigned>(maxBatch), failedPushes, errors, nanos / popped, result(errors == 0)
+    );
+}
+
+static void testOverflow()
+{
+    using Queue = stdex::spsc_ring_buffer<uint32_t, 16>;
+
+    Queue queue;
+    uint32_t errors = 0;
+    uint32_t pushed = 40;
+    for(uint32_t i = 0; i < pushed; i++) {
+        if (queue.push(i) != (i < Queue::capacity)) {
+            errors++;
+        }
+    }
+    auto overflows = queue.getOverflows();
+    if (queue.size() != Queue::capacity || overflows != pushed - Queue::capacity) {
+        errors++;
+    }
+    // the oldest elements are kept
+    uint32_t popped = 0;
+    uint32_t value;
+    while(queue.pop(value)) {
+        if (value != popped) {
+            errors++;
+        }
+        popped++;
+    }
+    queue.clearOverflows();
+    if (queue.getOverflows() != 0) {
+        errors++;
+    }
+    // the positions wrap around after the queue has been drained
+    for(uint32_t i = 0; i < 10; i++) {
+        queue.push(i);
+    }
+    queue.clear();
+    if (!queue.empty() || !queue.push(100) || !queue.pop(value) || value != 100) {
+        errors++;
+    }
+    printf("{\"test\":\"overflow\",\"capacity\":%u,\"pushed\":%u,\"popped\":%u,\"overflows\":%u,\"errors\":%u,\"result\":\"%s\"}\n",
+        static_cast<unsigned>(Queue::capacity), pushed, popped, overflows, errors, result(errors == 0 && popped == Queue::capacity)
+    );
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t values = (argc > 1) ? static_cast<uint32_t>(atol(argv[1])) : 1000000;
+    testThreads(values);
+    testOverflow();
+    return HostTest::exitCode();
+}
@@ -0,0 +1,32 @@
+/**
+  Author: sascha_lammers@gmx.de
+*/
+
+#pragma once
+
+// result of the host tests
+//
+// the tests print one JSON object per line with "result":"OK" or "result":"FAILED" and main() returns exitCode()
+//
+// printf("{\"test\":\"name\",\"errors\":%u,\"result\":\"%s\"}\n", errors, HostTest::result(errors == 0));
+// return HostTest::exitCode();
+
+namespace HostTest {
+
+    inline bool failed = false;
+
+    // returns the value of the result field and marks the test as failed if success is false
+    inline const char *result(bool success)
+    {
+        if (!success) {
+            failed = true;
+        }
+        return success ? "OK" : "FAILED";
+    }
+
+    inline int exitCode()
+    {
+        return failed ? 1 : 0;
+    }
+
+}
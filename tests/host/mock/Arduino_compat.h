@@ -0,0 +1,460 @@
+/**
+  Author: sascha_lammers@gmx.de
+*/
+
+// minimal Arduino API for host builds of the libraries
+//
+// time is simulated. micros() and millis() return mock_micros, which is advanced by mock_advance() together with the
+// SDK timers in osapi.h. the GPIO input registers are mock_GPI and mock_GP16I
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdarg.h>
+#include <ctype.h>
+#include <math.h>
+#include <limits.h>
+#include <time.h>
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <memory>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+// PROGMEM
+
+#define PROGMEM
+#define PGM_P                       const char *
+#define PSTR(s)                     (s)
+#define F(s)                        reinterpret_cast<const __FlashStringHelper *>(s)
+#define FPSTR(s)                    reinterpret_cast<const __FlashStringHelper *>(s)
+#define RFPSTR(s)                   reinterpret_cast<const char *>(s)
+#define FSPGM(name)                 F(#name)
+#define SPGM(name)                  #name
+#define pgm_read_byte(p)            (*reinterpret_cast<const uint8_t *>(p))
+#define pgm_read_dword(p)           (*reinterpret_cast<const uint32_t *>(p))
+#define memcpy_P                    memcpy
+#define strlen_P                    strlen
+#define strcmp_P                    strcmp
+#define strcmp_P_P                  strcmp
+#define strcpy_P                    strcpy
+#define strcasecmp_P                strcasecmp
+#define strncmp_P                   strncmp
+#define snprintf_P                  snprintf
+#define vsnprintf_P                 vsnprintf
+#define sprintf_P                   sprintf
+#define is_HEAP_P(p)                false
+#define IRAM_ATTR
+#define ICACHE_FLASH_ATTR
+#define ICACHE_RAM_ATTR
+
+class __FlashStringHelper;
+
+inline size_t strftime_P(char *buf, size_t size, const char *format, const struct tm *tm)
+{
+    return strftime(buf, size, format, tm);
+}
+
+inline char *strdup_P(const char *str)
+{
+    return strdup(str);
+}
+
+// ESP8266 core, the number is written to the end of the buffer. returns a pointer to the first character or nullptr
+// if the buffer is too small
+inline char *ulltoa(unsigned long long value, char *str, int size, unsigned int radix)
+{
+    int pos = size - 1;
+    str[pos] = 0;
+    do {
+        if (--pos < 0) {
+            return nullptr;
+        }
+        auto digit = value % radix;
+        str[pos] = digit < 10 ? '0' + digit : 'a' + digit - 10;
+        value /= radix;
+    } while(value);
+    return &str[pos];
+}
+
+inline char *lltoa(long long value, char *str, int size, unsigned int radix)
+{
+    auto ptr = ulltoa(value < 0 ? 0ULL - value : value, str, size, radix);
+    if (ptr && value < 0) {
+        if (ptr == str) {
+            return nullptr;
+        }
+        *--ptr = '-';
+    }
+    return ptr;
+}
+
+// String
+
+class String : public std::string {
+public:
+    String() {}
+    String(const char *str) : std::string(str ? str : "") {}
+    String(const std::string &str) : std::string(str) {}
+    String(const __FlashStringHelper *str) : std::string(reinterpret_cast<const char *>(str)) {}
+    String(char ch) : std::string(1, ch) {}
+    String(int value) : std::string(std::to_string(value)) {}
+    String(unsigned value) : std::string(std::to_string(value)) {}
+    String(long value) : std::string(std::to_string(value)) {}
+    String(unsigned long value) : std::string(std::to_string(value)) {}
+    String(double value, int digits = 2) {
+        char buf[64];
+        snprintf(buf, sizeof(buf), "%.*f", digits, value);
+        assign(buf);
+    }
+
+    bool reserve(size_t size) {
+        std::string::reserve(size);
+        return true;
+    }
+
+    String &operator+=(const String &str) {
+        append(str);
+        return *this;
+    }
+    String &operator+=(const char *str) {
+        append(str);
+        return *this;
+    }
+    String &operator+=(const __FlashStringHelper *str) {
+        append(reinterpret_cast<const char *>(str));
+        return *this;
+    }
+    String &operator+=(char ch) {
+        push_back(ch);
+        return *this;
+    }
+    String &operator+=(int value) {
+        append(std::to_string(value));
+        return *this;
+    }
+    String &operator+=(unsigned value) {
+        append(std::to_string(value));
+        return *this;
+    }
+
+    bool concat(const char *str, size_t len) {
+        append(str, len);
+        return true;
+    }
+    bool concat(char ch) {
+        push_back(ch);
+        return true;
+    }
+
+    long toInt() const {
+        return atol(c_str());
+    }
+    float toFloat() const {
+        return atof(c_str());
+    }
+    void trim() {
+        while(size() && isspace(back())) {
+            pop_back();
+        }
+        while(size() && isspace(front())) {
+            erase(0, 1);
+        }
+    }
+    bool equals(const String &str) const {
+        return *this == str;
+    }
+    bool equals(const char *str) const {
+        return compare(str) == 0;
+    }
+    bool equalsIgnoreCase(const String &str) const {
+        return strcasecmp(c_str(), str.c_str()) == 0;
+    }
+    void remove(size_t index, size_t count) {
+        erase(index, count);
+    }
+    void remove(size_t index) {
+        erase(index);
+    }
+    const char *begin() const {
+        return c_str();
+    }
+    const char *end() const {
+        return c_str() + length();
+    }
+    char *begin() {
+        return &(*this)[0];
+    }
+    char *end() {
+        return &(*this)[0] + length();
+    }
+    int indexOf(char ch) const {
+        auto pos = find(ch);
+        return pos == npos ? -1 : static_cast<int>(pos);
+    }
+    String substring(size_t from) const {
+        return String(substr(from));
+    }
+    String substring(size_t from, size_t to) const {
+        return String(substr(from, to - from));
+    }
+    bool startsWith(const String &str) const {
+        return compare(0, str.size(), str) == 0;
+    }
+    void toLowerCase() {
+        for(auto &ch: *this) {
+            ch = tolower(ch);
+        }
+    }
+};
+
+inline String operator+(const String &a, const String &b)
+{
+    String str(a);
+    str += b;
+    return str;
+}
+
+inline String operator+(const String &a, const char *b)
+{
+    String str(a);
+    str += b;
+    return str;
+}
+
+inline String operator+(const char *a, const String &b)
+{
+    String str(a);
+    str += b;
+    return str;
+}
+
+inline String operator+(char a, const String &b)
+{
+    String str(a);
+    str += b;
+    return str;
+}
+
+extern String emptyString;
+
+// Print and Stream
+
+class Print;
+
+class Printable {
+public:
+    virtual ~Printable() {}
+    virtual size_t printTo(Print &output) const = 0;
+};
+
+class Print {
+public:
+    virtual ~Print() {}
+
+    virtual size_t write(uint8_t data) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t len) {
+        size_t written = 0;
+        while(len--) {
+            written += write(*buffer++);
+        }
+        return written;
+    }
+    size_t write(const char *str) {
+        return write(reinterpret_cast<const uint8_t *>(str), strlen(str));
+    }
+    size_t write(const char *buffer, size_t len) {
+        return write(reinterpret_cast<const uint8_t *>(buffer), len);
+    }
+
+    size_t print(const char *str) {
+        return write(str);
+    }
+    size_t print(const String &str) {
+        return write(str.c_str(), str.length());
+    }
+    size_t print(const __FlashStringHelper *str) {
+        return write(reinterpret_cast<const char *>(str));
+    }
+    size_t print(char ch) {
+        return write(static_cast<uint8_t>(ch));
+    }
+    size_t print(int value) {
+        return print(String(std::to_string(value)));
+    }
+    size_t print(unsigned value) {
+        return print(String(std::to_string(value)));
+    }
+    size_t print(long value) {
+        return print(String(std::to_string(value)));
+    }
+    size_t print(unsigned long value) {
+        return print(String(std::to_string(value)));
+    }
+    size_t print(long long value) {
+        return print(String(std::to_string(value)));
+    }
+    size_t print(unsigned long long value) {
+        return print(String(std::to_string(value)));
+    }
+    size_t print(double value, int digits = 2) {
+        char buf[64];
+        snprintf(buf, sizeof(buf), "%.*f", digits, value);
+        return print(buf);
+    }
+    size_t print(const Printable &printable) {
+        return printable.printTo(*this);
+    }
+    size_t println(const char *str = "") {
+        return print(str) + print('\n');
+    }
+    size_t println(const String &str) {
+        return print(str) + print('\n');
+    }
+
+    size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3))) {
+        va_list arg;
+        va_start(arg, format);
+        auto len = _vprintf(format, arg);
+        va_end(arg);
+        return len;
+    }
+    size_t printf_P(const char *format, ...) {
+        va_list arg;
+        va_start(arg, format);
+        auto len = _vprintf(format, arg);
+        va_end(arg);
+        return len;
+    }
+
+private:
+    size_t _vprintf(const char *format, va_list arg) {
+        char buf[1024];
+        int len = vsnprintf(buf, sizeof(buf), format, arg);
+        if (len < 0) {
+            return 0;
+        }
+        return write(buf, std::min<size_t>(len, sizeof(buf) - 1));
+    }
+};
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+    virtual void flush() {}
+};
+
+class StdoutPrint : public Print {
+public:
+    virtual size_t write(uint8_t data) override {
+        putchar(data);
+        return 1;
+    }
+    using Print::write;
+};
+
+extern StdoutPrint Serial;
+
+#define DEBUG_OUTPUT                Serial
+#define _VT100(name)                ""
+#define __S(str)                    ((str) ? (str) : "")
+
+// time
+
+extern uint64_t mock_micros;
+
+inline unsigned long micros()
+{
+    return static_cast<uint32_t>(mock_micros);
+}
+
+inline unsigned long millis()
+{
+    return static_cast<uint32_t>(mock_micros / 1000);
+}
+
+inline void delay(unsigned long)
+{
+}
+
+inline void yield()
+{
+}
+
+inline void optimistic_yield(uint32_t)
+{
+}
+
+#include "osapi.h"
+#include "debug_helper.h"
+#include "misc.h"
+
+// GPIO
+
+#define NUM_DIGITAL_PINS            17
+#define INPUT                       0
+#define OUTPUT                      1
+#define INPUT_PULLUP                2
+#define RISING                      1
+#define FALLING                     2
+#define CHANGE                      3
+
+#ifndef _BV
+#    define _BV(bit)                (1UL << (bit))
+#endif
+
+extern volatile uint32_t mock_GPI;
+extern volatile uint32_t mock_GP16I;
+extern volatile bool mock_gpio_intr_enabled;
+
+#define GPI                         mock_GPI
+#define GP16I                       mock_GP16I
+#define ETS_GPIO_INTR_DISABLE()     (mock_gpio_intr_enabled = false)
+#define ETS_GPIO_INTR_ENABLE()      (mock_gpio_intr_enabled = true)
+
+typedef void (*voidFuncPtrArg)(void *);
+
+inline int digitalPinToInterrupt(int pin)
+{
+    return pin;
+}
+
+inline void pinMode(uint8_t, uint8_t)
+{
+}
+
+inline int digitalRead(uint8_t pin)
+{
+    return pin == 16 ? (mock_GP16I & 1) : ((mock_GPI >> pin) & 1);
+}
+
+// the interrupts are invoked by the tests
+void attachInterruptArg(uint8_t pin, voidFuncPtrArg callback, void *arg, int mode);
+void detachInterrupt(uint8_t pin);
+
+// misc
+
+inline String decbin(uint32_t value)
+{
+    String str;
+    for(int i = 31; i >= 0; i--) {
+        str += static_cast<char>('0' + ((value >> i) & 1));
+    }
+    return str;
+}
+
+#ifndef HTML_S
+#    define HTML_S(tag)             "<" #tag ">"
+#    define HTML_E(tag)             "</" #tag ">"
+#endif
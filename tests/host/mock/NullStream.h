@@ -0,0 +1,26 @@
+/**
+  Author: sascha_lammers@gmx.de
+*/
+
+#pragma once
+
+#include "Arduino_compat.h"
+
+class NullStream : public Stream {
+public:
+    virtual int available() override {
+        return 0;
+    }
+    virtual int read() override {
+        return -1;
+    }
+    virtual int peek() override {
+        return -1;
+    }
+    virtual size_t write(uint8_t) override {
+        return 1;
+    }
+    virtual size_t write(const uint8_t *, size_t len) override {
+        return len;
+    }
+};
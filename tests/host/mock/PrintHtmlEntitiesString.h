@@ -0,0 +1,12 @@
+/**
+  Author: sascha_lammers@gmx.de
+*/
+
+#pragma once
+
+#include "PrintString.h"
+
+class PrintHtmlEntitiesString : public PrintString {
+public:
+    using PrintString::PrintString;
+};
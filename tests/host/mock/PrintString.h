@@ -0,0 +1,33 @@
+/**
+  Author: sascha_lammers@gmx.de
+*/
+
+#pragma once
+
+#include "Arduino_compat.h"
+#include "misc.h"
+
+class PrintString : public String, public Print {
+public:
+    PrintString() {}
+    template<typename... Args>
+    PrintString(const __FlashStringHelper *format, Args... args) {
+        printf_P(reinterpret_cast<const char *>(format), args...);
+    }
+
+    using Print::write;
+    using Print::print;
+
+    size_t print(double value, uint8_t digits, bool trim) {
+        return printTrimmedDouble(this, value, digits);
+    }
+
+    virtual size_t write(uint8_t data) override {
+        push_back(data);
+        return 1;
+    }
+    virtual size_t write(const uint8_t *buffer, size_t len) override {
+        append(reinterpret_cast<const char *>(buffer), len);
+        return len;
+    }
+};
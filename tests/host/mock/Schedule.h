@@ -0,0 +1,11 @@
+/**
+  Author: sascha_lammers@gmx.de
+*/
+
+#pragma once
+
+#include <functional>
+
+// the queue holds 32 functions like the ESP8266 core
+bool schedule_function(const std::function<void(void)> &fn);
+void run_scheduled_functions();
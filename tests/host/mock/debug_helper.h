@@ -0,0 +1,7 @@
+/**
+  Author: sascha_lammers@gmx.de
+*/
+
+#pragma once
+
+#include "debug_helper_disable.h"
@@ -0,0 +1,29 @@
+/**
+  Author: sascha_lammers@gmx.de
+*/
+
+// debug output is disabled for host builds, __DBG_panic() and failed __DBG_assertf() abort
+
+#undef __LDBG_printf
+#undef __LDBG_print
+#undef __LDBG_assert
+#undef __LDBG_panic
+#undef __LDBG_IF
+#undef __DBG_printf
+#undef __DBG_print
+#undef __DBG_printf_E
+#undef __DBG_assertf
+#undef __DBG_panic
+#undef __SLDBG_printf
+
+#define __LDBG_printf(...)
+#define __LDBG_print(...)
+#define __LDBG_assert(...)
+#define __LDBG_panic(...)
+#define __LDBG_IF(...)
+#define __DBG_printf(...)
+#define __DBG_print(...)
+#define __DBG_printf_E(...)
+#define __DBG_assertf(cond, fmt, ...) ((cond) ? (void)0 : (fprintf(stderr, "assert(" #cond ") FAILED " fmt "\n", ##__VA_ARGS__), abort()))
+#define __DBG_panic(fmt, ...)       (fprintf(stderr, fmt "\n", ##__VA_ARGS__), abort())
+#define __SLDBG_printf(...)
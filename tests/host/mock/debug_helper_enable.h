@@ -0,0 +1,5 @@
+/**
+  Author: sascha_lammers@gmx.de
+*/
+
+#include "debug_helper_disable.h"
@@ -0,0 +1,10 @@
+/**
+  Author: sascha_lammers@gmx.de
+*/
+
+#pragma once
+
+#define Logger_error(...)
+#define Logger_notice(...)
+#define Logger_warning(...)
+#define Logger_security(...)
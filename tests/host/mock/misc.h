@@ -0,0 +1,34 @@
+/**
+  Author: sascha_lammers@gmx.de
+*/
+
+#pragma once
+
+#include "Arduino_compat.h"
+#include <type_traits>
+
+size_t printTrimmedDouble(Print *output, double value, int digits = 6);
+
+template <class T>
+void *lambda_target(T callback)
+{
+    return nullptr;
+}
+
+template <typename Ta, typename Tb>
+Ta get_time_since(Ta start, Tb end)
+{
+    return static_cast<Ta>(end) - start;
+}
+
+// the tests invoke the interrupt handlers from the main thread
+class InterruptLock {
+public:
+    InterruptLock() {}
+    ~InterruptLock() {}
+};
+
+inline uint64_t millis64()
+{
+    return mock_micros / 1000;
+}
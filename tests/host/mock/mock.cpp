@@ -0,0 +1,151 @@
+/**
+  Author: sascha_lammers@gmx.de
+*/
+
+#include "Arduino_compat.h"
+#include "misc.h"
+#include "Schedule.h"
+
+StdoutPrint Serial;
+String emptyString;
+
+size_t printTrimmedDouble(Print *output, double value, int digits)
+{
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.*f", digits, value);
+    if (strchr(buf, '.')) {
+        auto ptr = buf + strlen(buf) - 1;
+        while(*ptr == '0') {
+            *ptr-- = 0;
+        }
+        if (*ptr == '.') {
+            *ptr = 0;
+        }
+    }
+    return output ? output->print(buf) : strlen(buf);
+}
+
+// time
+
+uint64_t mock_micros = 1000000;
+
+// SDK timers
+
+static ETSTimer * const kTimerNotArmed = reinterpret_cast<ETSTimer *>(~static_cast<uintptr_t>(0));
+
+ETSTimer *timer_list = nullptr;
+
+static void unlinkTimer(ETSTimer *timer)
+{
+    for(auto ptr = &timer_list; *ptr; ptr = &(*ptr)->timer_next) {
+        if (*ptr == timer) {
+            *ptr = timer->timer_next;
+            break;
+        }
+    }
+    timer->timer_next = nullptr;
+}
+
+void ets_timer_setfn(ETSTimer *timer, ETSTimerFunc *callback, void *arg)
+{
+    timer->timer_func = callback;
+    timer->timer_arg = arg;
+}
+
+void ets_timer_disarm(ETSTimer *timer)
+{
+    unlinkTimer(timer);
+    timer->timer_period = 0;
+    timer->timer_next = kTimerNotArmed;
+}
+
+void ets_timer_done(ETSTimer *timer)
+{
+    unlinkTimer(timer);
+    timer->timer_next = kTimerNotArmed;
+    timer->timer_func = nullptr;
+}
+
+void ets_timer_arm_new(ETSTimer *timer, uint32_t time, bool repeat, bool isMillis)
+{
+    unlinkTimer(timer);
+    uint32_t micros = isMillis ? time * 1000 : time;
+    timer->timer_expire = static_cast<uint32_t>(mock_micros) + micros;
+    timer->timer_period = repeat ? micros : 0;
+    timer->timer_next = timer_list;
+    timer_list = timer;
+}
+
+void mock_advance(uint64_t micros)
+{
+    uint64_t end = mock_micros + micros;
+    for(;;) {
+        ETSTimer *next = nullptr;
+        for(auto timer = timer_list; timer; timer = timer->timer_next) {
+            if (!next || static_cast<int32_t>(timer->timer_expire - next->timer_expire) < 0) {
+                next = timer;
+            }
+        }
+        if (!next) {
+            break;
+        }
+        uint32_t delay = next->timer_expire - static_cast<uint32_t>(mock_micros);
+        if (mock_micros + delay > end) {
+            break;
+        }
+        mock_micros += delay;
+        unlinkTimer(next);
+        if (next->timer_period) {
+            next->timer_expire += next->timer_period;
+            next->timer_next = timer_list;
+            timer_list = next;
+        }
+        else {
+            next->timer_next = kTimerNotArmed;
+        }
+        next->timer_func(next->timer_arg);
+    }
+    mock_micros = end;
+}
+
+std::recursive_mutex &mock_intr_mutex()
+{
+    static std::recursive_mutex mutex;
+    return mutex;
+}
+
+// schedule_function()
+
+static std::vector<std::function<void(void)>> scheduledFunctions;
+
+bool schedule_function(const std::function<void(void)> &fn)
+{
+    if (scheduledFunctions.size() >= 32) {
+        return false;
+    }
+    scheduledFunctions.push_back(fn);
+    return true;
+}
+
+void run_scheduled_functions()
+{
+    auto functions = std::move(scheduledFunctions);
+    scheduledFunctions.clear();
+    for(auto &fn: functions) {
+        fn();
+    }
+}
+
+// GPIO
+
+volatile uint32_t mock_GPI;
+volatile uint32_t mock_GP16I;
+volatile bool mock_gpio_intr_enabled;
+
+void attachInterruptArg(uint8_t, voidFuncPtrArg, void *, int)
+{
+}
+
+void detachInterrupt(uint8_t)
+{
+}
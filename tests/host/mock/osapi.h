@@ -0,0 +1,45 @@
+/**
+  Author: sascha_lammers@gmx.de
+*/
+
+// ESP8266 SDK software timers driven by the simulated clock of Arduino_compat.h
+
+#pragma once
+
+#include <stdint.h>
+#include <mutex>
+
+typedef void ETSTimerFunc(void *arg);
+
+struct ETSTimer {
+    ETSTimer *timer_next;
+    uint32_t timer_expire;
+    uint32_t timer_period;
+    ETSTimerFunc *timer_func;
+    void *timer_arg;
+};
+
+typedef ETSTimer os_timer_t;
+
+extern "C" ETSTimer *timer_list;
+
+void ets_timer_setfn(ETSTimer *timer, ETSTimerFunc *callback, void *arg);
+void ets_timer_arm_new(ETSTimer *timer, uint32_t time, bool repeat, bool isMillis);
+void ets_timer_disarm(ETSTimer *timer);
+void ets_timer_done(ETSTimer *timer);
+
+// interrupts are emulated with a mutex to allow threads acting as interrupt or timer context
+std::recursive_mutex &mock_intr_mutex();
+
+inline void ets_intr_lock()
+{
+    mock_intr_mutex().lock();
+}
+
+inline void ets_intr_unlock()
+{
+    mock_intr_mutex().unlock();
+}
+
+// advance the simulated clock and invoke the expired timers
+void mock_advance(uint64_t micros);